@@ -121,3 +121,18 @@ void ReadCPUInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
 
 	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
 }
+
+void ReadCPUFrequency(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("cpu frequency information is not supported on this platform")));
+}
+
+void ReadCPUIdleStates(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("cpu idle state information is not supported on this platform")));
+}
+
+void ReadCPUTopology(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("cpu topology information is not supported on this platform")));
+}
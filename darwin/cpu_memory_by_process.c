@@ -143,7 +143,7 @@ void CreateCPUMemoryList(int sample)
 	free(org_proc_addr);
 }
 
-void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc)
+void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc, bool include_smaps)
 {
 	Datum      values[Natts_cpu_memory_info_by_process];
 	bool       nulls[Natts_cpu_memory_info_by_process];
@@ -260,6 +260,26 @@ void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc)
 
 		nulls[Anum_process_running_since] = true;
 
+		/*
+		 * smaps_rollup memory, page tables, IO delays, fault and IO rates and
+		 * the character and system call IO counters are not available on this platform
+		 */
+		nulls[Anum_process_pss_bytes] = true;
+		nulls[Anum_process_uss_bytes] = true;
+		nulls[Anum_process_shared_bytes] = true;
+		nulls[Anum_process_anon_bytes] = true;
+		nulls[Anum_process_page_table_bytes] = true;
+		nulls[Anum_process_io_wait_seconds] = true;
+		nulls[Anum_process_io_wait_percent] = true;
+		nulls[Anum_process_minor_faults_per_sec] = true;
+		nulls[Anum_process_major_faults_per_sec] = true;
+		nulls[Anum_process_io_read_bytes_per_sec] = true;
+		nulls[Anum_process_io_write_bytes_per_sec] = true;
+		nulls[Anum_process_rchar] = true;
+		nulls[Anum_process_wchar] = true;
+		nulls[Anum_process_syscr] = true;
+		nulls[Anum_process_syscw] = true;
+
 		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
 
 		//reset the value again
@@ -281,3 +301,8 @@ void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc)
 	prev = NULL;
 	iter = NULL;
 }
+
+void ReadCPUSchedulingByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("process scheduling information is not supported on this platform")));
+}
@@ -191,3 +191,15 @@ void ReadIOAnalysisInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
 
 	IOObjectRelease (disk_list_iter);
 }
+
+/* Tablespace to block device mapping is only supported on Linux */
+void ReadTablespaceIOInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("tablespace IO information is not supported on this platform")));
+}
+
+/* IO queue depth sampling is only supported on Linux */
+void ReadIOQueueDepthInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("io queue depth information is not supported on this platform")));
+}
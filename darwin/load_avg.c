@@ -43,3 +43,18 @@ void ReadLoadAvgInformations(Tuplestorestate *tupstore, TupleDesc tupdesc)
 
 	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
 }
+
+void ReadPressureInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("pressure stall information is not supported on this platform")));
+}
+
+void ReadPressureEvents(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("pressure stall trigger events are not supported on this platform")));
+}
+
+void ReadRunqueueInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("run queue sampling is not supported on this platform")));
+}
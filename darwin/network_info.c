@@ -185,3 +185,8 @@ void ReadNetworkInformations(Tuplestorestate *tupstore, TupleDesc tupdesc)
 	freeifaddrs(ifaddr);
 	free(buf);
 }
+
+void ReadSoftnetStat(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("softnet information is not supported on this platform")));
+}
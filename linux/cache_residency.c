@@ -0,0 +1,448 @@
+/*------------------------------------------------------------------------
+ * cache_residency.c
+ *              Page cache residency of relation files
+ *
+ * On Linux 6.5 and later the cachestat() system call returns the cached,
+ * dirty, writeback and recently evicted pages of a whole file in one call.
+ * On older kernels the file is mapped and mincore() tells which pages are
+ * resident; mapping a file does not read it, but dirty and writeback pages
+ * are unknown then.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "catalog/pg_class.h"
+#include "catalog/pg_tablespace_d.h"
+#include "common/relpath.h"
+#include "miscadmin.h"
+#include "storage/fd.h"
+#include "storage/lmgr.h"
+#include "utils/lsyscache.h"
+#if PG_VERSION_NUM >= 160000
+#include "utils/relfilenumbermap.h"
+#define RelidByRelfilenode(spc, relfilenode)	RelidByRelfilenumber(spc, relfilenode)
+#else
+#include "utils/relfilenodemap.h"
+#endif
+
+/* cachestat() is the same system call on every architecture */
+#ifndef __NR_cachestat
+#define __NR_cachestat              451
+#endif
+
+/* Layout of struct cachestat_range and struct cachestat of <linux/mman.h> */
+typedef struct cachestat_range_args
+{
+	uint64 off;
+	uint64 len;
+} cachestat_range_args;
+
+typedef struct cachestat_result
+{
+	uint64 nr_cache;
+	uint64 nr_dirty;
+	uint64 nr_writeback;
+	uint64 nr_evicted;
+	uint64 nr_recently_evicted;
+} cachestat_result;
+
+/* page cache usage of one or more files */
+typedef struct file_residency
+{
+	uint64 size_bytes;
+	uint64 cached_pages;
+	uint64 dirty_pages;
+	uint64 writeback_pages;
+	uint64 recently_evicted_pages;
+	bool   used_mincore;        /* dirty, writeback and evicted pages unknown */
+} file_residency;
+
+/* residency of the files of one relfilenode, for the database ranking */
+typedef struct relfile_residency
+{
+	Oid            tablespace;
+	Oid            relfilenode;
+	file_residency residency;
+} relfile_residency;
+
+/* set once cachestat() turned out not to exist in this kernel */
+static bool cachestat_unsupported = false;
+
+void ReadRelationCacheResidency(Tuplestorestate *tupstore, TupleDesc tupdesc, Oid relid);
+void ReadDatabaseCacheResidency(Tuplestorestate *tupstore, TupleDesc tupdesc, int max_relations);
+static bool FileCacheResidency(int fd, uint64 size, file_residency *res);
+static bool ForkCacheResidency(const char *fork_path, int *segments, file_residency *res);
+static void ReadDirectoryResidency(const char *path, Oid tablespace, relfile_residency **files,
+		int *num_files, int *max_files);
+static void PutResidencyValues(Datum *values, bool *nulls, file_residency *res,
+		int anum_cached_bytes);
+static int CompareRelfile(const void *a, const void *b);
+static int CompareCachedBytes(const void *a, const void *b);
+
+/* Add the page cache usage of an open file to the totals */
+static bool FileCacheResidency(int fd, uint64 size, file_residency *res)
+{
+	long           page_size = sysconf(_SC_PAGESIZE);
+	void           *addr;
+	unsigned char  *vec;
+	uint64         pages;
+	uint64         index;
+
+	res->size_bytes += size;
+	if (size == 0)
+		return true;
+
+	if (!cachestat_unsupported)
+	{
+		cachestat_range_args range = {0, 0};    /* a length of 0 means up to the end */
+		cachestat_result     cs;
+
+		if (syscall(__NR_cachestat, fd, &range, &cs, 0) == 0)
+		{
+			res->cached_pages += cs.nr_cache;
+			res->dirty_pages += cs.nr_dirty;
+			res->writeback_pages += cs.nr_writeback;
+			res->recently_evicted_pages += cs.nr_recently_evicted;
+			return true;
+		}
+
+		if (errno == ENOSYS)
+			cachestat_unsupported = true;
+	}
+
+	/* Fall back to mincore(), also for filesystems without cachestat() */
+	addr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (addr == MAP_FAILED)
+		return false;
+
+	pages = (size + page_size - 1) / page_size;
+	vec = palloc(pages);
+	if (mincore(addr, size, vec) != 0)
+	{
+		pfree(vec);
+		munmap(addr, size);
+		return false;
+	}
+
+	for (index = 0; index < pages; index++)
+		res->cached_pages += vec[index] & 1;
+	res->used_mincore = true;
+
+	pfree(vec);
+	munmap(addr, size);
+
+	return true;
+}
+
+/*
+ * Walk the segment files of one fork.  Returns false if the fork does not
+ * exist.
+ */
+static bool ForkCacheResidency(const char *fork_path, int *segments, file_residency *res)
+{
+	char        segment_path[MAXPGPATH];
+	struct stat st;
+	int         segment;
+	int         fd;
+
+	memset(res, 0, sizeof(file_residency));
+	*segments = 0;
+
+	for (segment = 0;; segment++)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		if (segment == 0)
+			snprintf(segment_path, MAXPGPATH, "%s", fork_path);
+		else
+			snprintf(segment_path, MAXPGPATH, "%s.%d", fork_path, segment);
+
+		fd = OpenTransientFile(segment_path, O_RDONLY | PG_BINARY);
+		if (fd < 0)
+		{
+			if (errno != ENOENT)
+				ereport(DEBUG1,
+						(errcode_for_file_access(),
+							errmsg("could not open file \"%s\": %m", segment_path)));
+			break;
+		}
+
+		if (fstat(fd, &st) != 0 || !FileCacheResidency(fd, st.st_size, res))
+			ereport(DEBUG1,
+					(errmsg("could not read page cache residency of file \"%s\": %m",
+						segment_path)));
+		(*segments)++;
+
+		CloseTransientFile(fd);
+	}
+
+	return *segments > 0;
+}
+
+/*
+ * Fill the cached_bytes, dirty_bytes, writeback_bytes and cached_percent
+ * columns, which follow each other in both functions
+ */
+static void PutResidencyValues(Datum *values, bool *nulls, file_residency *res,
+		int anum_cached_bytes)
+{
+	long page_size = sysconf(_SC_PAGESIZE);
+
+	values[anum_cached_bytes] = UInt64GetDatum(res->cached_pages * page_size);
+
+	if (res->used_mincore)
+	{
+		nulls[anum_cached_bytes + 1] = true;
+		nulls[anum_cached_bytes + 2] = true;
+	}
+	else
+	{
+		values[anum_cached_bytes + 1] = UInt64GetDatum(res->dirty_pages * page_size);
+		values[anum_cached_bytes + 2] = UInt64GetDatum(res->writeback_pages * page_size);
+	}
+
+	/* The last page of a file is cached whole, cap at 100 percent */
+	if (res->size_bytes > 0)
+		values[anum_cached_bytes + 3] =
+			Float8GetDatum(Min((float8) res->cached_pages * page_size * 100 / res->size_bytes, 100.0));
+	else
+		nulls[anum_cached_bytes + 3] = true;
+}
+
+void ReadRelationCacheResidency(Tuplestorestate *tupstore, TupleDesc tupdesc, Oid relid)
+{
+	Datum          values[Natts_relation_cache_residency];
+	bool           nulls[Natts_relation_cache_residency];
+	char           relkind;
+	char           *rel_path;
+	char           fork_path[MAXPGPATH];
+	file_residency res;
+	int            segments;
+	ForkNumber     forknum;
+	long           page_size = sysconf(_SC_PAGESIZE);
+
+	/* Keep the relation from being dropped or rewritten while it is walked */
+	LockRelationOid(relid, AccessShareLock);
+
+	relkind = get_rel_relkind(relid);
+	if (relkind != RELKIND_RELATION && relkind != RELKIND_INDEX &&
+		relkind != RELKIND_SEQUENCE && relkind != RELKIND_TOASTVALUE &&
+		relkind != RELKIND_MATVIEW)
+	{
+		ereport(DEBUG1,
+				(errmsg("relation with OID %u has no storage", relid)));
+		return;
+	}
+
+	/* Path of the main fork relative to the data directory */
+	rel_path = text_to_cstring(DatumGetTextPP(DirectFunctionCall1(pg_relation_filepath,
+													ObjectIdGetDatum(relid))));
+
+	for (forknum = MAIN_FORKNUM; forknum <= MAX_FORKNUM; forknum++)
+	{
+		memset(nulls, 0, sizeof(nulls));
+
+		if (forknum == MAIN_FORKNUM)
+			snprintf(fork_path, MAXPGPATH, "%s", rel_path);
+		else
+			snprintf(fork_path, MAXPGPATH, "%s_%s", rel_path, forkNames[forknum]);
+
+		if (!ForkCacheResidency(fork_path, &segments, &res))
+			continue;
+
+		values[Anum_residency_fork_name] = CStringGetTextDatum(forkNames[forknum]);
+		values[Anum_residency_segments] = Int32GetDatum(segments);
+		values[Anum_residency_size_bytes] = UInt64GetDatum(res.size_bytes);
+		PutResidencyValues(values, nulls, &res, Anum_residency_cached_bytes);
+
+		if (res.used_mincore)
+			nulls[Anum_residency_recently_evicted_bytes] = true;
+		else
+			values[Anum_residency_recently_evicted_bytes] =
+				UInt64GetDatum(res.recently_evicted_pages * page_size);
+		values[Anum_residency_method] = CStringGetTextDatum(res.used_mincore ? "mincore" : "cachestat");
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	pfree(rel_path);
+}
+
+/*
+ * Add the residency of every relation file in a database directory.  Files
+ * are named <relfilenode>[_<fork>][.<segment>]; temporary relations
+ * (t<backend>_<relfilenode>) are skipped.  The directory and the files are
+ * allocated through fd.c so that they are released when a cancel interrupts
+ * the walk.
+ */
+static void ReadDirectoryResidency(const char *path, Oid tablespace, relfile_residency **files,
+		int *num_files, int *max_files)
+{
+	DIR           *dirp;
+	struct dirent *ent;
+	char          file_path[MAXPGPATH];
+	struct stat   st;
+	int           fd;
+
+	dirp = AllocateDir(path);
+	if (!dirp)
+		return;
+
+	while ((ent = ReadDirExtended(dirp, path, DEBUG1)) != NULL)
+	{
+		relfile_residency *file;
+
+		if (!isdigit((unsigned char) ent->d_name[0]))
+			continue;
+
+		CHECK_FOR_INTERRUPTS();
+
+		snprintf(file_path, MAXPGPATH, "%s/%s", path, ent->d_name);
+		fd = OpenTransientFile(file_path, O_RDONLY | PG_BINARY);
+		if (fd < 0)
+			continue;
+
+		if (*num_files >= *max_files)
+		{
+			*max_files *= 2;
+			*files = repalloc(*files, *max_files * sizeof(relfile_residency));
+		}
+
+		file = &(*files)[*num_files];
+		memset(file, 0, sizeof(relfile_residency));
+		file->tablespace = tablespace;
+		file->relfilenode = (Oid) strtoul(ent->d_name, NULL, 10);
+
+		if (fstat(fd, &st) == 0 && FileCacheResidency(fd, st.st_size, &file->residency))
+			(*num_files)++;
+
+		CloseTransientFile(fd);
+	}
+
+	FreeDir(dirp);
+}
+
+static int CompareRelfile(const void *a, const void *b)
+{
+	const relfile_residency *ra = (const relfile_residency *) a;
+	const relfile_residency *rb = (const relfile_residency *) b;
+
+	if (ra->tablespace != rb->tablespace)
+		return (ra->tablespace > rb->tablespace) - (ra->tablespace < rb->tablespace);
+	return (ra->relfilenode > rb->relfilenode) - (ra->relfilenode < rb->relfilenode);
+}
+
+static int CompareCachedBytes(const void *a, const void *b)
+{
+	uint64 ca = ((const relfile_residency *) a)->residency.cached_pages;
+	uint64 cb = ((const relfile_residency *) b)->residency.cached_pages;
+
+	return (ca < cb) - (ca > cb);
+}
+
+/*
+ * Rank the relations of the current database by the bytes they have in the
+ * page cache.  The files of the database are walked directly, so relations
+ * are neither locked nor opened; files are mapped back to relations through
+ * the relfilenode map and the relation is NULL for files whose relation
+ * can not be found, like those of a relation dropped meanwhile.
+ */
+void ReadDatabaseCacheResidency(Tuplestorestate *tupstore, TupleDesc tupdesc, int max_relations)
+{
+	Datum             values[Natts_database_cache_residency];
+	bool              nulls[Natts_database_cache_residency];
+	relfile_residency *files;
+	int               num_files = 0;
+	int               max_files = 1024;
+	int               num_relfiles = 0;
+	char              path[MAXPGPATH];
+	DIR               *dirp;
+	struct dirent     *ent;
+	int               index;
+
+	files = palloc(max_files * sizeof(relfile_residency));
+
+	/*
+	 * Relations in the default tablespace of the database have a
+	 * reltablespace of 0 in pg_class.
+	 */
+	snprintf(path, MAXPGPATH, "base/%u", MyDatabaseId);
+	ReadDirectoryResidency(path,
+						   MyDatabaseTableSpace == DEFAULTTABLESPACE_OID ? InvalidOid : DEFAULTTABLESPACE_OID,
+						   &files, &num_files, &max_files);
+
+	dirp = AllocateDir("pg_tblspc");
+	if (dirp)
+	{
+		while ((ent = ReadDirExtended(dirp, "pg_tblspc", DEBUG1)) != NULL)
+		{
+			Oid tablespace;
+
+			if (!stringIsNumber(ent->d_name))
+				continue;
+
+			tablespace = (Oid) strtoul(ent->d_name, NULL, 10);
+			snprintf(path, MAXPGPATH, "pg_tblspc/%s/%s/%u", ent->d_name,
+					 TABLESPACE_VERSION_DIRECTORY, MyDatabaseId);
+			ReadDirectoryResidency(path, tablespace == MyDatabaseTableSpace ? InvalidOid : tablespace,
+								   &files, &num_files, &max_files);
+		}
+
+		FreeDir(dirp);
+	}
+
+	/* Merge the forks and segments of each relfilenode */
+	qsort(files, num_files, sizeof(relfile_residency), CompareRelfile);
+	for (index = 0; index < num_files; index++)
+	{
+		if (num_relfiles > 0 && CompareRelfile(&files[num_relfiles - 1], &files[index]) == 0)
+		{
+			relfile_residency *last = &files[num_relfiles - 1];
+
+			last->residency.size_bytes += files[index].residency.size_bytes;
+			last->residency.cached_pages += files[index].residency.cached_pages;
+			last->residency.dirty_pages += files[index].residency.dirty_pages;
+			last->residency.writeback_pages += files[index].residency.writeback_pages;
+			last->residency.used_mincore |= files[index].residency.used_mincore;
+		}
+		else
+			files[num_relfiles++] = files[index];
+	}
+
+	qsort(files, num_relfiles, sizeof(relfile_residency), CompareCachedBytes);
+
+	for (index = 0; index < num_relfiles && index < max_relations; index++)
+	{
+		relfile_residency *file = &files[index];
+		Oid               relid;
+
+		memset(nulls, 0, sizeof(nulls));
+
+		relid = RelidByRelfilenode(file->tablespace, file->relfilenode);
+		if (OidIsValid(relid))
+			values[Anum_db_residency_relation] = ObjectIdGetDatum(relid);
+		else
+			nulls[Anum_db_residency_relation] = true;
+
+		values[Anum_db_residency_relfilenode] = ObjectIdGetDatum(file->relfilenode);
+		values[Anum_db_residency_size_bytes] = UInt64GetDatum(file->residency.size_bytes);
+		PutResidencyValues(values, nulls, &file->residency, Anum_db_residency_cached_bytes);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	pfree(files);
+}
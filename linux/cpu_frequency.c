@@ -0,0 +1,129 @@
+/*------------------------------------------------------------------------
+ * cpu_frequency.c
+ *              CPU frequency scaling and thermal throttling information
+ *
+ * The "cpu MHz" of /proc/cpuinfo is a single instantaneous value.  cpufreq
+ * exposes per CPU the current frequency, the limits the governor scales
+ * within and the energy/performance bias, and on x86 the thermal_throttle
+ * counters tell how often the core or its package was throttled because
+ * it ran too hot.  Throttling rates are computed since the previous call.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#define CPU_SETTING_LEN             64
+
+static CounterBaseline cpu_frequency_baseline;
+
+void ReadCPUFrequency(Tuplestorestate *tupstore, TupleDesc tupdesc);
+static bool ReadCPUSetting(int cpu, const char *name, char *buf);
+static void PutFrequency(int cpu, const char *name, Datum *values, bool *nulls, int attnum);
+static void PutThrottleCount(int cpu, const char *name, Datum *values, bool *nulls,
+		int count_attnum, int rate_attnum);
+
+/* Read a file of /sys/devices/system/cpu/cpu<n> */
+static bool ReadCPUSetting(int cpu, const char *name, char *buf)
+{
+	char file_name[MAXPGPATH];
+
+	snprintf(file_name, MAXPGPATH, "%s/cpu%d/%s", CPU_SYSFS_DIR, cpu, name);
+	return ReadFileLine(file_name, buf, CPU_SETTING_LEN);
+}
+
+/* cpufreq reports frequencies in kHz */
+static void PutFrequency(int cpu, const char *name, Datum *values, bool *nulls, int attnum)
+{
+	char setting[CPU_SETTING_LEN];
+
+	if (ReadCPUSetting(cpu, name, setting))
+		values[attnum] = Int64GetDatum(strtoll(setting, NULL, 10) * 1000);
+	else
+		nulls[attnum] = true;
+}
+
+static void PutThrottleCount(int cpu, const char *name, Datum *values, bool *nulls,
+		int count_attnum, int rate_attnum)
+{
+	char   setting[CPU_SETTING_LEN];
+	char   key[COUNTER_BASELINE_KEY_LEN];
+	uint64 count;
+	float8 rate;
+
+	if (!ReadCPUSetting(cpu, name, setting))
+	{
+		nulls[count_attnum] = true;
+		nulls[rate_attnum] = true;
+		return;
+	}
+
+	count = strtoull(setting, NULL, 10);
+	values[count_attnum] = UInt64GetDatum(count);
+
+	snprintf(key, COUNTER_BASELINE_KEY_LEN, "cpu%d/%s", cpu, name);
+	if (counter_baseline_rate(&cpu_frequency_baseline, key, count, &rate))
+		values[rate_attnum] = Float8GetDatum(rate);
+	else
+		nulls[rate_attnum] = true;
+}
+
+void ReadCPUFrequency(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum  values[Natts_cpu_frequency];
+	bool   nulls[Natts_cpu_frequency];
+	char   setting[CPU_SETTING_LEN];
+	int    *cpus;
+	int    num_cpus;
+	int    index;
+
+	cpus = ListSysfsCPUs(&num_cpus);
+	if (num_cpus == 0)
+		return;
+
+	counter_baseline_begin(&cpu_frequency_baseline);
+
+	for (index = 0; index < num_cpus; index++)
+	{
+		int cpu = cpus[index];
+
+		memset(nulls, 0, sizeof(nulls));
+
+		values[Anum_freq_cpu] = Int32GetDatum(cpu);
+
+		if (ReadCPUSetting(cpu, "cpufreq/scaling_driver", setting))
+			values[Anum_freq_scaling_driver] = CStringGetTextDatum(setting);
+		else
+			nulls[Anum_freq_scaling_driver] = true;
+
+		if (ReadCPUSetting(cpu, "cpufreq/scaling_governor", setting))
+			values[Anum_freq_governor] = CStringGetTextDatum(setting);
+		else
+			nulls[Anum_freq_governor] = true;
+
+		/* Only intel_pstate and amd-pstate in active mode have it */
+		if (ReadCPUSetting(cpu, "cpufreq/energy_performance_preference", setting))
+			values[Anum_freq_energy_performance_preference] = CStringGetTextDatum(setting);
+		else
+			nulls[Anum_freq_energy_performance_preference] = true;
+
+		PutFrequency(cpu, "cpufreq/scaling_cur_freq", values, nulls, Anum_freq_current_hz);
+		PutFrequency(cpu, "cpufreq/scaling_min_freq", values, nulls, Anum_freq_min_hz);
+		PutFrequency(cpu, "cpufreq/scaling_max_freq", values, nulls, Anum_freq_max_hz);
+		PutFrequency(cpu, "cpufreq/cpuinfo_max_freq", values, nulls, Anum_freq_hardware_max_hz);
+
+		PutThrottleCount(cpu, "thermal_throttle/core_throttle_count", values, nulls,
+						 Anum_freq_core_throttle_count, Anum_freq_core_throttle_per_sec);
+		PutThrottleCount(cpu, "thermal_throttle/package_throttle_count", values, nulls,
+						 Anum_freq_package_throttle_count, Anum_freq_package_throttle_per_sec);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	counter_baseline_end(&cpu_frequency_baseline);
+
+	pfree(cpus);
+}
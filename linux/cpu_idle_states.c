@@ -0,0 +1,131 @@
+/*------------------------------------------------------------------------
+ * cpu_idle_states.c
+ *              CPU idle state (C-state) residency
+ *
+ * An idle CPU enters one of the idle states of its cpuidle driver, deeper
+ * states saving more power but taking longer to exit.  A core dropping into
+ * a deep state between two queries adds its exit latency to the next one.
+ * For each CPU and state, the number of entries and the time spent in it
+ * since the previous call show where the cores actually idle.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#define IDLE_STATE_SETTING_LEN      64
+#define MAX_IDLE_STATES             32
+
+static CounterBaseline cpu_idle_baseline;
+
+void ReadCPUIdleStates(Tuplestorestate *tupstore, TupleDesc tupdesc);
+static bool ReadIdleStateSetting(int cpu, int state, const char *name, char *buf);
+
+/* Read a file of /sys/devices/system/cpu/cpu<n>/cpuidle/state<m> */
+static bool ReadIdleStateSetting(int cpu, int state, const char *name, char *buf)
+{
+	char file_name[MAXPGPATH];
+
+	snprintf(file_name, MAXPGPATH, "%s/cpu%d/cpuidle/state%d/%s", CPU_SYSFS_DIR, cpu,
+			 state, name);
+	return ReadFileLine(file_name, buf, IDLE_STATE_SETTING_LEN);
+}
+
+void ReadCPUIdleStates(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum  values[Natts_cpu_idle_states];
+	bool   nulls[Natts_cpu_idle_states];
+	char   setting[IDLE_STATE_SETTING_LEN];
+	char   key[COUNTER_BASELINE_KEY_LEN];
+	int    *cpus;
+	int    num_cpus;
+	int    index;
+	float8 rate;
+
+	cpus = ListSysfsCPUs(&num_cpus);
+	if (num_cpus == 0)
+		return;
+
+	counter_baseline_begin(&cpu_idle_baseline);
+
+	for (index = 0; index < num_cpus; index++)
+	{
+		int cpu = cpus[index];
+		int state;
+
+		/* States are numbered from 0, the shallowest, without gaps */
+		for (state = 0; state < MAX_IDLE_STATES; state++)
+		{
+			uint64 usage;
+			uint64 time_us;
+
+			if (!ReadIdleStateSetting(cpu, state, "name", setting))
+				break;
+
+			memset(nulls, 0, sizeof(nulls));
+
+			values[Anum_cstate_cpu] = Int32GetDatum(cpu);
+			values[Anum_cstate_state] = Int32GetDatum(state);
+			values[Anum_cstate_name] = CStringGetTextDatum(setting);
+
+			if (ReadIdleStateSetting(cpu, state, "latency", setting))
+				values[Anum_cstate_exit_latency_us] = Int64GetDatum(strtoll(setting, NULL, 10));
+			else
+				nulls[Anum_cstate_exit_latency_us] = true;
+
+			if (ReadIdleStateSetting(cpu, state, "residency", setting))
+				values[Anum_cstate_target_residency_us] = Int64GetDatum(strtoll(setting, NULL, 10));
+			else
+				nulls[Anum_cstate_target_residency_us] = true;
+
+			if (ReadIdleStateSetting(cpu, state, "disable", setting))
+				values[Anum_cstate_disabled] = BoolGetDatum(strtol(setting, NULL, 10) != 0);
+			else
+				nulls[Anum_cstate_disabled] = true;
+
+			if (ReadIdleStateSetting(cpu, state, "usage", setting))
+			{
+				usage = strtoull(setting, NULL, 10);
+				values[Anum_cstate_usage] = UInt64GetDatum(usage);
+
+				snprintf(key, COUNTER_BASELINE_KEY_LEN, "cpu%d/state%d/usage", cpu, state);
+				if (counter_baseline_rate(&cpu_idle_baseline, key, usage, &rate))
+					values[Anum_cstate_usage_per_sec] = Float8GetDatum(rate);
+				else
+					nulls[Anum_cstate_usage_per_sec] = true;
+			}
+			else
+			{
+				nulls[Anum_cstate_usage] = true;
+				nulls[Anum_cstate_usage_per_sec] = true;
+			}
+
+			/* Microseconds in the state per second, as a percentage of wall time */
+			if (ReadIdleStateSetting(cpu, state, "time", setting))
+			{
+				time_us = strtoull(setting, NULL, 10);
+				values[Anum_cstate_time_us] = UInt64GetDatum(time_us);
+
+				snprintf(key, COUNTER_BASELINE_KEY_LEN, "cpu%d/state%d/time", cpu, state);
+				if (counter_baseline_rate(&cpu_idle_baseline, key, time_us, &rate))
+					values[Anum_cstate_time_percent] = Float8GetDatum(Min(rate / 10000, 100.0));
+				else
+					nulls[Anum_cstate_time_percent] = true;
+			}
+			else
+			{
+				nulls[Anum_cstate_time_us] = true;
+				nulls[Anum_cstate_time_percent] = true;
+			}
+
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+
+	counter_baseline_end(&cpu_idle_baseline);
+
+	pfree(cpus);
+}
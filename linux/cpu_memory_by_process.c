@@ -17,12 +17,26 @@
 #include <ctype.h>
 #include <sys/sysinfo.h>
 
+#include "utils/timestamp.h"
+
 #define READ_PROCESS_CPU_USAGE_FIRST_SAMPLE     1
 #define READ_PROCESS_CPU_USAGE_SECOND_SAMPLE    2
 
 static long long unsigned int total_cpu_usage_1 = 0;
 static long long unsigned int total_cpu_usage_2 = 0;
 
+/* structure used to store the counters of /proc/<pid>/io */
+typedef struct process_io
+{
+	long long unsigned int rchar;
+	long long unsigned int wchar;
+	long long unsigned int syscr;
+	long long unsigned int syscw;
+	long long unsigned int read_bytes;
+	long long unsigned int write_bytes;
+	bool                   has_chars;
+} process_io_t;
+
 /* structure used to store the data for each process */
 typedef struct node
 {
@@ -34,10 +48,29 @@ typedef struct node
 	char name[MAXPGPATH];
 	unsigned long long     vsize;
 	long long unsigned int swap_bytes;
-	long long unsigned int io_read_bytes;
-	long long unsigned int io_write_bytes;
+	long long unsigned int minor_faults_1;
+	long long unsigned int minor_faults_2;
+	long long unsigned int major_faults_1;
+	long long unsigned int major_faults_2;
+	process_io_t           io_1;
+	process_io_t           io_2;
+	long long unsigned int page_table_bytes;
+	long long unsigned int pss_bytes;
+	long long unsigned int uss_bytes;
+	long long unsigned int shared_bytes;
+	long long unsigned int anon_bytes;
+	long long unsigned int voluntary_ctxt_switches;
+	long long unsigned int involuntary_ctxt_switches;
+	long long unsigned int blkio_ticks_1;
+	long long unsigned int blkio_ticks_2;
 	bool                   has_swap;
+	bool                   has_page_tables;
 	bool                   has_io;
+	bool                   has_io_2;
+	bool                   has_sample_2;
+	bool                   has_smaps;
+	bool                   has_ctxt_switches;
+	bool                   has_blkio;
 	struct node * next;
 } node_t;
 
@@ -51,16 +84,34 @@ int ReadTotalProcessors(void);
 uint64 ReadTotalPhysicalMemory(void);
 /* Function used to read total cpu usage for each process */
 uint64 ReadTotalCPUUsage(void);
+/* Function used to check whether the kernel accounts block IO delays */
+static bool TaskDelayAccountingEnabled(void);
 /* Function used to read total memory usage for each process */
-void ReadCPUMemoryUsage(int sample);
-/* Function used to read swap usage from /proc/<pid>/status */
-static bool ReadProcessSwap(int pid, long long unsigned int *swap_bytes);
+void ReadCPUMemoryUsage(int sample, bool include_smaps);
+/* Function used to read the /proc/<pid>/stat line and split off the comm */
+static bool ReadProcessStatLine(const char *pid_name, char *stat_line, size_t size,
+		int *pid, char *process_name, char **after_comm);
+/* Function used to find a numbered field of the /proc/<pid>/stat line */
+static char *ProcessStatField(char *after_comm, int field);
+/* Function used to read swap and page table usage from /proc/<pid>/status */
+static void ReadProcessStatus(int pid, node_t *proc, bool ctxt_switches);
+/* Function used to read the migrations of a process from /proc/<pid>/sched */
+static bool ReadProcessMigrations(int pid, uint64 *migrations);
+/* Function used to read proportional memory from /proc/<pid>/smaps_rollup */
+static bool ReadProcessSmaps(int pid, node_t *proc);
 /* Function used to read IO stats from /proc/<pid>/io */
-static bool ReadProcessIO(int pid,
-		long long unsigned int *read_bytes,
-		long long unsigned int *write_bytes);
+static bool ReadProcessIO(int pid, process_io_t *io);
+/* Function used to put the rate of a counter over the sample window */
+static void PutSampleRate(long long unsigned int value_1, long long unsigned int value_2,
+		bool has_value_2, float8 window_secs, Datum *values, bool *nulls, int attnum);
+/* Function used to put a counter of a process and its rate */
+static void PutProcessCounter(const char *key_prefix, const char *name, uint64 value,
+		Datum *values, bool *nulls, int count_attnum, int rate_attnum);
+
+void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc, bool include_smaps);
+void ReadCPUSchedulingByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc);
 
-void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc);
+static CounterBaseline process_sched_baseline;
 
 /* Read the total number of processors of the system */
 int ReadTotalProcessors()
@@ -182,14 +233,15 @@ uint64 ReadTotalCPUUsage()
 
 /* Read CPU and memory informations all processes and store in
  * linked list for further processing */
-void ReadCPUMemoryUsage(int sample)
+void ReadCPUMemoryUsage(int sample, bool include_smaps)
 {
-	FILE *fpstat;
 	struct dirent *ent;
-	char  file_name[MAXPGPATH];
 	unsigned long utime_ticks, stime_ticks;
+	long long unsigned int minor_faults, major_faults;
 	char process_name[MAXPGPATH + 1] = {0};
 	char stat_line[4096];
+	char *after_comm;
+	char *blkio_field;
 	int pid = 0;
 	long unsigned int mem_rss = 0;
 	unsigned long long vsize = 0;
@@ -219,108 +271,39 @@ void ReadCPUMemoryUsage(int sample)
 
 	while ((ent = readdir(dirp)) != NULL)
 	{
-		memset(file_name, 0x00, MAXPGPATH);
-
 		if (!isdigit(*ent->d_name))
 			continue;
 
-		snprintf(file_name, MAXPGPATH, "/proc/%s/stat", ent->d_name);
-
-		fpstat = fopen(file_name, "r");
-		if (fpstat == NULL)
+		if (!ReadProcessStatLine(ent->d_name, stat_line, sizeof(stat_line),
+								 &pid, process_name, &after_comm))
 			continue;
 
-		/*
-		 * Parse /proc/<pid>/stat robustly. The comm field (field 2)
-		 * is wrapped in parentheses and may contain spaces or even
-		 * ')' chars.  The kernel guarantees the first '(' and last
-		 * ')' in the line delimit comm, so we locate those markers
-		 * and sscanf the numeric fields after ')'.
-		 */
-		if (fgets(stat_line, sizeof(stat_line), fpstat) == NULL)
-		{
-			fclose(fpstat);
-			continue;
-		}
-
-		/* Detect truncated lines (no newline and buffer full) */
-		if (strchr(stat_line, '\n') == NULL &&
-			strlen(stat_line) == sizeof(stat_line) - 1)
+		/* Parse numeric fields after ") " */
+		if (sscanf(after_comm,
+				   " %*c %*d %*d %*d %*d %*d %*u"
+				   " %llu %*u %llu %*u"
+				   " %lu %lu"
+				   " %*d %*d %*d %*d %*d %*d"
+				   " %llu %llu %lu",
+				   &minor_faults, &major_faults,
+				   &utime_ticks, &stime_ticks,
+				   &process_up_since, &vsize,
+				   &mem_rss) != 7)
 		{
 			ereport(DEBUG1,
-				(errmsg("Truncated /proc/%s/stat line",
-						ent->d_name)));
-			fclose(fpstat);
+				(errmsg("Error parsing fields in"
+						" '/proc/%d/stat'", pid)));
 			continue;
 		}
 
-		{
-			char *open_paren;
-			char *close_paren;
-			char *after_comm;
-			size_t name_len;
-
-			open_paren = strchr(stat_line, '(');
-			close_paren = strrchr(stat_line, ')');
-			if (open_paren == NULL || close_paren == NULL ||
-				close_paren <= open_paren)
-			{
-				ereport(DEBUG1,
-					(errmsg("Malformed /proc/%s/stat:"
-							" missing comm delimiters",
-							ent->d_name)));
-				fclose(fpstat);
-				continue;
-			}
-
-			/* Extract pid from before '(' */
-			if (sscanf(stat_line, "%d", &pid) != 1)
-			{
-				ereport(DEBUG1,
-					(errmsg("Could not parse PID from"
-							" /proc/%s/stat",
-							ent->d_name)));
-				fclose(fpstat);
-				continue;
-			}
-
-			/* Extract comm from between '(' and last ')' */
-			open_paren++;  /* skip '(' */
-			name_len = close_paren - open_paren;
-			if (name_len >= MAXPGPATH)
-				name_len = MAXPGPATH - 1;
-			if (name_len > 0)
-				memcpy(process_name, open_paren, name_len);
-			process_name[name_len] = '\0';
-
-			/* Parse numeric fields after ") " */
-			after_comm = close_paren + 1;
-			if (sscanf(after_comm,
-					   " %*c %*d %*d %*d %*d %*d %*u"
-					   " %*u %*u %*u %*u"
-					   " %lu %lu"
-					   " %*d %*d %*d %*d %*d %*d"
-					   " %llu %llu %lu",
-					   &utime_ticks, &stime_ticks,
-					   &process_up_since, &vsize,
-					   &mem_rss) != 5)
-			{
-				ereport(DEBUG1,
-					(errmsg("Error parsing fields in"
-							" '/proc/%d/stat'", pid)));
-				fclose(fpstat);
-				continue;
-			}
-		}
+		/* delayacct_blkio_ticks, field 42, is the time spent waiting on block IO */
+		blkio_field = ProcessStatField(after_comm, 42);
 
 		if (sample == READ_PROCESS_CPU_USAGE_FIRST_SAMPLE)
 		{
 			iter = (node_t *) malloc(sizeof(node_t));
 			if (iter == NULL)
-			{
-				fclose(fpstat);
 				continue;
-			}
 			/* Zero-initialize so process_cpu_sample_2 is 0
 			 * for processes that disappear between samples */
 			memset(iter, 0, sizeof(node_t));
@@ -329,14 +312,21 @@ void ReadCPUMemoryUsage(int sample)
 			strncpy(iter->name, process_name, MAXPGPATH);
 			iter->name[MAXPGPATH - 1] = '\0';
 			iter->process_cpu_sample_1 = utime_ticks + stime_ticks;
+			iter->minor_faults_1 = minor_faults;
+			iter->major_faults_1 = major_faults;
 			iter->rss_memory = mem_rss;
 			iter->vsize = vsize;
 			process_up_since = (unsigned long long)((unsigned long long)sys_uptime - (process_up_since/HZ));
 			iter->process_up_since_seconds = process_up_since;
-			iter->has_swap = ReadProcessSwap(pid, &iter->swap_bytes);
-			iter->has_io = ReadProcessIO(pid,
-					&iter->io_read_bytes,
-					&iter->io_write_bytes);
+			if (blkio_field != NULL)
+			{
+				iter->blkio_ticks_1 = strtoull(blkio_field, NULL, 10);
+				iter->has_blkio = true;
+			}
+			ReadProcessStatus(pid, iter, false);
+			if (include_smaps)
+				iter->has_smaps = ReadProcessSmaps(pid, iter);
+			iter->has_io = ReadProcessIO(pid, &iter->io_1);
 			iter->next = NULL;
 			if (head == NULL)
 				head = iter;
@@ -352,67 +342,285 @@ void ReadCPUMemoryUsage(int sample)
 				if (current->pid == atoi(ent->d_name))
 				{
 					current->process_cpu_sample_2 = utime_ticks + stime_ticks;
+					current->minor_faults_2 = minor_faults;
+					current->major_faults_2 = major_faults;
+					current->has_sample_2 = true;
+					if (current->has_io)
+						current->has_io_2 = ReadProcessIO(pid, &current->io_2);
+					if (blkio_field != NULL)
+						current->blkio_ticks_2 = strtoull(blkio_field, NULL, 10);
 					break;
 				}
 				else
 					current = current->next;
 			}
 		}
+	}
+
+	closedir(dirp);
+}
+
+/*
+ * Since Linux 5.14 the block IO delays are only accounted while the
+ * kernel.task_delayacct sysctl is on, otherwise they stay at zero.  Older
+ * kernels have no sysctl and account them unless booted with nodelayacct.
+ */
+static bool TaskDelayAccountingEnabled(void)
+{
+	char setting[8];
+
+	if (!ReadFileLine("/proc/sys/kernel/task_delayacct", setting, sizeof(setting)))
+		return true;
+
+	return atoi(setting) != 0;
+}
+
+/*
+ * Read the /proc/<pid>/stat line of a process.  The comm field (field 2)
+ * is wrapped in parentheses and may contain spaces or even ')' chars.  The
+ * kernel guarantees the first '(' and last ')' in the line delimit comm, so
+ * we locate those markers; the numeric fields follow the last ')'.
+ */
+static bool ReadProcessStatLine(const char *pid_name, char *stat_line, size_t size,
+		int *pid, char *process_name, char **after_comm)
+{
+	FILE   *fpstat;
+	char   file_name[MAXPGPATH];
+	char   *open_paren;
+	char   *close_paren;
+	size_t name_len;
+
+	snprintf(file_name, MAXPGPATH, "/proc/%s/stat", pid_name);
 
+	fpstat = fopen(file_name, "r");
+	if (fpstat == NULL)
+		return false;
+
+	if (fgets(stat_line, size, fpstat) == NULL)
+	{
 		fclose(fpstat);
-		fpstat = NULL;
+		return false;
 	}
 
-	closedir(dirp);
+	fclose(fpstat);
+
+	/* Detect truncated lines (no newline and buffer full) */
+	if (strchr(stat_line, '\n') == NULL &&
+		strlen(stat_line) == size - 1)
+	{
+		ereport(DEBUG1,
+			(errmsg("Truncated /proc/%s/stat line",
+					pid_name)));
+		return false;
+	}
+
+	open_paren = strchr(stat_line, '(');
+	close_paren = strrchr(stat_line, ')');
+	if (open_paren == NULL || close_paren == NULL ||
+		close_paren <= open_paren)
+	{
+		ereport(DEBUG1,
+			(errmsg("Malformed /proc/%s/stat:"
+					" missing comm delimiters",
+					pid_name)));
+		return false;
+	}
+
+	/* Extract pid from before '(' */
+	if (sscanf(stat_line, "%d", pid) != 1)
+	{
+		ereport(DEBUG1,
+			(errmsg("Could not parse PID from"
+					" /proc/%s/stat",
+					pid_name)));
+		return false;
+	}
+
+	/* Extract comm from between '(' and last ')' */
+	open_paren++;  /* skip '(' */
+	name_len = close_paren - open_paren;
+	if (name_len >= MAXPGPATH)
+		name_len = MAXPGPATH - 1;
+	if (name_len > 0)
+		memcpy(process_name, open_paren, name_len);
+	process_name[name_len] = '\0';
+
+	*after_comm = close_paren + 1;
+	return true;
 }
 
-/* Read swap usage from /proc/<pid>/status */
-static bool ReadProcessSwap(int pid, long long unsigned int *swap_bytes)
+/*
+ * Start of a field of the stat line, numbered as in proc(5): field 3, the
+ * state, is the first one after the comm.  Returns NULL if the line is
+ * shorter, as on kernels older than the field.
+ */
+static char *ProcessStatField(char *after_comm, int field)
+{
+	char *pos = after_comm;
+	int  current;
+
+	for (current = 3; ; current++)
+	{
+		while (*pos == ' ')
+			pos++;
+		if (*pos == '\0' || *pos == '\n')
+			return NULL;
+		if (current == field)
+			return pos;
+		while (*pos != ' ' && *pos != '\0')
+			pos++;
+	}
+}
+
+/*
+ * Read swap and page table usage from /proc/<pid>/status, and on request
+ * the context switches of its main thread, which come last in the file.
+ */
+static void ReadProcessStatus(int pid, node_t *proc, bool ctxt_switches)
 {
 	FILE       *fp;
 	char       file_name[MAXPGPATH];
 	char       *line_buf = NULL;
 	size_t     line_buf_size = 0;
 	ssize_t    line_size;
-	bool       found = false;
+	bool       has_voluntary = false;
 
 	snprintf(file_name, MAXPGPATH, "/proc/%d/status", pid);
 	fp = fopen(file_name, "r");
 	if (!fp)
-		return false;
+		return;
 
 	line_size = getline(&line_buf, &line_buf_size, fp);
 	while (line_size >= 0)
 	{
-		if (strstr(line_buf, "VmSwap:") != NULL)
+		long long unsigned int val = 0;
+
+		/* values are in kB, convert to bytes */
+		if (sscanf(line_buf, "VmPTE: %llu", &val) == 1)
 		{
-			long long unsigned int val = 0;
-			if (sscanf(line_buf, "VmSwap: %llu", &val) == 1)
-			{
-				*swap_bytes = val * 1024; /* convert kB to bytes */
-				found = true;
-			}
-			break;
+			proc->page_table_bytes = val * 1024;
+			proc->has_page_tables = true;
+		}
+		else if (sscanf(line_buf, "VmSwap: %llu", &val) == 1)
+		{
+			proc->swap_bytes = val * 1024;
+			proc->has_swap = true;
+		}
+		else if (sscanf(line_buf, "voluntary_ctxt_switches: %llu", &val) == 1)
+		{
+			proc->voluntary_ctxt_switches = val;
+			has_voluntary = true;
+		}
+		else if (sscanf(line_buf, "nonvoluntary_ctxt_switches: %llu", &val) == 1)
+		{
+			proc->involuntary_ctxt_switches = val;
+			proc->has_ctxt_switches = has_voluntary;
 		}
 
+		/* VmSwap follows VmPTE, and the context switches follow both */
+		if (ctxt_switches ? proc->has_ctxt_switches : proc->has_swap)
+			break;
+
 		line_size = getline(&line_buf, &line_buf_size, fp);
 	}
 
+	free(line_buf);
+	fclose(fp);
+}
+
+/* se.nr_migrations of /proc/<pid>/sched, which needs CONFIG_SCHED_DEBUG */
+static bool ReadProcessMigrations(int pid, uint64 *migrations)
+{
+	FILE       *fp;
+	char       file_name[MAXPGPATH];
+	char       *line_buf = NULL;
+	size_t     line_buf_size = 0;
+	unsigned long long val;
+	bool       found = false;
+
+	snprintf(file_name, MAXPGPATH, "/proc/%d/sched", pid);
+	fp = fopen(file_name, "r");
+	if (!fp)
+		return false;
+
+	while (getline(&line_buf, &line_buf_size, fp) >= 0)
+	{
+		if (sscanf(line_buf, "se.nr_migrations : %llu", &val) == 1)
+		{
+			*migrations = val;
+			found = true;
+			break;
+		}
+	}
+
 	free(line_buf);
 	fclose(fp);
 	return found;
 }
 
-/* Read IO stats from /proc/<pid>/io */
-static bool ReadProcessIO(int pid,
-		long long unsigned int *read_bytes,
-		long long unsigned int *write_bytes)
+/*
+ * Read the memory of a process from /proc/<pid>/smaps_rollup.  Unlike RSS,
+ * PSS divides every shared page among the processes mapping it, so the PSS
+ * of all backends adds up to the memory they really use.  USS is the memory
+ * only this process maps, which is what would be freed if it exited.
+ * smaps_rollup walks the page tables of the process, which makes it much
+ * costlier than stat.
+ */
+static bool ReadProcessSmaps(int pid, node_t *proc)
+{
+	FILE       *fp;
+	char       file_name[MAXPGPATH];
+	char       *line_buf = NULL;
+	size_t     line_buf_size = 0;
+	char       key[64];
+	long long unsigned int val;
+	bool       found = false;
+
+	snprintf(file_name, MAXPGPATH, "/proc/%d/smaps_rollup", pid);
+	fp = fopen(file_name, "r");
+	if (!fp)
+		return false;
+
+	while (getline(&line_buf, &line_buf_size, fp) >= 0)
+	{
+		if (sscanf(line_buf, "%63[^:]: %llu", key, &val) != 2)
+			continue;
+
+		/* values are in kB, convert to bytes */
+		if (strcmp(key, "Pss") == 0)
+		{
+			proc->pss_bytes = val * 1024;
+			found = true;
+		}
+		else if (strcmp(key, "Private_Clean") == 0 ||
+				 strcmp(key, "Private_Dirty") == 0)
+			proc->uss_bytes += val * 1024;
+		else if (strcmp(key, "Shared_Clean") == 0 ||
+				 strcmp(key, "Shared_Dirty") == 0)
+			proc->shared_bytes += val * 1024;
+		else if (strcmp(key, "Anonymous") == 0)
+			proc->anon_bytes = val * 1024;
+	}
+
+	free(line_buf);
+	fclose(fp);
+	return found;
+}
+
+/*
+ * Read IO stats from /proc/<pid>/io.  The characters and system calls
+ * count all reads and writes, including those served from the page cache
+ * and those on pipes and sockets; read_bytes and write_bytes only count
+ * what reached the storage layer.
+ */
+static bool ReadProcessIO(int pid, process_io_t *io)
 {
 	FILE       *fp;
 	char       file_name[MAXPGPATH];
 	char       *line_buf = NULL;
 	size_t     line_buf_size = 0;
 	ssize_t    line_size;
+	int        found_chars = 0;
 	bool       found_read = false;
 	bool       found_write = false;
 
@@ -424,20 +632,19 @@ static bool ReadProcessIO(int pid,
 	line_size = getline(&line_buf, &line_buf_size, fp);
 	while (line_size >= 0)
 	{
-		if (strstr(line_buf, "read_bytes:") != NULL &&
-			strstr(line_buf, "cancelled") == NULL)
-		{
-			if (sscanf(line_buf, "read_bytes: %llu", read_bytes) == 1)
-				found_read = true;
-		}
-		else if (strstr(line_buf, "write_bytes:") != NULL &&
-			strstr(line_buf, "cancelled") == NULL)
-		{
-			if (sscanf(line_buf, "write_bytes: %llu", write_bytes) == 1)
-				found_write = true;
-		}
-
-		if (found_read && found_write)
+		if (sscanf(line_buf, "rchar: %llu", &io->rchar) == 1 ||
+			sscanf(line_buf, "wchar: %llu", &io->wchar) == 1 ||
+			sscanf(line_buf, "syscr: %llu", &io->syscr) == 1 ||
+			sscanf(line_buf, "syscw: %llu", &io->syscw) == 1)
+			found_chars++;
+		else if (sscanf(line_buf, "read_bytes: %llu", &io->read_bytes) == 1)
+			found_read = true;
+		/* cancelled_write_bytes does not match, the prefix must come first */
+		else if (sscanf(line_buf, "write_bytes: %llu", &io->write_bytes) == 1)
+			found_write = true;
+
+		/* write_bytes comes after the others */
+		if (found_write)
 			break;
 
 		line_size = getline(&line_buf, &line_buf_size, fp);
@@ -445,10 +652,22 @@ static bool ReadProcessIO(int pid,
 
 	free(line_buf);
 	fclose(fp);
+
+	io->has_chars = (found_chars == 4);
 	return (found_read && found_write);
 }
 
-void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc)
+/* Put the rate per second of a counter sampled at both ends of the window */
+static void PutSampleRate(long long unsigned int value_1, long long unsigned int value_2,
+		bool has_value_2, float8 window_secs, Datum *values, bool *nulls, int attnum)
+{
+	if (has_value_2 && value_2 >= value_1 && window_secs > 0)
+		values[attnum] = Float8GetDatum((float8) (value_2 - value_1) / window_secs);
+	else
+		nulls[attnum] = true;
+}
+
+void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc, bool include_smaps)
 {
 	Datum      values[Natts_cpu_memory_info_by_process];
 	bool       nulls[Natts_cpu_memory_info_by_process];
@@ -457,6 +676,12 @@ void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc)
 	int        no_processor = 0;
 	float4     cpu_usage = 0.0;
 	float4     memory_usage = 0.0;
+	float4     io_wait_usage = 0.0;
+	long       clock_ticks;
+	bool       delay_accounting;
+	TimestampTz sample_time_1;
+	TimestampTz sample_time_2;
+	float8     window_secs;
 	long page_size_bytes = 0;
 	long long unsigned int     total_memory;
 	long long unsigned int     rss_memory;
@@ -470,13 +695,23 @@ void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc)
 	no_processor =  ReadTotalProcessors();
 	total_memory = ReadTotalPhysicalMemory();
 	total_cpu_usage_1 = ReadTotalCPUUsage();
+	sample_time_1 = GetCurrentTimestamp();
 	/* Read the first sample for cpu and memory usage by each process */
-	ReadCPUMemoryUsage(READ_PROCESS_CPU_USAGE_FIRST_SAMPLE);
+	ReadCPUMemoryUsage(READ_PROCESS_CPU_USAGE_FIRST_SAMPLE, include_smaps);
 	pg_usleep(100000);
 	CHECK_FOR_INTERRUPTS();
 	/* Read the second sample for cpu and memory usage by each process */
 	total_cpu_usage_2 = ReadTotalCPUUsage();
-	ReadCPUMemoryUsage(READ_PROCESS_CPU_USAGE_SECOND_SAMPLE);
+	sample_time_2 = GetCurrentTimestamp();
+	ReadCPUMemoryUsage(READ_PROCESS_CPU_USAGE_SECOND_SAMPLE, include_smaps);
+
+	/* Fault and IO rates are per second of the window between the samples */
+	window_secs = (float8) (sample_time_2 - sample_time_1) / USECS_PER_SEC;
+
+	delay_accounting = TaskDelayAccountingEnabled();
+	clock_ticks = sysconf(_SC_CLK_TCK);
+	if (clock_ticks <= 0)
+		clock_ticks = 100;
 
 	page_size_bytes = sysconf(_SC_PAGESIZE);
 	if (page_size_bytes <= 0)
@@ -533,18 +768,111 @@ void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc)
 		else
 			nulls[Anum_process_swap_usage_bytes] = true;
 
-		/* IO read/write bytes */
+		/* IO read/write bytes, from the latest sample of the process */
 		if (current->has_io)
 		{
+			process_io_t *io = current->has_io_2 ? &current->io_2 : &current->io_1;
+
 			values[Anum_process_io_read_bytes] =
-				UInt64GetDatum((uint64)(current->io_read_bytes));
+				UInt64GetDatum((uint64)(io->read_bytes));
 			values[Anum_process_io_write_bytes] =
-				UInt64GetDatum((uint64)(current->io_write_bytes));
+				UInt64GetDatum((uint64)(io->write_bytes));
+
+			PutSampleRate(current->io_1.read_bytes, current->io_2.read_bytes,
+						  current->has_io_2, window_secs, values, nulls,
+						  Anum_process_io_read_bytes_per_sec);
+			PutSampleRate(current->io_1.write_bytes, current->io_2.write_bytes,
+						  current->has_io_2, window_secs, values, nulls,
+						  Anum_process_io_write_bytes_per_sec);
+
+			if (io->has_chars)
+			{
+				values[Anum_process_rchar] = UInt64GetDatum((uint64)(io->rchar));
+				values[Anum_process_wchar] = UInt64GetDatum((uint64)(io->wchar));
+				values[Anum_process_syscr] = UInt64GetDatum((uint64)(io->syscr));
+				values[Anum_process_syscw] = UInt64GetDatum((uint64)(io->syscw));
+			}
+			else
+			{
+				nulls[Anum_process_rchar] = true;
+				nulls[Anum_process_wchar] = true;
+				nulls[Anum_process_syscr] = true;
+				nulls[Anum_process_syscw] = true;
+			}
 		}
 		else
 		{
 			nulls[Anum_process_io_read_bytes] = true;
 			nulls[Anum_process_io_write_bytes] = true;
+			nulls[Anum_process_io_read_bytes_per_sec] = true;
+			nulls[Anum_process_io_write_bytes_per_sec] = true;
+			nulls[Anum_process_rchar] = true;
+			nulls[Anum_process_wchar] = true;
+			nulls[Anum_process_syscr] = true;
+			nulls[Anum_process_syscw] = true;
+		}
+
+		/* page faults per second, NULL if the process exited between the samples */
+		PutSampleRate(current->minor_faults_1, current->minor_faults_2,
+					  current->has_sample_2, window_secs, values, nulls,
+					  Anum_process_minor_faults_per_sec);
+		PutSampleRate(current->major_faults_1, current->major_faults_2,
+					  current->has_sample_2, window_secs, values, nulls,
+					  Anum_process_major_faults_per_sec);
+
+		/* page table bytes */
+		if (current->has_page_tables)
+			values[Anum_process_page_table_bytes] =
+				UInt64GetDatum((uint64)(current->page_table_bytes));
+		else
+			nulls[Anum_process_page_table_bytes] = true;
+
+		/*
+		 * Time spent waiting on block IO, and its share of the sample window,
+		 * which is measured in clock ticks like the CPU usage above
+		 */
+		if (current->has_blkio && delay_accounting)
+		{
+			long long unsigned int blkio_ticks =
+				Max(current->blkio_ticks_1, current->blkio_ticks_2);
+
+			if (current->blkio_ticks_2 < current->blkio_ticks_1 ||
+				total_cpu_usage_2 <= total_cpu_usage_1)
+				io_wait_usage = 0.0;
+			else
+				io_wait_usage = (float)no_processor *
+					(float)(current->blkio_ticks_2 - current->blkio_ticks_1) *
+					100.0f / (float)(total_cpu_usage_2 - total_cpu_usage_1);
+
+			values[Anum_process_io_wait_seconds] =
+				Float8GetDatum((float8) blkio_ticks / clock_ticks);
+			values[Anum_process_io_wait_percent] =
+				Float4GetDatum(fl_round(Min(io_wait_usage, 100.0f)));
+		}
+		else
+		{
+			nulls[Anum_process_io_wait_seconds] = true;
+			nulls[Anum_process_io_wait_percent] = true;
+		}
+
+		/* proportional and unique memory, only read on request */
+		if (current->has_smaps)
+		{
+			values[Anum_process_pss_bytes] =
+				UInt64GetDatum((uint64)(current->pss_bytes));
+			values[Anum_process_uss_bytes] =
+				UInt64GetDatum((uint64)(current->uss_bytes));
+			values[Anum_process_shared_bytes] =
+				UInt64GetDatum((uint64)(current->shared_bytes));
+			values[Anum_process_anon_bytes] =
+				UInt64GetDatum((uint64)(current->anon_bytes));
+		}
+		else
+		{
+			nulls[Anum_process_pss_bytes] = true;
+			nulls[Anum_process_uss_bytes] = true;
+			nulls[Anum_process_shared_bytes] = true;
+			nulls[Anum_process_anon_bytes] = true;
 		}
 
 		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
@@ -554,11 +882,27 @@ void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc)
 		process_pid = 0;
 		cpu_usage = 0.0;
 		memory_usage = 0.0;
+		io_wait_usage = 0.0;
 		running_since = 0;
 		rss_memory = 0;
 		nulls[Anum_process_swap_usage_bytes] = false;
 		nulls[Anum_process_io_read_bytes] = false;
 		nulls[Anum_process_io_write_bytes] = false;
+		nulls[Anum_process_pss_bytes] = false;
+		nulls[Anum_process_uss_bytes] = false;
+		nulls[Anum_process_shared_bytes] = false;
+		nulls[Anum_process_anon_bytes] = false;
+		nulls[Anum_process_page_table_bytes] = false;
+		nulls[Anum_process_io_wait_seconds] = false;
+		nulls[Anum_process_io_wait_percent] = false;
+		nulls[Anum_process_minor_faults_per_sec] = false;
+		nulls[Anum_process_major_faults_per_sec] = false;
+		nulls[Anum_process_io_read_bytes_per_sec] = false;
+		nulls[Anum_process_io_write_bytes_per_sec] = false;
+		nulls[Anum_process_rchar] = false;
+		nulls[Anum_process_wchar] = false;
+		nulls[Anum_process_syscr] = false;
+		nulls[Anum_process_syscw] = false;
 
 		del_iter = current;
 		current = current->next;
@@ -573,3 +917,152 @@ void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc)
 	prev = NULL;
 	iter = NULL;
 }
+
+/* Put a cumulative counter of a process and its rate since the previous call */
+static void PutProcessCounter(const char *key_prefix, const char *name, uint64 value,
+		Datum *values, bool *nulls, int count_attnum, int rate_attnum)
+{
+	char   key[COUNTER_BASELINE_KEY_LEN];
+	float8 rate;
+
+	values[count_attnum] = UInt64GetDatum(value);
+
+	snprintf(key, COUNTER_BASELINE_KEY_LEN, "%s/%s", key_prefix, name);
+	if (counter_baseline_rate(&process_sched_baseline, key, value, &rate))
+		values[rate_attnum] = Float8GetDatum(rate);
+	else
+		nulls[rate_attnum] = true;
+}
+
+/*
+ * Scheduling of every process: the time its main thread ran and waited on
+ * a run queue for a CPU, from /proc/<pid>/schedstat, the CPU it last ran
+ * on, its context switches and its migrations between CPUs.  Rates are
+ * since the previous call in the session; the baseline is keyed by pid and
+ * start time so that a reused pid does not yield a bogus rate.
+ */
+void ReadCPUSchedulingByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum         values[Natts_cpu_sched_by_process];
+	bool          nulls[Natts_cpu_sched_by_process];
+	struct dirent *ent;
+	DIR           *dirp;
+	char          process_name[MAXPGPATH + 1] = {0};
+	char          stat_line[4096];
+	char          file_name[MAXPGPATH];
+	char          key_prefix[COUNTER_BASELINE_KEY_LEN];
+	char          key[COUNTER_BASELINE_KEY_LEN];
+	char          *after_comm;
+	char          *field;
+	int           pid;
+
+	dirp = opendir(PROC_FILE_SYSTEM_PATH);
+	if (!dirp)
+	{
+		ereport(DEBUG1, (errmsg("Error opening /proc directory")));
+		return;
+	}
+
+	counter_baseline_begin(&process_sched_baseline);
+
+	while ((ent = readdir(dirp)) != NULL)
+	{
+		FILE                   *fp;
+		node_t                 proc;
+		unsigned long long     run_ns;
+		unsigned long long     wait_ns;
+		unsigned long long     timeslices;
+		uint64                 migrations;
+		float8                 rate;
+
+		if (!isdigit(*ent->d_name))
+			continue;
+
+		if (!ReadProcessStatLine(ent->d_name, stat_line, sizeof(stat_line),
+								 &pid, process_name, &after_comm))
+			continue;
+
+		memset(nulls, 0, sizeof(nulls));
+
+		values[Anum_sched_pid] = Int32GetDatum(pid);
+		values[Anum_sched_name] = CStringGetTextDatum(process_name);
+
+		/* starttime, field 22, tells a reused pid apart */
+		field = ProcessStatField(after_comm, 22);
+		snprintf(key_prefix, COUNTER_BASELINE_KEY_LEN, "%d.%llu", pid,
+				 field != NULL ? strtoull(field, NULL, 10) : 0);
+
+		field = ProcessStatField(after_comm, 39);
+		if (field != NULL)
+			values[Anum_sched_processor] = Int32GetDatum(atoi(field));
+		else
+			nulls[Anum_sched_processor] = true;
+
+		snprintf(file_name, MAXPGPATH, "/proc/%d/schedstat", pid);
+		fp = fopen(file_name, "r");
+		if (fp != NULL && fscanf(fp, "%llu %llu %llu", &run_ns, &wait_ns, &timeslices) == 3)
+		{
+			values[Anum_sched_run_time_ns] = UInt64GetDatum(run_ns);
+			snprintf(key, COUNTER_BASELINE_KEY_LEN, "%s/run", key_prefix);
+			if (counter_baseline_rate(&process_sched_baseline, key, run_ns, &rate))
+				values[Anum_sched_run_time_percent] = Float8GetDatum(Min(rate / 10000000, 100.0));
+			else
+				nulls[Anum_sched_run_time_percent] = true;
+
+			values[Anum_sched_wait_time_ns] = UInt64GetDatum(wait_ns);
+			snprintf(key, COUNTER_BASELINE_KEY_LEN, "%s/wait", key_prefix);
+			if (counter_baseline_rate(&process_sched_baseline, key, wait_ns, &rate))
+				values[Anum_sched_wait_time_percent] = Float8GetDatum(Min(rate / 10000000, 100.0));
+			else
+				nulls[Anum_sched_wait_time_percent] = true;
+
+			PutProcessCounter(key_prefix, "timeslices", timeslices, values, nulls,
+							  Anum_sched_timeslices, Anum_sched_timeslices_per_sec);
+		}
+		else
+		{
+			nulls[Anum_sched_run_time_ns] = true;
+			nulls[Anum_sched_run_time_percent] = true;
+			nulls[Anum_sched_wait_time_ns] = true;
+			nulls[Anum_sched_wait_time_percent] = true;
+			nulls[Anum_sched_timeslices] = true;
+			nulls[Anum_sched_timeslices_per_sec] = true;
+		}
+		if (fp != NULL)
+			fclose(fp);
+
+		memset(&proc, 0, sizeof(node_t));
+		ReadProcessStatus(pid, &proc, true);
+		if (proc.has_ctxt_switches)
+		{
+			PutProcessCounter(key_prefix, "voluntary", proc.voluntary_ctxt_switches,
+							  values, nulls, Anum_sched_voluntary_ctxt_switches,
+							  Anum_sched_voluntary_ctxt_switches_per_sec);
+			PutProcessCounter(key_prefix, "involuntary", proc.involuntary_ctxt_switches,
+							  values, nulls, Anum_sched_involuntary_ctxt_switches,
+							  Anum_sched_involuntary_ctxt_switches_per_sec);
+		}
+		else
+		{
+			nulls[Anum_sched_voluntary_ctxt_switches] = true;
+			nulls[Anum_sched_voluntary_ctxt_switches_per_sec] = true;
+			nulls[Anum_sched_involuntary_ctxt_switches] = true;
+			nulls[Anum_sched_involuntary_ctxt_switches_per_sec] = true;
+		}
+
+		if (ReadProcessMigrations(pid, &migrations))
+			PutProcessCounter(key_prefix, "migrations", migrations, values, nulls,
+							  Anum_sched_migrations, Anum_sched_migrations_per_sec);
+		else
+		{
+			nulls[Anum_sched_migrations] = true;
+			nulls[Anum_sched_migrations_per_sec] = true;
+		}
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	counter_baseline_end(&process_sched_baseline);
+
+	closedir(dirp);
+}
@@ -0,0 +1,487 @@
+/*------------------------------------------------------------------------
+ * cpu_topology.c
+ *              Model of the CPU topology and cache hierarchy
+ *
+ * The sockets, dies, cores and SMT siblings of every CPU, its NUMA node and
+ * the caches it shares with other CPUs only change when CPUs are hotplugged.
+ * The model is built from sysfs once, when the shared memory is created,
+ * and rebuilt by the background sampler when the set of online CPUs
+ * changes, so that the functions using it do no IO at all.  Without
+ * shared_preload_libraries every backend builds its own copy on first use.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#include <dirent.h>
+#include <sys/utsname.h>
+
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/memutils.h"
+#include "utils/timestamp.h"
+
+#define CPU_ONLINE_FILE_NAME        CPU_SYSFS_DIR "/online"
+#define CPU_TOPOLOGY_CHECK_MS       1000
+#define CPU_SETTING_LEN             64
+
+typedef struct CPUTopologyState
+{
+	LWLock      *lock;
+	CPUTopology topology;
+} CPUTopologyState;
+
+static CPUTopologyState *cpu_topology_state = NULL;
+
+/* copy of the sampler, or of a backend when the extension is not preloaded */
+static CPUTopology *local_topology = NULL;
+static TimestampTz last_topology_check = 0;
+
+void ReadCPUTopology(Tuplestorestate *tupstore, TupleDesc tupdesc);
+static void BuildCPUTopology(CPUTopology *topology);
+static void ReadCPUIdentity(CPUTopology *topology);
+static int ReadCPUInt(int cpu, const char *name, int default_value);
+static int ReadCPUNode(int cpu);
+static void ReadCPUCaches(CPUTopology *topology, CPUTopologyCPU *entry);
+static void CountCPUs(CPUTopology *topology);
+static bool ReadOnlineCPUs(char *online_cpus);
+
+Size CPUTopologyShmemSize(void)
+{
+	return MAXALIGN(sizeof(CPUTopologyState));
+}
+
+void CPUTopologyShmemInit(void)
+{
+	bool found;
+
+	cpu_topology_state = ShmemInitStruct("system_stats cpu topology",
+										 CPUTopologyShmemSize(), &found);
+	if (!found)
+	{
+		memset(cpu_topology_state, 0, CPUTopologyShmemSize());
+		cpu_topology_state->lock =
+			&(GetNamedLWLockTranche(SYSTEM_STATS_LWLOCK_TRANCHE))[SAMPLER_LOCK_CPU_TOPOLOGY].lock;
+		BuildCPUTopology(&cpu_topology_state->topology);
+	}
+}
+
+/* Read a numeric file of /sys/devices/system/cpu/cpu<n> */
+static int ReadCPUInt(int cpu, const char *name, int default_value)
+{
+	char file_name[MAXPGPATH];
+	char setting[CPU_SETTING_LEN];
+
+	snprintf(file_name, MAXPGPATH, "%s/cpu%d/%s", CPU_SYSFS_DIR, cpu, name);
+	if (!ReadFileLine(file_name, setting, CPU_SETTING_LEN))
+		return default_value;
+
+	return atoi(setting);
+}
+
+/* The NUMA node of a CPU is linked as a node<n> entry of its directory */
+static int ReadCPUNode(int cpu)
+{
+	DIR           *dirp;
+	struct dirent *ent;
+	char          dir_name[MAXPGPATH];
+	int           node = -1;
+
+	snprintf(dir_name, MAXPGPATH, "%s/cpu%d", CPU_SYSFS_DIR, cpu);
+	dirp = opendir(dir_name);
+	if (!dirp)
+		return -1;
+
+	while ((ent = readdir(dirp)) != NULL)
+	{
+		if (strncmp(ent->d_name, "node", 4) == 0 && ent->d_name[4] != '\0' &&
+			stringIsNumber(ent->d_name + 4))
+		{
+			node = atoi(ent->d_name + 4);
+			break;
+		}
+	}
+
+	closedir(dirp);
+
+	return node;
+}
+
+/*
+ * Add the caches of a CPU.  A cache shared by several CPUs is listed by
+ * each of them, and kept once, identified by its level, type and the CPUs
+ * sharing it.
+ */
+static void ReadCPUCaches(CPUTopology *topology, CPUTopologyCPU *entry)
+{
+	int index;
+
+	entry->num_caches = 0;
+
+	for (index = 0; entry->num_caches < CPU_TOPOLOGY_MAX_CPU_CACHES; index++)
+	{
+		CPUTopologyCache cache;
+		char             file_name[MAXPGPATH];
+		char             name[CPU_SETTING_LEN];
+		int              other;
+
+		memset(&cache, 0, sizeof(cache));
+
+		snprintf(name, CPU_SETTING_LEN, "cache/index%d/level", index);
+		cache.level = ReadCPUInt(entry->cpu, name, -1);
+		if (cache.level < 0)
+			break;
+
+		snprintf(file_name, MAXPGPATH, "%s/cpu%d/cache/index%d/type", CPU_SYSFS_DIR,
+				 entry->cpu, index);
+		if (!ReadFileLine(file_name, cache.type, sizeof(cache.type)))
+			continue;
+
+		snprintf(file_name, MAXPGPATH, "%s/cpu%d/cache/index%d/shared_cpu_list",
+				 CPU_SYSFS_DIR, entry->cpu, index);
+		if (!ReadFileLine(file_name, cache.shared_cpus, CPU_TOPOLOGY_LIST_LEN))
+			snprintf(cache.shared_cpus, CPU_TOPOLOGY_LIST_LEN, "%d", entry->cpu);
+
+		for (other = 0; other < topology->num_caches; other++)
+		{
+			CPUTopologyCache *known = &topology->caches[other];
+
+			if (known->level == cache.level && strcmp(known->type, cache.type) == 0 &&
+				strcmp(known->shared_cpus, cache.shared_cpus) == 0)
+				break;
+		}
+
+		if (other == topology->num_caches)
+		{
+			if (topology->num_caches == CPU_TOPOLOGY_MAX_CACHES)
+				continue;
+
+			/* Sizes are like "48K" */
+			snprintf(name, CPU_SETTING_LEN, "cache/index%d/size", index);
+			cache.size_kb = ReadCPUInt(entry->cpu, name, 0);
+			snprintf(name, CPU_SETTING_LEN, "cache/index%d/coherency_line_size", index);
+			cache.line_size = ReadCPUInt(entry->cpu, name, 0);
+			snprintf(name, CPU_SETTING_LEN, "cache/index%d/ways_of_associativity", index);
+			cache.ways = ReadCPUInt(entry->cpu, name, 0);
+
+			topology->caches[topology->num_caches++] = cache;
+		}
+
+		entry->caches[entry->num_caches++] = other;
+	}
+}
+
+/* Vendor and model of the first processor of /proc/cpuinfo */
+static void ReadCPUIdentity(CPUTopology *topology)
+{
+	FILE           *fp;
+	char           *line_buf = NULL;
+	size_t         line_buf_size = 0;
+	struct utsname uts;
+	float8         cpu_mhz = 0;
+
+	if (uname(&uts) == 0)
+		strlcpy(topology->architecture, uts.machine, sizeof(topology->architecture));
+
+	fp = fopen(CPU_INFO_FILE_NAME, "r");
+	if (!fp)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("can not open file %s for reading cpu information",
+						CPU_INFO_FILE_NAME)));
+		return;
+	}
+
+	while (getline(&line_buf, &line_buf_size, fp) >= 0)
+	{
+		char *key;
+		char *value = strchr(line_buf, ':');
+
+		/* The blocks of the other processors repeat the same values */
+		if (line_buf[0] == '\n')
+			break;
+
+		if (value == NULL)
+			continue;
+
+		*value = '\0';
+		value = trimStr(value + 1);
+		key = trimStr(line_buf);
+
+		if (strcmp(key, "vendor_id") == 0)
+			strlcpy(topology->vendor, value, CPU_TOPOLOGY_NAME_LEN);
+		else if (strcmp(key, "model name") == 0)
+			strlcpy(topology->model_name, value, CPU_TOPOLOGY_NAME_LEN);
+		else if (strcmp(key, "cpu family") == 0)
+			strlcpy(topology->family, value, sizeof(topology->family));
+		else if (strcmp(key, "model") == 0)
+			strlcpy(topology->model, value, sizeof(topology->model));
+		else if (strcmp(key, "cpu MHz") == 0)
+			cpu_mhz = atof(value);
+	}
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(fp);
+
+	/* Prefer the nominal maximum of cpufreq to an instantaneous value */
+	if (topology->num_cpus > 0)
+	{
+		int max_khz = ReadCPUInt(topology->cpus[0].cpu, "cpufreq/cpuinfo_max_freq", 0);
+
+		if (max_khz > 0)
+			topology->clock_speed_hz = (uint64) max_khz * 1000;
+	}
+	if (topology->clock_speed_hz == 0)
+		topology->clock_speed_hz = (uint64) (cpu_mhz * 1000000);
+}
+
+/* Count the online CPUs, and the distinct sockets and cores they belong to */
+static void CountCPUs(CPUTopology *topology)
+{
+	int index;
+	int other;
+
+	topology->num_online = 0;
+	topology->num_packages = 0;
+	topology->num_cores = 0;
+
+	for (index = 0; index < topology->num_cpus; index++)
+	{
+		CPUTopologyCPU *entry = &topology->cpus[index];
+		bool           new_package = true;
+		bool           new_core = true;
+
+		if (!entry->online)
+			continue;
+
+		topology->num_online++;
+
+		for (other = 0; other < index && (new_package || new_core); other++)
+		{
+			CPUTopologyCPU *seen = &topology->cpus[other];
+
+			if (!seen->online || seen->package_id != entry->package_id)
+				continue;
+
+			new_package = false;
+			if (seen->die_id == entry->die_id && seen->core_id == entry->core_id)
+				new_core = false;
+		}
+
+		if (new_package)
+			topology->num_packages++;
+		if (new_core)
+			topology->num_cores++;
+	}
+}
+
+static bool ReadOnlineCPUs(char *online_cpus)
+{
+	return ReadFileLine(CPU_ONLINE_FILE_NAME, online_cpus, CPU_TOPOLOGY_LIST_LEN);
+}
+
+static void BuildCPUTopology(CPUTopology *topology)
+{
+	int *cpus;
+	int num_cpus;
+	int index;
+
+	memset(topology, 0, sizeof(CPUTopology));
+
+	ReadOnlineCPUs(topology->online_cpus);
+
+	cpus = ListSysfsCPUs(&num_cpus);
+	if (num_cpus > CPU_TOPOLOGY_MAX_CPUS)
+	{
+		ereport(LOG,
+				(errmsg("system_stats keeps the topology of the first %d of %d CPUs",
+					CPU_TOPOLOGY_MAX_CPUS, num_cpus)));
+		num_cpus = CPU_TOPOLOGY_MAX_CPUS;
+	}
+
+	for (index = 0; index < num_cpus; index++)
+	{
+		CPUTopologyCPU *entry = &topology->cpus[topology->num_cpus++];
+		char           file_name[MAXPGPATH];
+
+		entry->cpu = cpus[index];
+
+		/* The boot CPU usually can not be taken offline and has no online file */
+		entry->online = ReadCPUInt(entry->cpu, "online", 1) != 0;
+
+		/* Offline CPUs have no topology nor caches */
+		entry->package_id = ReadCPUInt(entry->cpu, "topology/physical_package_id", -1);
+		entry->die_id = ReadCPUInt(entry->cpu, "topology/die_id", 0);
+		entry->core_id = ReadCPUInt(entry->cpu, "topology/core_id", -1);
+		entry->node = ReadCPUNode(entry->cpu);
+
+		snprintf(file_name, MAXPGPATH, "%s/cpu%d/topology/thread_siblings_list",
+				 CPU_SYSFS_DIR, entry->cpu);
+		if (!ReadFileLine(file_name, entry->thread_siblings, CPU_TOPOLOGY_LIST_LEN))
+			entry->thread_siblings[0] = '\0';
+
+		ReadCPUCaches(topology, entry);
+	}
+
+	if (cpus != NULL)
+		pfree(cpus);
+
+	CountCPUs(topology);
+	ReadCPUIdentity(topology);
+}
+
+/*
+ * Rebuild the model when CPUs were hotplugged.  Called by the background
+ * sampler, which checks the online CPUs about once a second.
+ */
+void SampleCPUTopology(void)
+{
+	char        online_cpus[CPU_TOPOLOGY_LIST_LEN];
+	TimestampTz now;
+	bool        changed;
+
+	if (cpu_topology_state == NULL)
+		return;
+
+	now = GetCurrentTimestamp();
+	if (!TimestampDifferenceExceeds(last_topology_check, now, CPU_TOPOLOGY_CHECK_MS))
+		return;
+	last_topology_check = now;
+
+	if (!ReadOnlineCPUs(online_cpus))
+		return;
+
+	LWLockAcquire(cpu_topology_state->lock, LW_SHARED);
+	changed = strcmp(online_cpus, cpu_topology_state->topology.online_cpus) != 0;
+	LWLockRelease(cpu_topology_state->lock);
+
+	if (!changed)
+		return;
+
+	/* Build outside of the lock, the readers only wait for the copy */
+	if (local_topology == NULL)
+		local_topology = MemoryContextAlloc(TopMemoryContext, sizeof(CPUTopology));
+	BuildCPUTopology(local_topology);
+
+	LWLockAcquire(cpu_topology_state->lock, LW_EXCLUSIVE);
+	memcpy(&cpu_topology_state->topology, local_topology, sizeof(CPUTopology));
+	LWLockRelease(cpu_topology_state->lock);
+
+	ereport(LOG,
+			(errmsg("system_stats rebuilt the cpu topology, online cpus are now %s",
+				local_topology->online_cpus)));
+}
+
+/*
+ * Return a palloc'd copy of the model.  Without shared memory the backend
+ * keeps its own, rebuilt when the online CPUs differ from the last call.
+ */
+CPUTopology *GetCPUTopology(void)
+{
+	CPUTopology *topology = palloc(sizeof(CPUTopology));
+
+	if (cpu_topology_state != NULL)
+	{
+		LWLockAcquire(cpu_topology_state->lock, LW_SHARED);
+		memcpy(topology, &cpu_topology_state->topology, sizeof(CPUTopology));
+		LWLockRelease(cpu_topology_state->lock);
+		return topology;
+	}
+
+	if (local_topology == NULL)
+	{
+		local_topology = MemoryContextAlloc(TopMemoryContext, sizeof(CPUTopology));
+		BuildCPUTopology(local_topology);
+	}
+	else
+	{
+		char online_cpus[CPU_TOPOLOGY_LIST_LEN];
+
+		if (ReadOnlineCPUs(online_cpus) && strcmp(online_cpus, local_topology->online_cpus) != 0)
+			BuildCPUTopology(local_topology);
+	}
+
+	memcpy(topology, local_topology, sizeof(CPUTopology));
+	return topology;
+}
+
+void ReadCPUTopology(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum       values[Natts_cpu_topology];
+	bool        nulls[Natts_cpu_topology];
+	CPUTopology *topology = GetCPUTopology();
+	int         index;
+	int         cache_index;
+
+	for (index = 0; index < topology->num_cpus; index++)
+	{
+		CPUTopologyCPU *entry = &topology->cpus[index];
+
+		memset(nulls, 0, sizeof(nulls));
+
+		values[Anum_topo_cpu] = Int32GetDatum(entry->cpu);
+		values[Anum_topo_online] = BoolGetDatum(entry->online);
+
+		if (entry->package_id >= 0)
+		{
+			values[Anum_topo_socket] = Int32GetDatum(entry->package_id);
+			values[Anum_topo_die] = Int32GetDatum(entry->die_id);
+		}
+		else
+		{
+			nulls[Anum_topo_socket] = true;
+			nulls[Anum_topo_die] = true;
+		}
+
+		if (entry->core_id >= 0)
+			values[Anum_topo_core] = Int32GetDatum(entry->core_id);
+		else
+			nulls[Anum_topo_core] = true;
+
+		if (entry->node >= 0)
+			values[Anum_topo_node] = Int32GetDatum(entry->node);
+		else
+			nulls[Anum_topo_node] = true;
+
+		if (entry->thread_siblings[0] != '\0')
+			values[Anum_topo_thread_siblings] = CStringGetTextDatum(entry->thread_siblings);
+		else
+			nulls[Anum_topo_thread_siblings] = true;
+
+		/* A row per cache of the CPU, or one without cache */
+		if (entry->num_caches == 0)
+		{
+			nulls[Anum_topo_cache_level] = true;
+			nulls[Anum_topo_cache_type] = true;
+			nulls[Anum_topo_cache_size_kb] = true;
+			nulls[Anum_topo_cache_line_size] = true;
+			nulls[Anum_topo_cache_ways] = true;
+			nulls[Anum_topo_cache_shared_cpus] = true;
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+			continue;
+		}
+
+		for (cache_index = 0; cache_index < entry->num_caches; cache_index++)
+		{
+			CPUTopologyCache *cache = &topology->caches[entry->caches[cache_index]];
+
+			values[Anum_topo_cache_level] = Int32GetDatum(cache->level);
+			values[Anum_topo_cache_type] = CStringGetTextDatum(cache->type);
+			values[Anum_topo_cache_size_kb] = Int32GetDatum(cache->size_kb);
+			values[Anum_topo_cache_line_size] = Int32GetDatum(cache->line_size);
+			values[Anum_topo_cache_ways] = Int32GetDatum(cache->ways);
+			values[Anum_topo_cache_shared_cpus] = CStringGetTextDatum(cache->shared_cpus);
+
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+
+	pfree(topology);
+}
@@ -13,6 +13,8 @@
 #include <unistd.h>
 
 void ReadCPUUsageStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadKernelActivity(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadCPUUsagePerCore(Tuplestorestate *tupstore, TupleDesc tupdesc);
 
 struct cpu_stat
 {
@@ -23,24 +25,44 @@ struct cpu_stat
 	long long int io_completion;
 	long long int servicing_irq;
 	long long int servicing_softirq;
+	long long int steal;
+	long long int guest;
+	long long int guest_nice;
+
+	/* activity counters following the cpu lines */
+	long long int context_switches;
+	long long int forks;
+	long long int interrupts;
+	long long int softirqs;
+	long long int procs_running;
+	long long int procs_blocked;
+};
+
+static CounterBaseline kernel_activity_baseline;
+static CounterBaseline cpu_per_core_baseline;
+
+/* columns of the cpuN lines of /proc/stat, in the order of the Anum_core_* columns */
+static const char *const cpu_time_names[] = {
+	"user", "nice", "system", "idle", "iowait", "irq", "softirq", "steal",
+	"guest", "guest_nice"
 };
+#define NUM_CPU_TIMES               lengthof(cpu_time_names)
+#define CPU_TIME_GUEST              8
 
 void cpu_stat_information(struct cpu_stat* cpu_stat);
-/* Function used to get CPU state information for each mode of operation */
+/*
+ * Function used to get CPU state information for each mode of operation,
+ * and the kernel activity counters, in one read of /proc/stat
+ */
 void cpu_stat_information(struct cpu_stat* cpu_stat)
 {
 	FILE              *cpu_stats_file;
 	char              *line_buf = NULL;
 	size_t            line_buf_size = 0;
 	ssize_t           line_size;
-	long long int     usermode_normal_process = 0;
-	long long int     usermode_niced_process = 0;
-	long long int     kernelmode_process = 0;
-	long long int     idle_mode = 0;
-	long long int     io_completion = 0;
-	long long int     servicing_irq = 0;
-	long long int     servicing_softirq = 0;
-	const char *scan_fmt = "%*s %llu %llu %llu %llu %llu %llu %llu";
+	const char *scan_fmt = "%*s %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu";
+
+	memset(cpu_stat, 0, sizeof(struct cpu_stat));
 
 	cpu_stats_file = fopen(CPU_USAGE_STATS_FILENAME, "r");
 
@@ -53,14 +75,6 @@ void cpu_stat_information(struct cpu_stat* cpu_stat)
 				(errcode_for_file_access(),
 				errmsg("can not open file %s for reading cpu usage statistics",
 					cpu_stats_file_name)));
-
-		cpu_stat->usermode_normal_process = 0;
-		cpu_stat->usermode_niced_process = 0;
-		cpu_stat->kernelmode_process = 0;
-		cpu_stat->idle_mode = 0;
-		cpu_stat->io_completion = 0;
-		cpu_stat->servicing_irq = 0;
-		cpu_stat->servicing_softirq = 0;
 		return;
 	}
 
@@ -70,32 +84,31 @@ void cpu_stat_information(struct cpu_stat* cpu_stat)
 	/* Loop through until we are done with the file. */
 	while (line_size >= 0)
 	{
-		if (strstr(line_buf, "cpu") != NULL)
-		{
-			sscanf(line_buf, scan_fmt, &usermode_normal_process,
-						&usermode_niced_process,
-						&kernelmode_process,
-						&idle_mode,
-						&io_completion,
-						&servicing_irq,
-						&servicing_softirq);
-
-			cpu_stat->usermode_normal_process = usermode_normal_process;
-			cpu_stat->usermode_niced_process = usermode_niced_process;
-			cpu_stat->kernelmode_process = kernelmode_process;
-			cpu_stat->idle_mode = idle_mode;
-			cpu_stat->io_completion = io_completion;
-			cpu_stat->servicing_irq = servicing_irq;
-			cpu_stat->servicing_softirq = servicing_softirq;
-			break;
-		}
-
-		/* Free the allocated line buffer */
-		if (line_buf != NULL)
-		{
-			free(line_buf);
-			line_buf = NULL;
-		}
+		/* The aggregate of all CPUs, not the per CPU "cpuN" lines */
+		if (strncmp(line_buf, "cpu ", 4) == 0)
+			sscanf(line_buf, scan_fmt, &cpu_stat->usermode_normal_process,
+						&cpu_stat->usermode_niced_process,
+						&cpu_stat->kernelmode_process,
+						&cpu_stat->idle_mode,
+						&cpu_stat->io_completion,
+						&cpu_stat->servicing_irq,
+						&cpu_stat->servicing_softirq,
+						&cpu_stat->steal,
+						&cpu_stat->guest,
+						&cpu_stat->guest_nice);
+		else if (strncmp(line_buf, "ctxt ", 5) == 0)
+			sscanf(line_buf + 5, "%llu", &cpu_stat->context_switches);
+		else if (strncmp(line_buf, "processes ", 10) == 0)
+			sscanf(line_buf + 10, "%llu", &cpu_stat->forks);
+		/* The first value of the intr and softirq lines is the total */
+		else if (strncmp(line_buf, "intr ", 5) == 0)
+			sscanf(line_buf + 5, "%llu", &cpu_stat->interrupts);
+		else if (strncmp(line_buf, "softirq ", 8) == 0)
+			sscanf(line_buf + 8, "%llu", &cpu_stat->softirqs);
+		else if (strncmp(line_buf, "procs_running ", 14) == 0)
+			sscanf(line_buf + 14, "%llu", &cpu_stat->procs_running);
+		else if (strncmp(line_buf, "procs_blocked ", 14) == 0)
+			sscanf(line_buf + 14, "%llu", &cpu_stat->procs_blocked);
 
 		/* Get the next line */
 		line_size = getline(&line_buf, &line_buf_size, cpu_stats_file);
@@ -123,6 +136,7 @@ void ReadCPUUsageStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc)
 	long long int     delta_io_completion = 0;
 	long long int     delta_servicing_irq = 0;
 	long long int     delta_servicing_softirq = 0;
+	long long int     delta_steal = 0;
 	long long int     total_delta = 0;
 	float             scale = 100.0;
 	float             f_usermode_normal_process = 0.00;
@@ -132,6 +146,7 @@ void ReadCPUUsageStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc)
 	float             f_io_completion = 0.00;
 	float             f_servicing_irq = 0.00;
 	float             f_servicing_softirq = 0.00;
+	float             f_steal = 0.00;
 
 	memset(nulls, 0, sizeof(nulls));
 
@@ -149,9 +164,12 @@ void ReadCPUUsageStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc)
 	delta_io_completion = (second_sample.io_completion - first_sample.io_completion);
 	delta_servicing_irq = (second_sample.servicing_irq - first_sample.servicing_irq);
 	delta_servicing_softirq = (second_sample.servicing_softirq - first_sample.servicing_softirq);
+	delta_steal = (second_sample.steal - first_sample.steal);
 
+	/* Guest time is already accounted in the user and nice times */
 	total_delta = delta_usermode_normal_process + delta_usermode_niced_process + delta_kernelmode_process +
-                      delta_idle_mode + delta_io_completion + delta_servicing_irq + delta_servicing_softirq;
+                      delta_idle_mode + delta_io_completion + delta_servicing_irq + delta_servicing_softirq +
+                      delta_steal;
 
 	if (total_delta != 0)
 		scale = (float)100/(float)total_delta;
@@ -163,6 +181,7 @@ void ReadCPUUsageStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc)
 	f_io_completion = (float)(delta_io_completion * scale);
 	f_servicing_irq = (float)(delta_servicing_irq * scale);
 	f_servicing_softirq = (float)(delta_servicing_softirq * scale);
+	f_steal = (float)(delta_steal * scale);
 
 	f_usermode_normal_process = fl_round(f_usermode_normal_process);
 	f_usermode_niced_process = fl_round(f_usermode_niced_process);
@@ -171,6 +190,7 @@ void ReadCPUUsageStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc)
 	f_io_completion = fl_round(f_io_completion);
 	f_servicing_irq = fl_round(f_servicing_irq);
 	f_servicing_softirq = fl_round(f_servicing_softirq);
+	f_steal = fl_round(f_steal);
 
 	values[Anum_usermode_normal_process] = Float4GetDatum(f_usermode_normal_process);
 	values[Anum_usermode_niced_process] = Float4GetDatum(f_usermode_niced_process);
@@ -179,6 +199,7 @@ void ReadCPUUsageStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc)
 	values[Anum_io_completion] = Float4GetDatum(f_io_completion);
 	values[Anum_servicing_irq] = Float4GetDatum(f_servicing_irq);
 	values[Anum_servicing_softirq] = Float4GetDatum(f_servicing_softirq);
+	values[Anum_steal_time] = Float4GetDatum(f_steal);
 
 	nulls[Anum_percent_user_time] = true;
 	nulls[Anum_percent_processor_time] = true;
@@ -187,3 +208,131 @@ void ReadCPUUsageStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc)
 
 	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
 }
+
+/*
+ * Kernel activity counters of /proc/stat, with their rates since the
+ * previous call in this session
+ */
+void ReadKernelActivity(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum           values[Natts_kernel_activity];
+	bool            nulls[Natts_kernel_activity];
+	struct cpu_stat sample;
+	float8          rate;
+
+	memset(nulls, 0, sizeof(nulls));
+
+	cpu_stat_information(&sample);
+
+	counter_baseline_begin(&kernel_activity_baseline);
+
+	values[Anum_ka_context_switches] = Int64GetDatum(sample.context_switches);
+	if (counter_baseline_rate(&kernel_activity_baseline, "ctxt", sample.context_switches, &rate))
+		values[Anum_ka_context_switches_per_sec] = Float8GetDatum(rate);
+	else
+		nulls[Anum_ka_context_switches_per_sec] = true;
+
+	values[Anum_ka_forks] = Int64GetDatum(sample.forks);
+	if (counter_baseline_rate(&kernel_activity_baseline, "processes", sample.forks, &rate))
+		values[Anum_ka_forks_per_sec] = Float8GetDatum(rate);
+	else
+		nulls[Anum_ka_forks_per_sec] = true;
+
+	values[Anum_ka_interrupts] = Int64GetDatum(sample.interrupts);
+	if (counter_baseline_rate(&kernel_activity_baseline, "intr", sample.interrupts, &rate))
+		values[Anum_ka_interrupts_per_sec] = Float8GetDatum(rate);
+	else
+		nulls[Anum_ka_interrupts_per_sec] = true;
+
+	values[Anum_ka_softirqs] = Int64GetDatum(sample.softirqs);
+	if (counter_baseline_rate(&kernel_activity_baseline, "softirq", sample.softirqs, &rate))
+		values[Anum_ka_softirqs_per_sec] = Float8GetDatum(rate);
+	else
+		nulls[Anum_ka_softirqs_per_sec] = true;
+
+	counter_baseline_end(&kernel_activity_baseline);
+
+	values[Anum_ka_procs_running] = Int32GetDatum((int32) sample.procs_running);
+	values[Anum_ka_procs_blocked] = Int32GetDatum((int32) sample.procs_blocked);
+
+	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+}
+
+/*
+ * Time spent by each CPU in each mode since the previous call in this
+ * session, like mpstat -P ALL.  All cpuN lines of /proc/stat are parsed in
+ * the one pass, offline CPUs have no line.
+ */
+void ReadCPUUsagePerCore(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum   values[Natts_cpu_usage_per_core];
+	bool    nulls[Natts_cpu_usage_per_core];
+	FILE    *cpu_stats_file;
+	char    *line_buf = NULL;
+	size_t  line_buf_size = 0;
+	char    key[COUNTER_BASELINE_KEY_LEN];
+
+	cpu_stats_file = fopen(CPU_USAGE_STATS_FILENAME, "r");
+	if (!cpu_stats_file)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("can not open file %s for reading cpu usage statistics",
+						CPU_USAGE_STATS_FILENAME)));
+		return;
+	}
+
+	counter_baseline_begin(&cpu_per_core_baseline);
+
+	while (getline(&line_buf, &line_buf_size, cpu_stats_file) >= 0)
+	{
+		unsigned long long times[NUM_CPU_TIMES];
+		unsigned long long total = 0;
+		float8 total_rate;
+		float8 rate;
+		bool   has_rates;
+		int    cpu;
+		int    index;
+
+		/* The cpuN lines come first, stop at the following counters */
+		if (strncmp(line_buf, "cpu", 3) != 0)
+			break;
+		if (line_buf[3] == ' ')
+			continue;
+
+		memset(times, 0, sizeof(times));
+		if (sscanf(line_buf, "cpu%d %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+				   &cpu, &times[0], &times[1], &times[2], &times[3], &times[4],
+				   &times[5], &times[6], &times[7], &times[8], &times[9]) < 5)
+			continue;
+
+		/* Guest time is already accounted in the user and nice times */
+		for (index = 0; index < CPU_TIME_GUEST; index++)
+			total += times[index];
+
+		memset(nulls, 0, sizeof(nulls));
+		values[Anum_core_cpu] = Int32GetDatum(cpu);
+
+		snprintf(key, COUNTER_BASELINE_KEY_LEN, "cpu%d", cpu);
+		has_rates = counter_baseline_rate(&cpu_per_core_baseline, key, total, &total_rate) &&
+			total_rate > 0;
+
+		for (index = 0; index < NUM_CPU_TIMES; index++)
+		{
+			snprintf(key, COUNTER_BASELINE_KEY_LEN, "cpu%d/%s", cpu, cpu_time_names[index]);
+			if (counter_baseline_rate(&cpu_per_core_baseline, key, times[index], &rate) && has_rates)
+				values[Anum_core_user_percent + index] = Float8GetDatum(rate * 100 / total_rate);
+			else
+				nulls[Anum_core_user_percent + index] = true;
+		}
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	counter_baseline_end(&cpu_per_core_baseline);
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(cpu_stats_file);
+}
@@ -0,0 +1,519 @@
+/*------------------------------------------------------------------------
+ * dir_usage.c
+ *              Disk usage of directories in the data directory
+ *
+ * Directories are scanned by a small pool of threads taking work from a
+ * shared queue, as a single threaded walk is bound by the latency of the
+ * metadata reads on large directory trees.  The threads only use malloc
+ * and system calls; everything which may raise an error, including the
+ * interrupt processing between batches, happens in the backend's own
+ * thread while no worker thread is running.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "miscadmin.h"
+
+#define DIR_USAGE_MAX_THREADS       8
+#define DIR_USAGE_WAIT_MS           100
+#define DIR_USAGE_BATCH_DIRS        64          /* per batch without threads */
+
+/* a reported directory, with the usage of everything below it */
+typedef struct dir_node
+{
+	char   *path;
+	int    parent;              /* index of the parent node, -1 for the root */
+	int    depth;
+	uint64 size_bytes;
+	uint64 allocated_bytes;
+	uint64 files;
+	uint64 directories;
+} dir_node;
+
+/* a directory waiting to be scanned */
+typedef struct dir_work
+{
+	char   *path;
+	int    node;                /* node the contents are accounted to */
+	int    depth;
+} dir_work;
+
+/* state shared between the backend and the worker threads */
+typedef struct dir_walk
+{
+	pthread_mutex_t lock;
+	pthread_cond_t  work_available;
+	pthread_cond_t  walk_done;
+	dir_work        *queue;
+	int             queue_len;
+	int             queue_size;
+	int             in_progress;
+	dir_node        *nodes;
+	int             num_nodes;
+	int             max_nodes;
+	int             max_depth;
+	bool            stop;       /* workers exit after their current directory */
+	bool            failed;     /* a worker ran out of memory */
+} dir_walk;
+
+void ReadDirectoryUsage(Tuplestorestate *tupstore, TupleDesc tupdesc,
+		const char *path, int max_depth);
+static bool IsUnderRoot(const char *root_path, const char *path, bool resolved);
+static bool IsUsagePathAllowed(const char *path, bool resolved);
+static int AddNode(dir_walk *walk, const char *path, int parent, int depth);
+static bool PushWork(dir_walk *walk, const char *path, int node, int depth);
+static void ScanDirectory(dir_walk *walk, dir_work *work);
+static void *DirUsageWorker(void *arg);
+static bool RunWorkers(dir_walk *walk);
+static void FreeDirWalk(dir_walk *walk);
+static int CompareNodes(const void *a, const void *b);
+
+/*
+ * Whether the path is below an allowed root.  Resolved paths are checked
+ * against the resolved root.  Unresolved paths are only checked lexically,
+ * against the root itself and the target of its symbolic link, so that
+ * nothing outside of the allowed roots is ever looked up.
+ */
+static bool IsUnderRoot(const char *root_path, const char *path, bool resolved)
+{
+	char    allowed[MAXPGPATH];
+	char    target[MAXPGPATH];
+	ssize_t len;
+
+	if (resolved)
+		return realpath(root_path, allowed) != NULL &&
+			path_is_prefix_of_path(allowed, path);
+
+	strlcpy(allowed, root_path, MAXPGPATH);
+	canonicalize_path(allowed);
+	if (path_is_prefix_of_path(allowed, path))
+		return true;
+
+	len = readlink(root_path, target, MAXPGPATH - 1);
+	if (len <= 0)
+		return false;
+	target[len] = '\0';
+	if (!is_absolute_path(target))
+		return false;
+	canonicalize_path(target);
+
+	return path_is_prefix_of_path(target, path);
+}
+
+/*
+ * Only the data directory and the tablespace locations may be walked, the
+ * server has no business reporting on other parts of the filesystem.
+ */
+static bool IsUsagePathAllowed(const char *path, bool resolved)
+{
+	char          link_path[MAXPGPATH];
+	DIR           *dirp;
+	struct dirent *ent;
+	bool          found = false;
+
+	if (IsUnderRoot(DataDir, path, resolved))
+		return true;
+
+	/* pg_wal may be a symbolic link to another filesystem */
+	snprintf(link_path, MAXPGPATH, "%s/pg_wal", DataDir);
+	if (IsUnderRoot(link_path, path, resolved))
+		return true;
+
+	snprintf(link_path, MAXPGPATH, "%s/pg_tblspc", DataDir);
+	dirp = opendir(link_path);
+	if (!dirp)
+		return false;
+
+	while (!found && (ent = readdir(dirp)) != NULL)
+	{
+		if (!stringIsNumber(ent->d_name))
+			continue;
+
+		snprintf(link_path, MAXPGPATH, "%s/pg_tblspc/%s", DataDir, ent->d_name);
+		if (IsUnderRoot(link_path, path, resolved))
+			found = true;
+	}
+
+	closedir(dirp);
+
+	return found;
+}
+
+/* Add a reported directory.  Caller holds the lock, returns -1 when out of memory. */
+static int AddNode(dir_walk *walk, const char *path, int parent, int depth)
+{
+	dir_node *node;
+
+	if (walk->num_nodes == walk->max_nodes)
+	{
+		int      max_nodes = Max(walk->max_nodes * 2, 64);
+		dir_node *nodes = realloc(walk->nodes, max_nodes * sizeof(dir_node));
+
+		if (nodes == NULL)
+			return -1;
+		walk->nodes = nodes;
+		walk->max_nodes = max_nodes;
+	}
+
+	node = &walk->nodes[walk->num_nodes];
+	memset(node, 0, sizeof(dir_node));
+	node->path = strdup(path);
+	if (node->path == NULL)
+		return -1;
+	node->parent = parent;
+	node->depth = depth;
+
+	return walk->num_nodes++;
+}
+
+/* Queue a directory for scanning.  Caller holds the lock. */
+static bool PushWork(dir_walk *walk, const char *path, int node, int depth)
+{
+	dir_work *work;
+
+	if (walk->queue_len == walk->queue_size)
+	{
+		int      queue_size = Max(walk->queue_size * 2, 64);
+		dir_work *queue = realloc(walk->queue, queue_size * sizeof(dir_work));
+
+		if (queue == NULL)
+			return false;
+		walk->queue = queue;
+		walk->queue_size = queue_size;
+	}
+
+	work = &walk->queue[walk->queue_len];
+	work->path = strdup(path);
+	if (work->path == NULL)
+		return false;
+	work->node = node;
+	work->depth = depth;
+	walk->queue_len++;
+
+	pthread_cond_signal(&walk->work_available);
+
+	return true;
+}
+
+/*
+ * Scan one directory, queueing its subdirectories.  Runs in a worker
+ * thread, so it must not allocate memory with palloc or raise errors.
+ * Entries which vanish while scanning, like temporary files, are skipped.
+ */
+static void ScanDirectory(dir_walk *walk, dir_work *work)
+{
+	DIR           *dir;
+	struct dirent *ent;
+	struct stat   st;
+	char          child_path[MAXPGPATH];
+	int           fd;
+	uint64        size_bytes = 0;
+	uint64        allocated_bytes = 0;
+	uint64        files = 0;
+	uint64        directories = 0;
+
+	fd = open(work->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+
+	dir = fdopendir(fd);
+	if (dir == NULL)
+	{
+		close(fd);
+		return;
+	}
+
+	while ((ent = readdir(dir)) != NULL)
+	{
+		if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+			continue;
+
+		if (fstatat(dirfd(dir), ent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+			continue;
+
+		size_bytes += st.st_size;
+		allocated_bytes += (uint64) st.st_blocks * 512;
+
+		if (!S_ISDIR(st.st_mode))
+		{
+			files++;
+			continue;
+		}
+
+		directories++;
+		snprintf(child_path, MAXPGPATH, "%s/%s", work->path, ent->d_name);
+
+		pthread_mutex_lock(&walk->lock);
+		{
+			int node = work->node;
+
+			/* Below max_depth, usage is added to the deepest reported ancestor */
+			if (work->depth < walk->max_depth)
+				node = AddNode(walk, child_path, work->node, work->depth + 1);
+
+			if (node < 0 || !PushWork(walk, child_path, node, work->depth + 1))
+				walk->failed = true;
+		}
+		pthread_mutex_unlock(&walk->lock);
+	}
+
+	closedir(dir);
+
+	pthread_mutex_lock(&walk->lock);
+	walk->nodes[work->node].size_bytes += size_bytes;
+	walk->nodes[work->node].allocated_bytes += allocated_bytes;
+	walk->nodes[work->node].files += files;
+	walk->nodes[work->node].directories += directories;
+	pthread_mutex_unlock(&walk->lock);
+}
+
+/* Take directories from the queue until the walk is done or stopped */
+static void *DirUsageWorker(void *arg)
+{
+	dir_walk *walk = (dir_walk *) arg;
+
+	pthread_mutex_lock(&walk->lock);
+
+	for (;;)
+	{
+		dir_work work;
+
+		while (walk->queue_len == 0 && walk->in_progress > 0 && !walk->stop)
+			pthread_cond_wait(&walk->work_available, &walk->lock);
+
+		if (walk->stop || walk->failed || walk->queue_len == 0)
+			break;
+
+		work = walk->queue[--walk->queue_len];
+		walk->in_progress++;
+		pthread_mutex_unlock(&walk->lock);
+
+		ScanDirectory(walk, &work);
+		free(work.path);
+
+		pthread_mutex_lock(&walk->lock);
+		walk->in_progress--;
+
+		if (walk->queue_len == 0 && walk->in_progress == 0)
+		{
+			/* Wake up the idle workers so that they exit, and the backend */
+			pthread_cond_broadcast(&walk->work_available);
+			pthread_cond_signal(&walk->walk_done);
+		}
+	}
+
+	pthread_mutex_unlock(&walk->lock);
+
+	return NULL;
+}
+
+/*
+ * Run the worker threads until the walk is done, or until an interrupt is
+ * pending.  Returns true when the walk is done.  In both cases all threads
+ * have exited on return, and the directories not scanned yet are still in
+ * the queue.
+ */
+static bool RunWorkers(dir_walk *walk)
+{
+	pthread_t threads[DIR_USAGE_MAX_THREADS];
+	sigset_t  block_signals;
+	sigset_t  saved_signals;
+	int       num_threads;
+	int       started = 0;
+	bool      done;
+
+	num_threads = Min(Max((int) sysconf(_SC_NPROCESSORS_ONLN), 1), DIR_USAGE_MAX_THREADS);
+
+	/* Signals must be handled by the backend's thread, not by the workers */
+	sigfillset(&block_signals);
+	pthread_sigmask(SIG_SETMASK, &block_signals, &saved_signals);
+	while (started < num_threads &&
+		   pthread_create(&threads[started], NULL, DirUsageWorker, walk) == 0)
+		started++;
+	pthread_sigmask(SIG_SETMASK, &saved_signals, NULL);
+
+	/*
+	 * Without threads, walk a batch in this thread instead, and return so
+	 * that the caller processes interrupts before the next one
+	 */
+	if (started == 0)
+	{
+		int scanned = 0;
+
+		while (walk->queue_len > 0 && !walk->failed && scanned < DIR_USAGE_BATCH_DIRS)
+		{
+			dir_work work = walk->queue[--walk->queue_len];
+
+			ScanDirectory(walk, &work);
+			free(work.path);
+			scanned++;
+		}
+
+		return walk->queue_len == 0 && !walk->failed;
+	}
+
+	pthread_mutex_lock(&walk->lock);
+	while (!(walk->queue_len == 0 && walk->in_progress == 0) &&
+		   !walk->stop && !walk->failed)
+	{
+		struct timespec deadline;
+
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_nsec += DIR_USAGE_WAIT_MS * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L)
+		{
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+
+		pthread_cond_timedwait(&walk->walk_done, &walk->lock, &deadline);
+
+		if (InterruptPending)
+		{
+			walk->stop = true;
+			pthread_cond_broadcast(&walk->work_available);
+		}
+	}
+	done = (walk->queue_len == 0 && walk->in_progress == 0);
+	pthread_mutex_unlock(&walk->lock);
+
+	while (started > 0)
+		pthread_join(threads[--started], NULL);
+
+	return done && !walk->failed;
+}
+
+static void FreeDirWalk(dir_walk *walk)
+{
+	int index;
+
+	for (index = 0; index < walk->queue_len; index++)
+		free(walk->queue[index].path);
+	for (index = 0; index < walk->num_nodes; index++)
+		free(walk->nodes[index].path);
+	free(walk->queue);
+	free(walk->nodes);
+
+	pthread_cond_destroy(&walk->work_available);
+	pthread_cond_destroy(&walk->walk_done);
+	pthread_mutex_destroy(&walk->lock);
+}
+
+static int CompareNodes(const void *a, const void *b)
+{
+	return strcmp(((const dir_node *) a)->path, ((const dir_node *) b)->path);
+}
+
+void ReadDirectoryUsage(Tuplestorestate *tupstore, TupleDesc tupdesc,
+		const char *path, int max_depth)
+{
+	Datum       values[Natts_dir_usage];
+	bool        nulls[Natts_dir_usage];
+	char        root[MAXPGPATH];
+	char        requested[MAXPGPATH];
+	struct stat st;
+	dir_walk    walk;
+	int         index;
+
+	memset(nulls, 0, sizeof(nulls));
+
+	/* Relative paths are relative to the data directory, our working directory */
+	if (is_absolute_path(path))
+		strlcpy(requested, path, MAXPGPATH);
+	else
+		join_path_components(requested, DataDir, path);
+	canonicalize_path(requested);
+
+	/*
+	 * Check the path before resolving it, and raise the same error whether
+	 * it is outside, missing or not accessible, so that the function does not
+	 * tell anything about the rest of the filesystem.  The resolved path is
+	 * checked again as symbolic links may point elsewhere.
+	 */
+	if (!IsUsagePathAllowed(requested, false) ||
+		realpath(requested, root) == NULL ||
+		!IsUsagePathAllowed(root, true))
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+					errmsg("path \"%s\" is not in the data directory or a tablespace", path)));
+
+	if (stat(root, &st) != 0 || !S_ISDIR(st.st_mode))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					errmsg("\"%s\" is not a directory", path)));
+
+	memset(&walk, 0, sizeof(walk));
+	pthread_mutex_init(&walk.lock, NULL);
+	pthread_cond_init(&walk.work_available, NULL);
+	pthread_cond_init(&walk.walk_done, NULL);
+	walk.max_depth = max_depth;
+
+	if (AddNode(&walk, root, -1, 0) < 0 || !PushWork(&walk, root, 0, 0))
+		walk.failed = true;
+
+	PG_TRY();
+	{
+		while (!walk.failed && !RunWorkers(&walk))
+		{
+			if (walk.failed)
+				break;
+
+			/* Between batches, no thread is running and errors are safe */
+			CHECK_FOR_INTERRUPTS();
+			walk.stop = false;
+		}
+
+		if (walk.failed)
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+						errmsg("out of memory while walking \"%s\"", path)));
+	}
+	PG_CATCH();
+	{
+		FreeDirWalk(&walk);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	/* Children are always added after their parent, so roll up in reverse */
+	for (index = walk.num_nodes - 1; index > 0; index--)
+	{
+		dir_node *node = &walk.nodes[index];
+		dir_node *parent = &walk.nodes[node->parent];
+
+		parent->size_bytes += node->size_bytes;
+		parent->allocated_bytes += node->allocated_bytes;
+		parent->files += node->files;
+		parent->directories += node->directories;
+	}
+
+	qsort(walk.nodes, walk.num_nodes, sizeof(dir_node), CompareNodes);
+
+	for (index = 0; index < walk.num_nodes; index++)
+	{
+		dir_node *node = &walk.nodes[index];
+
+		values[Anum_du_path] = CStringGetTextDatum(node->path);
+		values[Anum_du_depth] = Int32GetDatum(node->depth);
+		values[Anum_du_size_bytes] = UInt64GetDatum(node->size_bytes);
+		values[Anum_du_allocated_bytes] = UInt64GetDatum(node->allocated_bytes);
+		values[Anum_du_files] = UInt64GetDatum(node->files);
+		values[Anum_du_directories] = UInt64GetDatum(node->directories);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	FreeDirWalk(&walk);
+}
@@ -0,0 +1,358 @@
+/*------------------------------------------------------------------------
+ * disk_benchmark.c
+ *              Bounded benchmark of the storage behind a directory
+ *
+ * The benchmark writes a temporary file into the given directory and
+ * measures the latency of the operations PostgreSQL depends on: flushing
+ * small writes with fsync, fdatasync and O_DSYNC, writing sequentially and
+ * reading random blocks past the page cache.  The amount of IO is bounded by
+ * the file size and iteration count, and the file is removed afterwards,
+ * also when the benchmark is cancelled.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <sys/stat.h>
+
+#include "miscadmin.h"
+#include "portability/instr_time.h"
+#include "storage/fd.h"
+
+#define BENCHMARK_BLOCK_SIZE        8192
+#define BENCHMARK_CHUNK_SIZE        (1024 * 1024)
+#define BENCHMARK_ALIGNMENT         4096
+#define BENCHMARK_DEVICE_NAME_LEN   64
+
+typedef enum BenchmarkSyncMethod
+{
+	BENCHMARK_SYNC_FSYNC,
+	BENCHMARK_SYNC_FDATASYNC,
+	BENCHMARK_SYNC_O_DSYNC
+} BenchmarkSyncMethod;
+
+void RunDiskBenchmark(Tuplestorestate *tupstore, TupleDesc tupdesc,
+		const char *directory, int file_size_mb, int iterations);
+static float8 ElapsedMicroseconds(instr_time start);
+static int CompareLatencies(const void *a, const void *b);
+static float8 LatencyPercentile(float8 *latencies, int count, float8 fraction);
+static void PutBenchmarkRow(Tuplestorestate *tupstore, TupleDesc tupdesc,
+		const char *test, const char *directory, const char *device_name,
+		float8 *latencies, int count, float8 total_usecs, uint64 bytes);
+static void WriteBlock(int fd, const char *path, char *buf, size_t len, off_t offset);
+static float8 BenchmarkSequentialWrite(const char *path, char *buf,
+		int file_size_mb, float8 *latencies);
+static float8 BenchmarkRandomRead(const char *path, char *buf,
+		int file_size_mb, int iterations, float8 *latencies);
+static float8 BenchmarkSync(const char *path, char *buf, int iterations,
+		BenchmarkSyncMethod method, float8 *latencies);
+
+/* Microseconds passed since start */
+static float8 ElapsedMicroseconds(instr_time start)
+{
+	instr_time end;
+
+	INSTR_TIME_SET_CURRENT(end);
+	INSTR_TIME_SUBTRACT(end, start);
+
+	return INSTR_TIME_GET_DOUBLE(end) * 1000000.0;
+}
+
+static int CompareLatencies(const void *a, const void *b)
+{
+	float8 la = *(const float8 *) a;
+	float8 lb = *(const float8 *) b;
+
+	if (la < lb)
+		return -1;
+	if (la > lb)
+		return 1;
+	return 0;
+}
+
+/* Nearest rank percentile of sorted latencies */
+static float8 LatencyPercentile(float8 *latencies, int count, float8 fraction)
+{
+	int index = (int) ceil(fraction * count) - 1;
+
+	return latencies[Max(Min(index, count - 1), 0)];
+}
+
+/* Put the latency distribution and throughput of one test in the tuple store */
+static void PutBenchmarkRow(Tuplestorestate *tupstore, TupleDesc tupdesc,
+		const char *test, const char *directory, const char *device_name,
+		float8 *latencies, int count, float8 total_usecs, uint64 bytes)
+{
+	Datum  values[Natts_disk_benchmark];
+	bool   nulls[Natts_disk_benchmark];
+	float8 sum = 0;
+	int    index;
+
+	memset(nulls, 0, sizeof(nulls));
+
+	qsort(latencies, count, sizeof(float8), CompareLatencies);
+	for (index = 0; index < count; index++)
+		sum += latencies[index];
+
+	values[Anum_bench_test] = CStringGetTextDatum(test);
+	values[Anum_bench_directory] = CStringGetTextDatum(directory);
+	if (device_name != NULL)
+		values[Anum_bench_device_name] = CStringGetTextDatum(device_name);
+	else
+		nulls[Anum_bench_device_name] = true;
+	values[Anum_bench_operations] = Int64GetDatum((int64) count);
+	values[Anum_bench_min_latency] = Float8GetDatum(latencies[0]);
+	values[Anum_bench_avg_latency] = Float8GetDatum(sum / count);
+	values[Anum_bench_p50_latency] = Float8GetDatum(LatencyPercentile(latencies, count, 0.50));
+	values[Anum_bench_p90_latency] = Float8GetDatum(LatencyPercentile(latencies, count, 0.90));
+	values[Anum_bench_p99_latency] = Float8GetDatum(LatencyPercentile(latencies, count, 0.99));
+	values[Anum_bench_max_latency] = Float8GetDatum(latencies[count - 1]);
+
+	if (total_usecs > 0)
+		values[Anum_bench_bytes_per_sec] = Float8GetDatum(bytes / (total_usecs / 1000000.0));
+	else
+		nulls[Anum_bench_bytes_per_sec] = true;
+
+	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+}
+
+static void WriteBlock(int fd, const char *path, char *buf, size_t len, off_t offset)
+{
+	ssize_t written = pwrite(fd, buf, len, offset);
+
+	if (written != (ssize_t) len)
+	{
+		/* if write didn't set errno, assume problem is no disk space */
+		if (written >= 0)
+			errno = ENOSPC;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+					errmsg("could not write to file \"%s\": %m", path)));
+	}
+}
+
+/*
+ * Write the benchmark file in chunks and flush it, which also prepares the
+ * file read by the random read test.  Returns the total time including the
+ * final flush, as that is when the data is known to be on the device.
+ */
+static float8 BenchmarkSequentialWrite(const char *path, char *buf,
+		int file_size_mb, float8 *latencies)
+{
+	instr_time start;
+	instr_time op_start;
+	int        fd;
+	int        chunk;
+
+	fd = OpenTransientFile(path, O_WRONLY | O_CREAT | O_TRUNC | PG_BINARY);
+	if (fd < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+					errmsg("could not create file \"%s\": %m", path)));
+
+	INSTR_TIME_SET_CURRENT(start);
+
+	for (chunk = 0; chunk < file_size_mb; chunk++)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		INSTR_TIME_SET_CURRENT(op_start);
+		WriteBlock(fd, path, buf, BENCHMARK_CHUNK_SIZE, (off_t) chunk * BENCHMARK_CHUNK_SIZE);
+		latencies[chunk] = ElapsedMicroseconds(op_start);
+	}
+
+	if (fdatasync(fd) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+					errmsg("could not fdatasync file \"%s\": %m", path)));
+
+	CloseTransientFile(fd);
+
+	return ElapsedMicroseconds(start);
+}
+
+/*
+ * Read random blocks of the benchmark file.  O_DIRECT is used so that the
+ * reads reach the device; on filesystems without O_DIRECT support the file is
+ * evicted from the page cache instead, which is the best we can do there.
+ */
+static float8 BenchmarkRandomRead(const char *path, char *buf,
+		int file_size_mb, int iterations, float8 *latencies)
+{
+	instr_time start;
+	instr_time op_start;
+	int        fd;
+	int        iteration;
+	long       num_blocks = (long) file_size_mb * (BENCHMARK_CHUNK_SIZE / BENCHMARK_BLOCK_SIZE);
+
+	fd = OpenTransientFile(path, O_RDONLY | O_DIRECT | PG_BINARY);
+	if (fd < 0 && errno == EINVAL)
+	{
+		fd = OpenTransientFile(path, O_RDONLY | PG_BINARY);
+		if (fd >= 0)
+		{
+			ereport(NOTICE,
+					(errmsg("O_DIRECT is not supported in the benchmark directory, random reads may be served from the page cache")));
+			(void) posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		}
+	}
+	if (fd < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+					errmsg("could not open file \"%s\": %m", path)));
+
+	INSTR_TIME_SET_CURRENT(start);
+
+	for (iteration = 0; iteration < iterations; iteration++)
+	{
+		off_t   offset = (off_t) (random() % num_blocks) * BENCHMARK_BLOCK_SIZE;
+		ssize_t nread;
+
+		CHECK_FOR_INTERRUPTS();
+
+		INSTR_TIME_SET_CURRENT(op_start);
+		nread = pread(fd, buf, BENCHMARK_BLOCK_SIZE, offset);
+		latencies[iteration] = ElapsedMicroseconds(op_start);
+
+		if (nread != BENCHMARK_BLOCK_SIZE)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+						errmsg("could not read file \"%s\": %m", path)));
+	}
+
+	CloseTransientFile(fd);
+
+	return ElapsedMicroseconds(start);
+}
+
+/*
+ * Overwrite the first block of the benchmark file and flush it, the way
+ * WAL is written at commit.  The latency includes both the write and the
+ * flush.  fsync() is called directly rather than through pg_fsync(), so
+ * that the fsync setting does not turn the test into a no-op.
+ */
+static float8 BenchmarkSync(const char *path, char *buf, int iterations,
+		BenchmarkSyncMethod method, float8 *latencies)
+{
+	instr_time start;
+	instr_time op_start;
+	int        fd;
+	int        flags = O_WRONLY | PG_BINARY;
+	int        iteration;
+
+	if (method == BENCHMARK_SYNC_O_DSYNC)
+		flags |= O_DSYNC;
+
+	fd = OpenTransientFile(path, flags);
+	if (fd < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+					errmsg("could not open file \"%s\": %m", path)));
+
+	INSTR_TIME_SET_CURRENT(start);
+
+	for (iteration = 0; iteration < iterations; iteration++)
+	{
+		int rc = 0;
+
+		CHECK_FOR_INTERRUPTS();
+
+		INSTR_TIME_SET_CURRENT(op_start);
+		WriteBlock(fd, path, buf, BENCHMARK_BLOCK_SIZE, 0);
+		if (method == BENCHMARK_SYNC_FSYNC)
+			rc = fsync(fd);
+		else if (method == BENCHMARK_SYNC_FDATASYNC)
+			rc = fdatasync(fd);
+		latencies[iteration] = ElapsedMicroseconds(op_start);
+
+		if (rc != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+						errmsg("could not flush file \"%s\": %m", path)));
+	}
+
+	CloseTransientFile(fd);
+
+	return ElapsedMicroseconds(start);
+}
+
+void RunDiskBenchmark(Tuplestorestate *tupstore, TupleDesc tupdesc,
+		const char *directory, int file_size_mb, int iterations)
+{
+	char        path[MAXPGPATH];
+	char        device_name[BENCHMARK_DEVICE_NAME_LEN];
+	char        backing_devices[MAXPGPATH];
+	char        *device = NULL;
+	char        *buf;
+	float8      *latencies;
+	struct stat st;
+	size_t      index;
+
+	if (stat(directory, &st) != 0 || !S_ISDIR(st.st_mode))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					errmsg("\"%s\" is not a directory", directory)));
+
+	if (ResolveBlockDevice(directory, device_name, BENCHMARK_DEVICE_NAME_LEN,
+						   backing_devices, MAXPGPATH))
+		device = device_name;
+
+	snprintf(path, MAXPGPATH, "%s/system_stats_benchmark.%d.tmp", directory, MyProcPid);
+
+	/* O_DIRECT needs a buffer aligned to the logical block size */
+	buf = (char *) TYPEALIGN(BENCHMARK_ALIGNMENT,
+							 palloc(BENCHMARK_CHUNK_SIZE + BENCHMARK_ALIGNMENT));
+	latencies = palloc(Max(file_size_mb, iterations) * sizeof(float8));
+
+	/* Random data, so that compressing devices can not cheat */
+	for (index = 0; index < BENCHMARK_CHUNK_SIZE; index++)
+		buf[index] = (char) random();
+
+	PG_TRY();
+	{
+		float8 total_usecs;
+
+		total_usecs = BenchmarkSequentialWrite(path, buf, file_size_mb, latencies);
+		PutBenchmarkRow(tupstore, tupdesc, "sequential_write", directory, device,
+						latencies, file_size_mb, total_usecs,
+						(uint64) file_size_mb * BENCHMARK_CHUNK_SIZE);
+
+		total_usecs = BenchmarkRandomRead(path, buf, file_size_mb, iterations, latencies);
+		PutBenchmarkRow(tupstore, tupdesc, "random_read_8k", directory, device,
+						latencies, iterations, total_usecs,
+						(uint64) iterations * BENCHMARK_BLOCK_SIZE);
+
+		total_usecs = BenchmarkSync(path, buf, iterations, BENCHMARK_SYNC_FSYNC, latencies);
+		PutBenchmarkRow(tupstore, tupdesc, "fsync", directory, device,
+						latencies, iterations, total_usecs,
+						(uint64) iterations * BENCHMARK_BLOCK_SIZE);
+
+		total_usecs = BenchmarkSync(path, buf, iterations, BENCHMARK_SYNC_FDATASYNC, latencies);
+		PutBenchmarkRow(tupstore, tupdesc, "fdatasync", directory, device,
+						latencies, iterations, total_usecs,
+						(uint64) iterations * BENCHMARK_BLOCK_SIZE);
+
+		total_usecs = BenchmarkSync(path, buf, iterations, BENCHMARK_SYNC_O_DSYNC, latencies);
+		PutBenchmarkRow(tupstore, tupdesc, "o_dsync", directory, device,
+						latencies, iterations, total_usecs,
+						(uint64) iterations * BENCHMARK_BLOCK_SIZE);
+	}
+	PG_CATCH();
+	{
+		/* Transient files are closed at abort, but the file must go too */
+		(void) unlink(path);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	if (unlink(path) != 0)
+		ereport(WARNING,
+				(errcode_for_file_access(),
+					errmsg("could not remove file \"%s\": %m", path)));
+}
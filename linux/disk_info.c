@@ -11,11 +11,19 @@
 
 #include <mntent.h>
 #include <regex.h>
+#include <sys/stat.h>
 #include <sys/statvfs.h>
+#include <sys/sysmacros.h>
+#include <dirent.h>
 
 #include "system_stats.h"
 
+/* maximum depth of stacked devices (e.g. LVM on md on partitions) */
+#define MAX_SLAVES_DEPTH    8
+
 void ReadDiskInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+static void CollectBackingDevices(const char *device_name, int depth,
+		char *backing_devices, size_t backing_len);
 
 /* This function is used to ignore the file system types */
 bool ignoreFileSystemTypes(char *fs_mnt)
@@ -190,3 +198,96 @@ void ReadDiskInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
 		endmntent(fp);
 	}
 }
+
+/*
+ * Append the physical devices backing the given block device to the comma
+ * separated list.  Device-mapper, LVM and md devices list the devices they
+ * are built on in /sys/class/block/<dev>/slaves, so those are followed down
+ * to the devices which have no slaves themselves.
+ */
+static void CollectBackingDevices(const char *device_name, int depth,
+		char *backing_devices, size_t backing_len)
+{
+	char          slaves_dir[MAXPGPATH];
+	DIR           *dirp = NULL;
+	struct dirent *ent;
+	bool          has_slaves = false;
+
+	snprintf(slaves_dir, MAXPGPATH, "/sys/class/block/%s/slaves", device_name);
+
+	if (depth < MAX_SLAVES_DEPTH)
+		dirp = opendir(slaves_dir);
+
+	if (dirp)
+	{
+		while ((ent = readdir(dirp)) != NULL)
+		{
+			if (ent->d_name[0] == '.')
+				continue;
+
+			has_slaves = true;
+			CollectBackingDevices(ent->d_name, depth + 1, backing_devices, backing_len);
+		}
+		closedir(dirp);
+	}
+
+	if (!has_slaves)
+	{
+		size_t len = strlen(backing_devices);
+
+		snprintf(backing_devices + len, backing_len - len, "%s%s",
+				 len > 0 ? "," : "", device_name);
+	}
+}
+
+/*
+ * Resolve the block device holding the given path from the st_dev of the
+ * path, using the /sys/dev/block/<major>:<minor> link.  Also returns the
+ * comma separated list of physical devices backing it.  Returns false for
+ * paths which do not live on a block device, e.g. tmpfs or NFS.
+ */
+bool ResolveBlockDevice(const char *path, char *device_name, size_t device_len,
+		char *backing_devices, size_t backing_len)
+{
+	struct stat st;
+	char        link_name[MAXPGPATH];
+	char        link_target[MAXPGPATH];
+	char        *base_name;
+	ssize_t     len;
+
+	memset(link_target, 0, MAXPGPATH);
+
+	if (stat(path, &st) != 0)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("could not stat file \"%s\": %m", path)));
+		return false;
+	}
+
+	/* major 0 is used for filesystems without a backing block device */
+	if (major(st.st_dev) == 0)
+		return false;
+
+	snprintf(link_name, MAXPGPATH, "/sys/dev/block/%u:%u",
+			 major(st.st_dev), minor(st.st_dev));
+
+	len = readlink(link_name, link_target, MAXPGPATH - 1);
+	if (len <= 0)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("could not read symbolic link \"%s\": %m", link_name)));
+		return false;
+	}
+
+	base_name = strrchr(link_target, '/');
+	base_name = (base_name != NULL) ? base_name + 1 : link_target;
+
+	snprintf(device_name, device_len, "%s", base_name);
+
+	memset(backing_devices, 0, backing_len);
+	CollectBackingDevices(device_name, 0, backing_devices, backing_len);
+
+	return true;
+}
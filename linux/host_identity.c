@@ -0,0 +1,511 @@
+/*------------------------------------------------------------------------
+ * host_identity.c
+ *              Cached identity of the host
+ *
+ * The operating system, host name, domain and boot time of the host hardly
+ * ever change, but reading them means parsing /etc/os-release and, for the
+ * domain, a DNS lookup which may block for the whole resolver timeout when
+ * DNS is slow or unreachable.  They are kept in shared memory, or in backend
+ * memory when the extension is not preloaded, and refreshed every
+ * system_stats.host_identity_ttl.  The DNS lookup runs in a thread of its
+ * own; until it completes, the domain comes from /etc/resolv.conf.  The
+ * thread only calls getaddrinfo() and touches the lookup state below, no
+ * PostgreSQL function.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+#include "misc.h"
+
+#include <netdb.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/guc.h"
+#include "utils/memutils.h"
+#include "utils/timestamp.h"
+
+/* DNS lookup running in the background */
+typedef struct DomainLookup
+{
+	pthread_mutex_t lock;
+	bool            running;
+	bool            finished;                  /* until collected */
+	bool            found;
+	char            host_name[HOST_IDENTITY_NAME_LEN];
+	char            domain_name[HOST_IDENTITY_NAME_LEN];
+} DomainLookup;
+
+typedef struct HostIdentityState
+{
+	LWLock       *lock;
+	HostIdentity identity;
+} HostIdentityState;
+
+/* time the cached identity is used before it is read again */
+int host_identity_ttl_s = 300;
+
+static HostIdentityState *host_identity_state = NULL;
+
+/* copy of the sampler, or of a backend when the extension is not preloaded */
+static HostIdentity *local_identity = NULL;
+
+static DomainLookup domain_lookup = {PTHREAD_MUTEX_INITIALIZER};
+
+static void BuildHostIdentity(HostIdentity *identity, const HostIdentity *previous);
+static bool ReadOSName(char *os_name);
+static bool ReadBootTime(TimestampTz *boot_time);
+static bool ReadLocalDomainName(char *domain_name, size_t domain_size);
+static void *DomainLookupWorker(void *arg);
+static void StartDomainLookup(const char *host_name);
+static bool CollectDomainLookup(HostIdentity *identity);
+static bool HostIdentityExpired(const HostIdentity *identity, TimestampTz now);
+
+void DefineHostIdentityVariables(void)
+{
+	DefineCustomIntVariable("system_stats.host_identity_ttl",
+							"Sets how long the identity of the host is cached.",
+							NULL,
+							&host_identity_ttl_s,
+							300,
+							1,
+							INT_MAX / 1000,
+							PGC_SIGHUP,
+							GUC_UNIT_S,
+							NULL,
+							NULL,
+							NULL);
+}
+
+Size HostIdentityShmemSize(void)
+{
+	return MAXALIGN(sizeof(HostIdentityState));
+}
+
+/*
+ * The identity is built without the DNS lookup here, in the postmaster; the
+ * sampler starts the lookup on its first iteration.
+ */
+void HostIdentityShmemInit(void)
+{
+	bool found;
+
+	host_identity_state = ShmemInitStruct("system_stats host identity",
+										  HostIdentityShmemSize(), &found);
+	if (!found)
+	{
+		memset(host_identity_state, 0, HostIdentityShmemSize());
+		host_identity_state->lock =
+			&(GetNamedLWLockTranche(SYSTEM_STATS_LWLOCK_TRANCHE))[SAMPLER_LOCK_HOST_IDENTITY].lock;
+		BuildHostIdentity(&host_identity_state->identity, NULL);
+	}
+}
+
+/* PRETTY_NAME of /etc/os-release */
+static bool ReadOSName(char *os_name)
+{
+	FILE    *os_info_file;
+	char    *line_buf = NULL;
+	size_t  line_buf_size = 0;
+	bool    found = false;
+
+	os_info_file = fopen(OS_INFO_FILE_NAME, "r");
+	if (!os_info_file)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("can not open file %s for reading os information",
+						OS_INFO_FILE_NAME)));
+		return false;
+	}
+
+	while (getline(&line_buf, &line_buf_size, os_info_file) >= 0)
+	{
+		if (strncmp(line_buf, OS_DESC_SEARCH_TEXT, strlen(OS_DESC_SEARCH_TEXT)) == 0)
+		{
+			snprintf(os_name, HOST_IDENTITY_NAME_LEN, "%s",
+					 remove_quotes(str_trim(line_buf + strlen(OS_DESC_SEARCH_TEXT))));
+			found = true;
+			break;
+		}
+	}
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(os_info_file);
+
+	return found;
+}
+
+/* btime of /proc/stat, in seconds since the epoch */
+static bool ReadBootTime(TimestampTz *boot_time)
+{
+	FILE    *fp;
+	char    *line_buf = NULL;
+	size_t  line_buf_size = 0;
+	bool    found = false;
+	long long btime;
+
+	fp = fopen(CPU_USAGE_STATS_FILENAME, "r");
+	if (!fp)
+		return false;
+
+	while (getline(&line_buf, &line_buf_size, fp) >= 0)
+	{
+		if (sscanf(line_buf, "btime %lld", &btime) == 1)
+		{
+			*boot_time = time_t_to_timestamptz((pg_time_t) btime);
+			found = true;
+			break;
+		}
+	}
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(fp);
+
+	return found;
+}
+
+/*
+ * Domain configured for the resolver in /etc/resolv.conf (domain, or else
+ * the first search directive), or as a last resort getdomainname().
+ */
+static bool ReadLocalDomainName(char *domain_name, size_t domain_size)
+{
+	FILE *resolv_file;
+	bool found = false;
+
+	memset(domain_name, 0, domain_size);
+
+	resolv_file = fopen("/etc/resolv.conf", "r");
+	if (resolv_file != NULL)
+	{
+		char *line_buf = NULL;
+		size_t line_buf_size = 0;
+
+		while (getline(&line_buf, &line_buf_size, resolv_file) >= 0)
+		{
+			char *trimmed = str_trim(line_buf);
+
+			/* Check for "domain" directive (preferred) */
+			if (strncmp(trimmed, "domain", 6) == 0)
+			{
+				char *domain_val = str_trim(trimmed + 6);
+				if (strlen(domain_val) > 0)
+				{
+					snprintf(domain_name, domain_size, "%s", domain_val);
+					found = true;
+					break;
+				}
+			}
+			/* Check for "search" directive (fallback) */
+			else if (!found && strncmp(trimmed, "search", 6) == 0)
+			{
+				char *search_val = str_trim(trimmed + 6);
+				/* Take first domain from search list */
+				char *space = strchr(search_val, ' ');
+				if (space != NULL)
+					*space = '\0';
+
+				if (strlen(search_val) > 0)
+				{
+					snprintf(domain_name, domain_size, "%s", search_val);
+					found = true;
+				}
+			}
+		}
+
+		if (line_buf != NULL)
+			free(line_buf);
+		fclose(resolv_file);
+	}
+
+	if (!found)
+	{
+		char nis_domain[256];
+		memset(nis_domain, 0, sizeof(nis_domain));
+
+		if (getdomainname(nis_domain, sizeof(nis_domain)) == 0)
+		{
+			/* Validate that it's not empty or "(none)" */
+			if (strlen(nis_domain) > 0 &&
+				strcmp(nis_domain, "(none)") != 0 &&
+				strcmp(nis_domain, "localdomain") != 0)
+			{
+				snprintf(domain_name, domain_size, "%s", nis_domain);
+				found = true;
+			}
+		}
+	}
+
+	return found;
+}
+
+/*
+ * Read everything but the DNS domain.  The domain found by the previous DNS
+ * lookup is kept as long as the host name is the same, otherwise the local
+ * configuration is used until the next lookup completes.
+ */
+static void BuildHostIdentity(HostIdentity *identity, const HostIdentity *previous)
+{
+	struct utsname uts;
+
+	memset(identity, 0, sizeof(HostIdentity));
+
+	identity->has_os_name = ReadOSName(identity->os_name);
+
+	if (uname(&uts) == 0)
+	{
+		snprintf(identity->version, HOST_IDENTITY_NAME_LEN, "%s %s", uts.sysname, uts.release);
+		snprintf(identity->architecture, HOST_IDENTITY_NAME_LEN, "%s", uts.machine);
+		identity->has_uname = true;
+	}
+
+	if (gethostname(identity->host_name, HOST_IDENTITY_NAME_LEN) != 0)
+		ereport(DEBUG1,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					errmsg("error while getting host name")));
+	else
+	{
+		identity->host_name[HOST_IDENTITY_NAME_LEN - 1] = '\0';
+		identity->has_host_name = strlen(identity->host_name) > 0;
+	}
+
+	if (previous != NULL && previous->domain_from_dns &&
+		strcmp(previous->host_name, identity->host_name) == 0)
+	{
+		memcpy(identity->domain_name, previous->domain_name, HOST_IDENTITY_NAME_LEN);
+		identity->has_domain_name = true;
+		identity->domain_from_dns = true;
+	}
+	else
+		identity->has_domain_name = ReadLocalDomainName(identity->domain_name,
+														 HOST_IDENTITY_NAME_LEN);
+
+	identity->has_boot_time = ReadBootTime(&identity->boot_time);
+	identity->refreshed_at = GetCurrentTimestamp();
+}
+
+/* Resolve the FQDN of the host and keep the part after the first dot */
+static void *DomainLookupWorker(void *arg)
+{
+	DomainLookup    *lookup = (DomainLookup *) arg;
+	struct addrinfo hints, *info = NULL;
+	char            domain_name[HOST_IDENTITY_NAME_LEN];
+	bool            found = false;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_CANONNAME;
+
+	/* host_name is not written while the lookup is running */
+	if (getaddrinfo(lookup->host_name, NULL, &hints, &info) == 0 && info != NULL)
+	{
+		if (info->ai_canonname != NULL)
+		{
+			char *dot_pos = strchr(info->ai_canonname, '.');
+
+			if (dot_pos != NULL && strlen(dot_pos + 1) > 0)
+			{
+				snprintf(domain_name, HOST_IDENTITY_NAME_LEN, "%s", dot_pos + 1);
+				found = true;
+			}
+		}
+		freeaddrinfo(info);
+	}
+
+	pthread_mutex_lock(&lookup->lock);
+	if (found)
+		memcpy(lookup->domain_name, domain_name, HOST_IDENTITY_NAME_LEN);
+	lookup->found = found;
+	lookup->finished = true;
+	lookup->running = false;
+	pthread_mutex_unlock(&lookup->lock);
+
+	return NULL;
+}
+
+/* Start a lookup, unless one is still running */
+static void StartDomainLookup(const char *host_name)
+{
+	pthread_t      thread;
+	pthread_attr_t attr;
+	sigset_t       block_signals;
+	sigset_t       saved_signals;
+	int            ret;
+
+	pthread_mutex_lock(&domain_lookup.lock);
+	if (domain_lookup.running)
+	{
+		pthread_mutex_unlock(&domain_lookup.lock);
+		return;
+	}
+	domain_lookup.running = true;
+	domain_lookup.finished = false;
+	snprintf(domain_lookup.host_name, HOST_IDENTITY_NAME_LEN, "%s", host_name);
+	pthread_mutex_unlock(&domain_lookup.lock);
+
+	/* The signals are for the process' own thread */
+	sigfillset(&block_signals);
+	pthread_sigmask(SIG_SETMASK, &block_signals, &saved_signals);
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	ret = pthread_create(&thread, &attr, DomainLookupWorker, &domain_lookup);
+	pthread_attr_destroy(&attr);
+	pthread_sigmask(SIG_SETMASK, &saved_signals, NULL);
+
+	if (ret != 0)
+	{
+		pthread_mutex_lock(&domain_lookup.lock);
+		domain_lookup.running = false;
+		pthread_mutex_unlock(&domain_lookup.lock);
+
+		ereport(DEBUG1,
+				(errmsg("could not start the domain name lookup: %s", strerror(ret))));
+	}
+}
+
+/*
+ * Apply the result of a completed lookup to identity.  Returns true if the
+ * identity was changed.
+ */
+static bool CollectDomainLookup(HostIdentity *identity)
+{
+	bool finished;
+	bool found;
+	char domain_name[HOST_IDENTITY_NAME_LEN];
+
+	pthread_mutex_lock(&domain_lookup.lock);
+	finished = domain_lookup.finished;
+	found = domain_lookup.found;
+	if (finished && found)
+		memcpy(domain_name, domain_lookup.domain_name, HOST_IDENTITY_NAME_LEN);
+	domain_lookup.finished = false;
+	pthread_mutex_unlock(&domain_lookup.lock);
+
+	if (!finished)
+		return false;
+
+	if (found)
+	{
+		ereport(DEBUG1, (errmsg("domain name extracted from FQDN: %s", domain_name)));
+		memcpy(identity->domain_name, domain_name, HOST_IDENTITY_NAME_LEN);
+		identity->has_domain_name = true;
+		identity->domain_from_dns = true;
+	}
+	else if (identity->domain_from_dns)
+	{
+		/* The host is no longer in DNS */
+		identity->has_domain_name = ReadLocalDomainName(identity->domain_name,
+														 HOST_IDENTITY_NAME_LEN);
+		identity->domain_from_dns = false;
+	}
+	else
+		return false;
+
+	return true;
+}
+
+static bool HostIdentityExpired(const HostIdentity *identity, TimestampTz now)
+{
+	return identity->refreshed_at == 0 ||
+		TimestampDifferenceExceeds(identity->refreshed_at, now, host_identity_ttl_s * 1000);
+}
+
+/*
+ * Publish the result of the DNS lookup, and refresh the identity when it
+ * expired.  Called by the background sampler.
+ */
+void SampleHostIdentity(void)
+{
+	HostIdentity *identity;
+	bool         changed;
+
+	if (host_identity_state == NULL)
+		return;
+
+	if (local_identity == NULL)
+	{
+		/* First iteration, resolve the domain of the identity the postmaster built */
+		local_identity = MemoryContextAlloc(TopMemoryContext, sizeof(HostIdentity));
+
+		LWLockAcquire(host_identity_state->lock, LW_SHARED);
+		memcpy(local_identity, &host_identity_state->identity, sizeof(HostIdentity));
+		LWLockRelease(host_identity_state->lock);
+
+		if (local_identity->has_host_name)
+			StartDomainLookup(local_identity->host_name);
+		return;
+	}
+
+	changed = CollectDomainLookup(local_identity);
+
+	if (HostIdentityExpired(local_identity, GetCurrentTimestamp()))
+	{
+		identity = palloc(sizeof(HostIdentity));
+		BuildHostIdentity(identity, local_identity);
+		memcpy(local_identity, identity, sizeof(HostIdentity));
+		pfree(identity);
+
+		if (local_identity->has_host_name)
+			StartDomainLookup(local_identity->host_name);
+		changed = true;
+	}
+
+	if (!changed)
+		return;
+
+	LWLockAcquire(host_identity_state->lock, LW_EXCLUSIVE);
+	memcpy(&host_identity_state->identity, local_identity, sizeof(HostIdentity));
+	LWLockRelease(host_identity_state->lock);
+}
+
+/*
+ * Copy the cached identity.  Without shared memory the backend keeps its
+ * own, and looks up the domain in the background for the following calls.
+ */
+void GetHostIdentity(HostIdentity *identity)
+{
+	if (host_identity_state != NULL)
+	{
+		LWLockAcquire(host_identity_state->lock, LW_SHARED);
+		memcpy(identity, &host_identity_state->identity, sizeof(HostIdentity));
+		LWLockRelease(host_identity_state->lock);
+		return;
+	}
+
+	if (local_identity == NULL)
+	{
+		local_identity = MemoryContextAllocZero(TopMemoryContext, sizeof(HostIdentity));
+		BuildHostIdentity(local_identity, NULL);
+		if (local_identity->has_host_name)
+			StartDomainLookup(local_identity->host_name);
+	}
+	else
+	{
+		CollectDomainLookup(local_identity);
+
+		if (HostIdentityExpired(local_identity, GetCurrentTimestamp()))
+		{
+			BuildHostIdentity(identity, local_identity);
+			memcpy(local_identity, identity, sizeof(HostIdentity));
+			if (local_identity->has_host_name)
+				StartDomainLookup(local_identity->host_name);
+		}
+	}
+
+	memcpy(identity, local_identity, sizeof(HostIdentity));
+}
@@ -0,0 +1,276 @@
+/*------------------------------------------------------------------------
+ * hugepage_info.c
+ *              Huge page and transparent huge page information
+ *
+ * Reports the hugetlb pools of every huge page size, the transparent huge
+ * page settings and counters, and how much of the main shared memory
+ * segment of the postmaster is backed by huge pages.  The latter tells
+ * whether huge_pages = try actually got huge pages.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#include <dirent.h>
+
+#include "miscadmin.h"
+
+#define HUGEPAGES_SYSFS_DIR         "/sys/kernel/mm/hugepages"
+#define THP_SYSFS_DIR               "/sys/kernel/mm/transparent_hugepage"
+#define THP_SETTING_LEN             128
+#define MAX_HUGEPAGE_SIZES          16
+
+/* transparent huge page counters of /proc/vmstat */
+static const char *const thp_vmstat_keys[] = {
+	"thp_fault_alloc", "thp_fault_fallback", "thp_collapse_alloc",
+	"thp_collapse_alloc_failed"
+};
+#define NUM_THP_VMSTAT_KEYS         lengthof(thp_vmstat_keys)
+
+/* the main shared memory segment of the postmaster */
+typedef struct shmem_mapping
+{
+	uint64 size_bytes;
+	uint64 page_size;
+	uint64 huge_bytes;
+} shmem_mapping;
+
+void ReadHugePageInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+static bool ReadThpSetting(const char *name, char *mode);
+static bool ReadShmemMapping(shmem_mapping *shmem);
+static int CompareUInt64(const void *a, const void *b);
+
+/*
+ * Read a transparent huge page setting.  The files list all choices with
+ * the active one in brackets, like "always [madvise] never".
+ */
+static bool ReadThpSetting(const char *name, char *mode)
+{
+	char file_name[MAXPGPATH];
+	char line[THP_SETTING_LEN];
+	char *start;
+	char *end;
+
+	snprintf(file_name, MAXPGPATH, "%s/%s", THP_SYSFS_DIR, name);
+	if (!ReadFileLine(file_name, line, THP_SETTING_LEN))
+		return false;
+
+	start = strchr(line, '[');
+	end = start ? strchr(start, ']') : NULL;
+	if (start == NULL || end == NULL)
+		return false;
+
+	*end = '\0';
+	strlcpy(mode, start + 1, THP_SETTING_LEN);
+
+	return true;
+}
+
+/*
+ * Find the main shared memory segment in /proc/<postmaster>/smaps.  It is
+ * the largest shared mapping of /anon_hugepage (MAP_HUGETLB), /dev/zero
+ * (anonymous shared memory) or /SYSV<key> (shared_memory_type = sysv).
+ * Huge page backed bytes are those in hugetlb pages plus the ones mapped
+ * by transparent huge pages.
+ */
+static bool ReadShmemMapping(shmem_mapping *shmem)
+{
+	FILE    *smaps_file;
+	char    file_name[MAXPGPATH];
+	char    *line_buf = NULL;
+	size_t  line_buf_size = 0;
+	char    perms[8];
+	char    path[MAXPGPATH];
+	char    key[64];
+	unsigned long start;
+	unsigned long end;
+	unsigned long long value;
+	bool    candidate = false;
+	shmem_mapping current;
+
+	memset(shmem, 0, sizeof(shmem_mapping));
+	memset(&current, 0, sizeof(shmem_mapping));
+	path[0] = '\0';
+
+	snprintf(file_name, MAXPGPATH, "/proc/%d/smaps", PostmasterPid);
+	smaps_file = fopen(file_name, "r");
+	if (!smaps_file)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("can not open file %s for reading shared memory mappings",
+						file_name)));
+		return false;
+	}
+
+	while (getline(&line_buf, &line_buf_size, smaps_file) >= 0)
+	{
+		/* Mapping header, "start-end perms offset dev inode path" */
+		if (sscanf(line_buf, "%lx-%lx %7s %*s %*s %*s %1023[^\n]",
+				   &start, &end, perms, path) >= 3)
+		{
+			if (candidate && current.size_bytes > shmem->size_bytes)
+				*shmem = current;
+
+			memset(&current, 0, sizeof(shmem_mapping));
+			current.size_bytes = end - start;
+			candidate = perms[3] == 's' &&
+				(strncmp(path, "/anon_hugepage", 14) == 0 ||
+				 strncmp(path, "/dev/zero", 9) == 0 ||
+				 strncmp(path, "/SYSV", 5) == 0);
+			path[0] = '\0';
+			continue;
+		}
+
+		if (!candidate || sscanf(line_buf, "%63[^:]: %llu", key, &value) != 2)
+			continue;
+
+		if (strcmp(key, "KernelPageSize") == 0)
+			current.page_size = value * 1024;
+		else if (strcmp(key, "Shared_Hugetlb") == 0 ||
+				 strcmp(key, "Private_Hugetlb") == 0 ||
+				 strcmp(key, "ShmemPmdMapped") == 0)
+			current.huge_bytes += value * 1024;
+	}
+
+	if (candidate && current.size_bytes > shmem->size_bytes)
+		*shmem = current;
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(smaps_file);
+
+	return shmem->size_bytes > 0;
+}
+
+static int CompareUInt64(const void *a, const void *b)
+{
+	uint64 va = *(const uint64 *) a;
+	uint64 vb = *(const uint64 *) b;
+
+	return (va > vb) - (va < vb);
+}
+
+void ReadHugePageInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum          values[Natts_hugepage_info];
+	bool           nulls[Natts_hugepage_info];
+	char           thp_enabled[THP_SETTING_LEN];
+	char           thp_defrag[THP_SETTING_LEN];
+	char           thp_shmem_enabled[THP_SETTING_LEN];
+	uint64         thp_counters[NUM_THP_VMSTAT_KEYS];
+	bool           thp_found[NUM_THP_VMSTAT_KEYS];
+	shmem_mapping  shmem;
+	uint64         page_sizes[MAX_HUGEPAGE_SIZES];
+	int            num_page_sizes = 0;
+	int            index;
+	DIR            *dirp;
+	struct dirent  *ent;
+
+	memset(nulls, 0, sizeof(nulls));
+
+	/* Settings and counters of the whole system, the same in every row */
+	if (ReadThpSetting("enabled", thp_enabled))
+		values[Anum_hp_thp_enabled] = CStringGetTextDatum(thp_enabled);
+	else
+		nulls[Anum_hp_thp_enabled] = true;
+
+	if (ReadThpSetting("defrag", thp_defrag))
+		values[Anum_hp_thp_defrag] = CStringGetTextDatum(thp_defrag);
+	else
+		nulls[Anum_hp_thp_defrag] = true;
+
+	if (ReadThpSetting("shmem_enabled", thp_shmem_enabled))
+		values[Anum_hp_thp_shmem_enabled] = CStringGetTextDatum(thp_shmem_enabled);
+	else
+		nulls[Anum_hp_thp_shmem_enabled] = true;
+
+	if (!ReadKeyValueFile(VMSTAT_FILE_NAME, thp_vmstat_keys, NUM_THP_VMSTAT_KEYS,
+						  thp_counters, thp_found))
+		memset(thp_found, 0, sizeof(thp_found));
+
+	for (index = 0; index < NUM_THP_VMSTAT_KEYS; index++)
+	{
+		if (thp_found[index])
+			values[Anum_hp_thp_fault_alloc + index] = UInt64GetDatum(thp_counters[index]);
+		else
+			nulls[Anum_hp_thp_fault_alloc + index] = true;
+	}
+
+	if (ReadShmemMapping(&shmem))
+	{
+		values[Anum_hp_shmem_size_bytes] = UInt64GetDatum(shmem.size_bytes);
+		values[Anum_hp_shmem_page_size] = UInt64GetDatum(shmem.page_size);
+		values[Anum_hp_shmem_huge_bytes] = UInt64GetDatum(shmem.huge_bytes);
+	}
+	else
+	{
+		nulls[Anum_hp_shmem_size_bytes] = true;
+		nulls[Anum_hp_shmem_page_size] = true;
+		nulls[Anum_hp_shmem_huge_bytes] = true;
+	}
+
+	/* Every supported huge page size has a hugepages-<size>kB directory */
+	dirp = opendir(HUGEPAGES_SYSFS_DIR);
+	if (dirp)
+	{
+		while ((ent = readdir(dirp)) != NULL && num_page_sizes < MAX_HUGEPAGE_SIZES)
+		{
+			unsigned long size_kb;
+
+			if (sscanf(ent->d_name, "hugepages-%lukB", &size_kb) == 1)
+				page_sizes[num_page_sizes++] = (uint64) size_kb;
+		}
+
+		closedir(dirp);
+	}
+
+	qsort(page_sizes, num_page_sizes, sizeof(uint64), CompareUInt64);
+
+	for (index = 0; index < num_page_sizes; index++)
+	{
+		char   file_name[MAXPGPATH];
+		uint64 total_pages = 0;
+		uint64 free_pages = 0;
+		uint64 reserved_pages = 0;
+		uint64 surplus_pages = 0;
+
+		snprintf(file_name, MAXPGPATH, "%s/hugepages-%lukB/nr_hugepages",
+				 HUGEPAGES_SYSFS_DIR, (unsigned long) page_sizes[index]);
+		ReadFileContent(file_name, &total_pages);
+		snprintf(file_name, MAXPGPATH, "%s/hugepages-%lukB/free_hugepages",
+				 HUGEPAGES_SYSFS_DIR, (unsigned long) page_sizes[index]);
+		ReadFileContent(file_name, &free_pages);
+		snprintf(file_name, MAXPGPATH, "%s/hugepages-%lukB/resv_hugepages",
+				 HUGEPAGES_SYSFS_DIR, (unsigned long) page_sizes[index]);
+		ReadFileContent(file_name, &reserved_pages);
+		snprintf(file_name, MAXPGPATH, "%s/hugepages-%lukB/surplus_hugepages",
+				 HUGEPAGES_SYSFS_DIR, (unsigned long) page_sizes[index]);
+		ReadFileContent(file_name, &surplus_pages);
+
+		values[Anum_hp_page_size] = UInt64GetDatum(page_sizes[index] * 1024);
+		values[Anum_hp_total_pages] = UInt64GetDatum(total_pages);
+		values[Anum_hp_free_pages] = UInt64GetDatum(free_pages);
+		values[Anum_hp_reserved_pages] = UInt64GetDatum(reserved_pages);
+		values[Anum_hp_surplus_pages] = UInt64GetDatum(surplus_pages);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	/* Without hugetlb support, still report THP and the shared memory */
+	if (num_page_sizes == 0)
+	{
+		nulls[Anum_hp_page_size] = true;
+		nulls[Anum_hp_total_pages] = true;
+		nulls[Anum_hp_free_pages] = true;
+		nulls[Anum_hp_reserved_pages] = true;
+		nulls[Anum_hp_surplus_pages] = true;
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+}
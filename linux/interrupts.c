@@ -0,0 +1,436 @@
+/*------------------------------------------------------------------------
+ * interrupts.c
+ *              Interrupt, softirq and softnet distribution per CPU
+ *
+ * On hosts with fast NICs the network interrupts and the NET_RX softirqs
+ * they raise often land on one or two CPUs, which then saturate while the
+ * average CPU usage stays low.  Each counter is reported per CPU with its
+ * rate since the previous call, its share of the rate of all CPUs and an
+ * imbalance score: 0 when the rate is spread evenly over the CPUs, 1 when
+ * a single CPU takes all of it.
+ *
+ * /proc/interrupts and /proc/softirqs have a column per online CPU, so the
+ * lines are long on large hosts; they are parsed with strtoull() in a
+ * single pass over a buffer reused for every line.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#define INTERRUPTS_FILE_NAME        "/proc/interrupts"
+#define SOFTIRQS_FILE_NAME          "/proc/softirqs"
+#define SOFTNET_STAT_FILE_NAME      "/proc/net/softnet_stat"
+#define INTERRUPT_NAME_LEN          32
+#define SOFTNET_MAX_COLUMNS         16
+
+/* columns of /proc/net/softnet_stat, in hexadecimal */
+#define SOFTNET_PROCESSED           0
+#define SOFTNET_DROPPED             1
+#define SOFTNET_TIME_SQUEEZE        2
+#define SOFTNET_RECEIVED_RPS        9
+#define SOFTNET_FLOW_LIMIT_COUNT    10
+#define SOFTNET_BACKLOG_LEN         11          /* Linux 5.10 and later */
+#define SOFTNET_CPU                 12          /* Linux 5.10 and later */
+
+static CounterBaseline interrupts_baseline;
+static CounterBaseline softirqs_baseline;
+static CounterBaseline softnet_baseline;
+
+void ReadInterrupts(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadSoftirqs(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadSoftnetStat(Tuplestorestate *tupstore, TupleDesc tupdesc);
+static void ReadInterruptTable(const char *file_name, CounterBaseline *baseline,
+		Tuplestorestate *tupstore, TupleDesc tupdesc, bool softirqs);
+static int ReadCPUColumns(const char *header, int **cpus);
+static void CollapseSpaces(char *str);
+static bool ImbalanceScore(const float8 *rates, const bool *has_rate, int num_cpus,
+		float8 *total, float8 *imbalance);
+
+/* CPU numbers of the "CPU0 CPU1 ..." header, offline CPUs have no column */
+static int ReadCPUColumns(const char *header, int **cpus)
+{
+	const char *pos = header;
+	int        size = 64;
+	int        num_cpus = 0;
+
+	*cpus = palloc(size * sizeof(int));
+
+	while ((pos = strstr(pos, "CPU")) != NULL)
+	{
+		char *end;
+		long cpu = strtol(pos + 3, &end, 10);
+
+		if (end != pos + 3)
+		{
+			if (num_cpus == size)
+			{
+				size *= 2;
+				*cpus = repalloc(*cpus, size * sizeof(int));
+			}
+			(*cpus)[num_cpus++] = (int) cpu;
+		}
+		pos = end;
+	}
+
+	return num_cpus;
+}
+
+/* Replace the runs of blanks by single spaces, in place */
+static void CollapseSpaces(char *str)
+{
+	char *src = str;
+	char *dst = str;
+
+	while (*src == ' ' || *src == '\t')
+		src++;
+
+	while (*src != '\0' && *src != '\n')
+	{
+		if (*src == ' ' || *src == '\t')
+		{
+			while (*src == ' ' || *src == '\t')
+				src++;
+			if (*src != '\0' && *src != '\n')
+				*dst++ = ' ';
+			continue;
+		}
+		*dst++ = *src++;
+	}
+	*dst = '\0';
+}
+
+/*
+ * Sum of the rates and imbalance score of the CPUs: the share of the
+ * busiest CPU above an even share, scaled so that it reaches 1 when one CPU
+ * has all of the rate.  Returns false unless every CPU has a rate.
+ */
+static bool ImbalanceScore(const float8 *rates, const bool *has_rate, int num_cpus,
+		float8 *total, float8 *imbalance)
+{
+	float8 max_rate = 0;
+	int    index;
+
+	*total = 0;
+	for (index = 0; index < num_cpus; index++)
+	{
+		if (!has_rate[index])
+			return false;
+
+		*total += rates[index];
+		max_rate = Max(max_rate, rates[index]);
+	}
+
+	if (num_cpus < 2 || *total <= 0)
+		*imbalance = 0;
+	else
+		*imbalance = (max_rate / *total - 1.0 / num_cpus) / (1.0 - 1.0 / num_cpus);
+
+	return true;
+}
+
+/*
+ * /proc/interrupts and /proc/softirqs both have a line per source, its name
+ * followed by a colon and a count per CPU column.  Interrupt lines end with
+ * the chip, the hardware IRQ and the devices, or a description for the
+ * architecture specific ones.  Lines with fewer counts than CPUs, like ERR
+ * and MIS, are not per CPU and skipped.
+ */
+static void ReadInterruptTable(const char *file_name, CounterBaseline *baseline,
+		Tuplestorestate *tupstore, TupleDesc tupdesc, bool softirqs)
+{
+	Datum   values[Natts_interrupts];
+	bool    nulls[Natts_interrupts];
+	FILE    *fp;
+	char    *line_buf = NULL;
+	size_t  line_buf_size = 0;
+	int     *cpus;
+	int     num_cpus;
+	uint64  *counts;
+	float8  *rates;
+	bool    *has_rate;
+	char    key[COUNTER_BASELINE_KEY_LEN];
+
+	fp = fopen(file_name, "r");
+	if (!fp)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("can not open file %s for reading interrupt information",
+						file_name)));
+		return;
+	}
+
+	if (getline(&line_buf, &line_buf_size, fp) < 0 ||
+		(num_cpus = ReadCPUColumns(line_buf, &cpus)) == 0)
+	{
+		if (line_buf != NULL)
+			free(line_buf);
+		fclose(fp);
+		return;
+	}
+
+	counts = palloc(num_cpus * sizeof(uint64));
+	rates = palloc(num_cpus * sizeof(float8));
+	has_rate = palloc(num_cpus * sizeof(bool));
+
+	counter_baseline_begin(baseline);
+
+	while (getline(&line_buf, &line_buf_size, fp) >= 0)
+	{
+		char   name[INTERRUPT_NAME_LEN];
+		char   *colon = strchr(line_buf, ':');
+		char   *pos;
+		char   *end;
+		float8 total;
+		float8 imbalance;
+		bool   has_imbalance;
+		int    index;
+
+		if (colon == NULL)
+			continue;
+
+		*colon = '\0';
+		pos = line_buf;
+		while (*pos == ' ')
+			pos++;
+		strlcpy(name, pos, INTERRUPT_NAME_LEN);
+
+		pos = colon + 1;
+		for (index = 0; index < num_cpus; index++)
+		{
+			counts[index] = strtoull(pos, &end, 10);
+			if (end == pos)
+				break;
+			pos = end;
+		}
+		if (index < num_cpus)
+			continue;
+
+		for (index = 0; index < num_cpus; index++)
+		{
+			snprintf(key, COUNTER_BASELINE_KEY_LEN, "%s/%d", name, cpus[index]);
+			has_rate[index] = counter_baseline_rate(baseline, key, counts[index], &rates[index]);
+		}
+
+		has_imbalance = ImbalanceScore(rates, has_rate, num_cpus, &total, &imbalance);
+
+		memset(nulls, 0, sizeof(nulls));
+
+		values[Anum_irq_name] = CStringGetTextDatum(name);
+
+		/* Softirqs have the same columns, without the description */
+		if (!softirqs)
+		{
+			CollapseSpaces(pos);
+			values[Anum_irq_description] = CStringGetTextDatum(pos);
+		}
+
+		if (has_imbalance)
+			values[Anum_irq_imbalance] = Float8GetDatum(imbalance);
+		else
+			nulls[Anum_irq_imbalance] = true;
+
+		for (index = 0; index < num_cpus; index++)
+		{
+			values[Anum_irq_cpu] = Int32GetDatum(cpus[index]);
+			values[Anum_irq_count] = UInt64GetDatum(counts[index]);
+
+			if (has_rate[index])
+			{
+				values[Anum_irq_per_sec] = Float8GetDatum(rates[index]);
+				nulls[Anum_irq_per_sec] = false;
+			}
+			else
+				nulls[Anum_irq_per_sec] = true;
+
+			if (has_imbalance)
+			{
+				values[Anum_irq_share_percent] = Float8GetDatum(total > 0 ? rates[index] * 100 / total : 0);
+				nulls[Anum_irq_share_percent] = false;
+			}
+			else
+				nulls[Anum_irq_share_percent] = true;
+
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+
+	counter_baseline_end(baseline);
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(fp);
+
+	pfree(cpus);
+	pfree(counts);
+	pfree(rates);
+	pfree(has_rate);
+}
+
+void ReadInterrupts(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ReadInterruptTable(INTERRUPTS_FILE_NAME, &interrupts_baseline, tupstore, tupdesc, false);
+}
+
+void ReadSoftirqs(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ReadInterruptTable(SOFTIRQS_FILE_NAME, &softirqs_baseline, tupstore, tupdesc, true);
+}
+
+/*
+ * A line per CPU with its packet processing counters.  Before Linux 5.10
+ * the lines have no CPU number and offline CPUs are skipped, so the CPU is
+ * taken to be the line number.
+ */
+void ReadSoftnetStat(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum   values[Natts_softnet_stat];
+	bool    nulls[Natts_softnet_stat];
+	FILE    *fp;
+	char    *line_buf = NULL;
+	size_t  line_buf_size = 0;
+	int     size = 64;
+	int     num_cpus = 0;
+	uint64  (*columns)[SOFTNET_MAX_COLUMNS];
+	int     *num_columns;
+	int     *cpus;
+	float8  *rates;
+	bool    *has_rate;
+	float8  total;
+	float8  imbalance;
+	bool    has_imbalance;
+	int     index;
+
+	fp = fopen(SOFTNET_STAT_FILE_NAME, "r");
+	if (!fp)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("can not open file %s for reading softnet information",
+						SOFTNET_STAT_FILE_NAME)));
+		return;
+	}
+
+	columns = palloc(size * sizeof(*columns));
+	num_columns = palloc(size * sizeof(int));
+
+	while (getline(&line_buf, &line_buf_size, fp) >= 0)
+	{
+		char *pos = line_buf;
+		char *end;
+		int  column = 0;
+
+		if (num_cpus == size)
+		{
+			size *= 2;
+			columns = repalloc(columns, size * sizeof(*columns));
+			num_columns = repalloc(num_columns, size * sizeof(int));
+		}
+
+		while (column < SOFTNET_MAX_COLUMNS)
+		{
+			uint64 value = strtoull(pos, &end, 16);
+
+			if (end == pos)
+				break;
+			columns[num_cpus][column++] = value;
+			pos = end;
+		}
+
+		if (column <= SOFTNET_FLOW_LIMIT_COUNT)
+			continue;
+
+		num_columns[num_cpus++] = column;
+	}
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(fp);
+
+	/* The baselines are keyed by CPU, as lines shift when CPUs go offline */
+	cpus = palloc(Max(num_cpus, 1) * sizeof(int));
+	for (index = 0; index < num_cpus; index++)
+		cpus[index] = num_columns[index] > SOFTNET_CPU ? (int) columns[index][SOFTNET_CPU] : index;
+
+	rates = palloc(Max(num_cpus, 1) * sizeof(float8));
+	has_rate = palloc(Max(num_cpus, 1) * sizeof(bool));
+
+	/* The imbalance is the one of the packets processed */
+	counter_baseline_begin(&softnet_baseline);
+	for (index = 0; index < num_cpus; index++)
+	{
+		char key[COUNTER_BASELINE_KEY_LEN];
+
+		snprintf(key, COUNTER_BASELINE_KEY_LEN, "processed/%d", cpus[index]);
+		has_rate[index] = counter_baseline_rate(&softnet_baseline, key,
+												columns[index][SOFTNET_PROCESSED], &rates[index]);
+	}
+
+	has_imbalance = ImbalanceScore(rates, has_rate, num_cpus, &total, &imbalance);
+
+	for (index = 0; index < num_cpus; index++)
+	{
+		uint64 *column = columns[index];
+		char   key[COUNTER_BASELINE_KEY_LEN];
+		float8 rate;
+
+		memset(nulls, 0, sizeof(nulls));
+
+		values[Anum_softnet_cpu] = Int32GetDatum(cpus[index]);
+
+		values[Anum_softnet_processed] = UInt64GetDatum(column[SOFTNET_PROCESSED]);
+		if (has_rate[index])
+			values[Anum_softnet_processed_per_sec] = Float8GetDatum(rates[index]);
+		else
+			nulls[Anum_softnet_processed_per_sec] = true;
+
+		values[Anum_softnet_dropped] = UInt64GetDatum(column[SOFTNET_DROPPED]);
+		snprintf(key, COUNTER_BASELINE_KEY_LEN, "dropped/%d", cpus[index]);
+		if (counter_baseline_rate(&softnet_baseline, key, column[SOFTNET_DROPPED], &rate))
+			values[Anum_softnet_dropped_per_sec] = Float8GetDatum(rate);
+		else
+			nulls[Anum_softnet_dropped_per_sec] = true;
+
+		values[Anum_softnet_time_squeeze] = UInt64GetDatum(column[SOFTNET_TIME_SQUEEZE]);
+		snprintf(key, COUNTER_BASELINE_KEY_LEN, "time_squeeze/%d", cpus[index]);
+		if (counter_baseline_rate(&softnet_baseline, key, column[SOFTNET_TIME_SQUEEZE], &rate))
+			values[Anum_softnet_time_squeeze_per_sec] = Float8GetDatum(rate);
+		else
+			nulls[Anum_softnet_time_squeeze_per_sec] = true;
+
+		values[Anum_softnet_received_rps] = UInt64GetDatum(column[SOFTNET_RECEIVED_RPS]);
+		values[Anum_softnet_flow_limit_count] = UInt64GetDatum(column[SOFTNET_FLOW_LIMIT_COUNT]);
+
+		if (num_columns[index] > SOFTNET_BACKLOG_LEN)
+			values[Anum_softnet_backlog_length] = UInt64GetDatum(column[SOFTNET_BACKLOG_LEN]);
+		else
+			nulls[Anum_softnet_backlog_length] = true;
+
+		if (has_imbalance)
+		{
+			values[Anum_softnet_share_percent] = Float8GetDatum(total > 0 ? rates[index] * 100 / total : 0);
+			values[Anum_softnet_imbalance] = Float8GetDatum(imbalance);
+		}
+		else
+		{
+			nulls[Anum_softnet_share_percent] = true;
+			nulls[Anum_softnet_imbalance] = true;
+		}
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	counter_baseline_end(&softnet_baseline);
+
+	pfree(columns);
+	pfree(num_columns);
+	pfree(cpus);
+	pfree(rates);
+	pfree(has_rate);
+}
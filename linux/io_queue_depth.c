@@ -0,0 +1,240 @@
+/*------------------------------------------------------------------------
+ * io_queue_depth.c
+ *              Queue depth histograms of block devices
+ *
+ * The in-flight column of /proc/diskstats is sampled by the background
+ * sampler, and a histogram of the observed queue depths is kept per device
+ * in shared memory.  This shows IO bursts which the averages computed from
+ * the cumulative counters smooth away.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#include <fcntl.h>
+
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/memutils.h"
+
+#define QUEUE_DEPTH_MAX_DEVICES     128
+#define QUEUE_DEPTH_DEVICE_NAME_LEN 32
+#define QUEUE_DEPTH_READ_BUFFER     65536
+
+/*
+ * Queue depths are counted in power of two buckets: 0, 1, 2-3, 4-7, 8-15,
+ * 16-31, 32-63 and 64 or more IOs in flight.
+ */
+#define QUEUE_DEPTH_BUCKETS         8
+
+typedef struct QueueDepthDevice
+{
+	char    device_name[QUEUE_DEPTH_DEVICE_NAME_LEN];
+	uint64  samples;
+	uint64  depth_sum;
+	uint32  current_depth;
+	uint32  max_depth;
+	uint64  histogram[QUEUE_DEPTH_BUCKETS];
+} QueueDepthDevice;
+
+typedef struct QueueDepthState
+{
+	LWLock           *lock;
+	int              num_devices;
+	QueueDepthDevice devices[QUEUE_DEPTH_MAX_DEVICES];
+} QueueDepthState;
+
+static QueueDepthState *queue_depth_state = NULL;
+
+/* /proc/diskstats is kept open by the sampler and re-read from the start */
+static int    diskstats_fd = -1;
+static char   *diskstats_buf = NULL;
+static size_t diskstats_buf_size = 0;
+
+void ReadIOQueueDepthInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+static int QueueDepthBucket(uint32 depth);
+static QueueDepthDevice *LookupQueueDepthDevice(const char *device_name);
+
+Size IOQueueDepthShmemSize(void)
+{
+	return MAXALIGN(sizeof(QueueDepthState));
+}
+
+void IOQueueDepthShmemInit(void)
+{
+	bool found;
+
+	queue_depth_state = ShmemInitStruct("system_stats io queue depth",
+										IOQueueDepthShmemSize(), &found);
+	if (!found)
+	{
+		memset(queue_depth_state, 0, IOQueueDepthShmemSize());
+		queue_depth_state->lock =
+			&(GetNamedLWLockTranche(SYSTEM_STATS_LWLOCK_TRANCHE))[SAMPLER_LOCK_IO_QUEUE_DEPTH].lock;
+	}
+}
+
+/* Histogram bucket of the given queue depth */
+static int QueueDepthBucket(uint32 depth)
+{
+	int bucket = 0;
+
+	while (depth > 0 && bucket < QUEUE_DEPTH_BUCKETS - 1)
+	{
+		depth >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+/* Find the slot of a device, adding it if there is room.  Caller holds the lock. */
+static QueueDepthDevice *LookupQueueDepthDevice(const char *device_name)
+{
+	QueueDepthDevice *device;
+	int              index;
+
+	for (index = 0; index < queue_depth_state->num_devices; index++)
+	{
+		if (strcmp(queue_depth_state->devices[index].device_name, device_name) == 0)
+			return &queue_depth_state->devices[index];
+	}
+
+	if (queue_depth_state->num_devices == QUEUE_DEPTH_MAX_DEVICES)
+		return NULL;
+
+	device = &queue_depth_state->devices[queue_depth_state->num_devices++];
+	memset(device, 0, sizeof(QueueDepthDevice));
+	strlcpy(device->device_name, device_name, QUEUE_DEPTH_DEVICE_NAME_LEN);
+
+	return device;
+}
+
+/*
+ * Take one sample of the number of IOs in flight of every block device.
+ * Called by the background sampler, so it avoids allocating memory and
+ * reopening the file on every sample; the buffer only grows when the file
+ * no longer fits, and is reused.
+ */
+void SampleIOQueueDepth(void)
+{
+	char     *line;
+	char     *next_line;
+	char     device_name[QUEUE_DEPTH_DEVICE_NAME_LEN];
+	uint32   in_flight;
+	ssize_t  len;
+	size_t   total = 0;
+	const char *scan_fmt = "%*u %*u %31s %*u %*u %*u %*u %*u %*u %*u %*u %u";
+
+	if (queue_depth_state == NULL)
+		return;
+
+	if (diskstats_fd < 0)
+	{
+		diskstats_fd = open(DISK_IO_STATS_FILE_NAME, O_RDONLY);
+		if (diskstats_fd < 0)
+			return;
+		diskstats_buf_size = QUEUE_DEPTH_READ_BUFFER;
+		diskstats_buf = MemoryContextAlloc(TopMemoryContext, diskstats_buf_size);
+	}
+
+	if (lseek(diskstats_fd, 0, SEEK_SET) < 0)
+		return;
+
+	/* Hosts with many devices outgrow the buffer, which then grows once */
+	while ((len = read(diskstats_fd, diskstats_buf + total,
+					   diskstats_buf_size - 1 - total)) > 0)
+	{
+		total += len;
+		if (total == diskstats_buf_size - 1)
+		{
+			diskstats_buf_size *= 2;
+			diskstats_buf = repalloc(diskstats_buf, diskstats_buf_size);
+		}
+	}
+	diskstats_buf[total] = '\0';
+
+	LWLockAcquire(queue_depth_state->lock, LW_EXCLUSIVE);
+
+	for (line = diskstats_buf; line != NULL && *line != '\0'; line = next_line)
+	{
+		QueueDepthDevice *device;
+
+		next_line = strchr(line, '\n');
+		if (next_line != NULL)
+			*next_line++ = '\0';
+
+		if (sscanf(line, scan_fmt, device_name, &in_flight) != 2)
+			continue;
+
+		/* Loop and RAM disks only add noise */
+		if (strncmp(device_name, "loop", 4) == 0 || strncmp(device_name, "ram", 3) == 0)
+			continue;
+
+		device = LookupQueueDepthDevice(device_name);
+		if (device == NULL)
+			continue;
+
+		device->samples++;
+		device->depth_sum += in_flight;
+		device->current_depth = in_flight;
+		device->max_depth = Max(device->max_depth, in_flight);
+		device->histogram[QueueDepthBucket(in_flight)]++;
+	}
+
+	LWLockRelease(queue_depth_state->lock);
+}
+
+void ReadIOQueueDepthInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum            values[Natts_io_queue_depth];
+	bool             nulls[Natts_io_queue_depth];
+	QueueDepthDevice *devices;
+	int              num_devices;
+	int              index;
+	int              bucket;
+
+	memset(nulls, 0, sizeof(nulls));
+
+	if (queue_depth_state == NULL)
+	{
+		ereport(DEBUG1,
+				(errmsg("io queue depth sampling requires system_stats in shared_preload_libraries")));
+		return;
+	}
+
+	/* Copy the histograms so that the sampler is not blocked while building tuples */
+	LWLockAcquire(queue_depth_state->lock, LW_SHARED);
+	num_devices = queue_depth_state->num_devices;
+	devices = palloc(Max(num_devices, 1) * sizeof(QueueDepthDevice));
+	memcpy(devices, queue_depth_state->devices, num_devices * sizeof(QueueDepthDevice));
+	LWLockRelease(queue_depth_state->lock);
+
+	for (index = 0; index < num_devices; index++)
+	{
+		QueueDepthDevice *device = &devices[index];
+
+		values[Anum_qd_device_name] = CStringGetTextDatum(device->device_name);
+		values[Anum_qd_samples] = UInt64GetDatum(device->samples);
+		values[Anum_qd_current_depth] = Int32GetDatum((int32) device->current_depth);
+		values[Anum_qd_max_depth] = Int32GetDatum((int32) device->max_depth);
+
+		if (device->samples > 0)
+			values[Anum_qd_avg_depth] = Float8GetDatum((float8) device->depth_sum / device->samples);
+		else
+			nulls[Anum_qd_avg_depth] = true;
+
+		for (bucket = 0; bucket < QUEUE_DEPTH_BUCKETS; bucket++)
+			values[Anum_qd_depth_0 + bucket] = UInt64GetDatum(device->histogram[bucket]);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+
+		nulls[Anum_qd_avg_depth] = false;
+	}
+
+	pfree(devices);
+}
@@ -0,0 +1,301 @@
+/*------------------------------------------------------------------------
+ * memory_fragmentation.c
+ *              Physical memory fragmentation and compaction information
+ *
+ * /proc/buddyinfo lists the free blocks of every order of every zone.  A
+ * huge page can only be allocated without compaction from a free block of
+ * at least its order, so the blocks of those orders give an estimate of
+ * how many huge pages each node could still allocate right away.  When
+ * debugfs is readable, the kernel's fragmentation index of each order is
+ * reported too: values towards 0 mean an allocation would fail for lack of
+ * memory, towards 1 for fragmentation, and -1 that it would succeed.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#include <unistd.h>
+
+#define BUDDYINFO_FILE_NAME         "/proc/buddyinfo"
+#define EXTFRAG_INDEX_FILE_NAME     "/sys/kernel/debug/extfrag/extfrag_index"
+#define DEFAULT_HUGEPAGE_SIZE       (2 * 1024 * 1024)
+#define MAX_BUDDY_ORDERS            16
+#define MAX_BUDDY_ZONES             256
+#define ZONE_NAME_LEN               32
+
+/* free blocks of a zone */
+typedef struct buddy_zone
+{
+	int    node;
+	char   zone[ZONE_NAME_LEN];
+	int    num_orders;
+	uint64 free_blocks[MAX_BUDDY_ORDERS];
+	float8 frag_index[MAX_BUDDY_ORDERS];
+	bool   has_frag_index;
+} buddy_zone;
+
+/* reclaim and compaction stalls from /proc/vmstat */
+typedef struct stall_counters
+{
+	uint64 compact_stall;
+	uint64 compact_fail;
+	uint64 allocstall;
+	bool   found;
+} stall_counters;
+
+static CounterBaseline fragmentation_baseline;
+
+void ReadMemoryFragmentation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+static int ReadBuddyInfo(buddy_zone *zones);
+static void ReadExtfragIndex(buddy_zone *zones, int num_zones);
+static void ReadStallCounters(stall_counters *stalls);
+
+/* Read "Node <n>, zone <name> <free blocks of order 0> ..." lines */
+static int ReadBuddyInfo(buddy_zone *zones)
+{
+	FILE    *fp;
+	char    *line_buf = NULL;
+	size_t  line_buf_size = 0;
+	int     num_zones = 0;
+
+	fp = fopen(BUDDYINFO_FILE_NAME, "r");
+	if (!fp)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("can not open file %s for reading memory fragmentation",
+						BUDDYINFO_FILE_NAME)));
+		return 0;
+	}
+
+	while (num_zones < MAX_BUDDY_ZONES && getline(&line_buf, &line_buf_size, fp) >= 0)
+	{
+		buddy_zone *zone = &zones[num_zones];
+		char       *pos;
+		int        consumed;
+		unsigned long long blocks;
+
+		if (sscanf(line_buf, "Node %d, zone %31s%n", &zone->node, zone->zone, &consumed) != 2)
+			continue;
+
+		zone->num_orders = 0;
+		zone->has_frag_index = false;
+		pos = line_buf + consumed;
+		while (zone->num_orders < MAX_BUDDY_ORDERS &&
+			   sscanf(pos, "%llu%n", &blocks, &consumed) == 1)
+		{
+			zone->free_blocks[zone->num_orders++] = blocks;
+			pos += consumed;
+		}
+
+		num_zones++;
+	}
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(fp);
+
+	return num_zones;
+}
+
+/* The index file has the layout of buddyinfo, it needs debugfs access */
+static void ReadExtfragIndex(buddy_zone *zones, int num_zones)
+{
+	FILE    *fp;
+	char    *line_buf = NULL;
+	size_t  line_buf_size = 0;
+
+	fp = fopen(EXTFRAG_INDEX_FILE_NAME, "r");
+	if (!fp)
+		return;
+
+	while (getline(&line_buf, &line_buf_size, fp) >= 0)
+	{
+		char   zone_name[ZONE_NAME_LEN];
+		char   *pos;
+		int    node;
+		int    consumed;
+		int    index;
+
+		if (sscanf(line_buf, "Node %d, zone %31s%n", &node, zone_name, &consumed) != 2)
+			continue;
+
+		for (index = 0; index < num_zones; index++)
+		{
+			buddy_zone *zone = &zones[index];
+			int        order = 0;
+			double     frag_index;
+
+			if (zone->node != node || strcmp(zone->zone, zone_name) != 0)
+				continue;
+
+			pos = line_buf + consumed;
+			while (order < zone->num_orders &&
+				   sscanf(pos, "%lf%n", &frag_index, &consumed) == 1)
+			{
+				zone->frag_index[order++] = frag_index;
+				pos += consumed;
+			}
+			zone->has_frag_index = order == zone->num_orders;
+			break;
+		}
+	}
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(fp);
+}
+
+/* allocstall is split per zone type (allocstall_normal, ...) since Linux 4.8 */
+static void ReadStallCounters(stall_counters *stalls)
+{
+	FILE    *fp;
+	char    *line_buf = NULL;
+	size_t  line_buf_size = 0;
+	char    name[64];
+	unsigned long long value;
+
+	memset(stalls, 0, sizeof(stall_counters));
+
+	fp = fopen(VMSTAT_FILE_NAME, "r");
+	if (!fp)
+		return;
+
+	while (getline(&line_buf, &line_buf_size, fp) >= 0)
+	{
+		if (sscanf(line_buf, "%63s %llu", name, &value) != 2)
+			continue;
+
+		if (strcmp(name, "compact_stall") == 0)
+			stalls->compact_stall = value;
+		else if (strcmp(name, "compact_fail") == 0)
+			stalls->compact_fail = value;
+		else if (strncmp(name, "allocstall", 10) == 0)
+			stalls->allocstall += value;
+	}
+
+	stalls->found = true;
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(fp);
+}
+
+void ReadMemoryFragmentation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum          values[Natts_memory_fragmentation];
+	bool           nulls[Natts_memory_fragmentation];
+	buddy_zone     *zones;
+	int            num_zones;
+	stall_counters stalls;
+	MeminfoSample  meminfo;
+	uint64         page_size = (uint64) sysconf(_SC_PAGESIZE);
+	uint64         hugepage_size = DEFAULT_HUGEPAGE_SIZE;
+	int            hugepage_order = 0;
+	float8         rate;
+	int            index;
+
+	zones = palloc(MAX_BUDDY_ZONES * sizeof(buddy_zone));
+	num_zones = ReadBuddyInfo(zones);
+	if (num_zones == 0)
+	{
+		pfree(zones);
+		return;
+	}
+
+	ReadExtfragIndex(zones, num_zones);
+	ReadStallCounters(&stalls);
+
+	memset(nulls, 0, sizeof(nulls));
+
+	/* Stall counters of the whole system, the same in every row */
+	if (stalls.found)
+	{
+		counter_baseline_begin(&fragmentation_baseline);
+
+		values[Anum_mfrag_compact_stall] = UInt64GetDatum(stalls.compact_stall);
+		if (counter_baseline_rate(&fragmentation_baseline, "compact_stall", stalls.compact_stall, &rate))
+			values[Anum_mfrag_compact_stall_per_sec] = Float8GetDatum(rate);
+		else
+			nulls[Anum_mfrag_compact_stall_per_sec] = true;
+
+		values[Anum_mfrag_compact_fail] = UInt64GetDatum(stalls.compact_fail);
+		if (counter_baseline_rate(&fragmentation_baseline, "compact_fail", stalls.compact_fail, &rate))
+			values[Anum_mfrag_compact_fail_per_sec] = Float8GetDatum(rate);
+		else
+			nulls[Anum_mfrag_compact_fail_per_sec] = true;
+
+		values[Anum_mfrag_allocstall] = UInt64GetDatum(stalls.allocstall);
+		if (counter_baseline_rate(&fragmentation_baseline, "allocstall", stalls.allocstall, &rate))
+			values[Anum_mfrag_allocstall_per_sec] = Float8GetDatum(rate);
+		else
+			nulls[Anum_mfrag_allocstall_per_sec] = true;
+
+		counter_baseline_end(&fragmentation_baseline);
+	}
+	else
+	{
+		nulls[Anum_mfrag_compact_stall] = true;
+		nulls[Anum_mfrag_compact_stall_per_sec] = true;
+		nulls[Anum_mfrag_compact_fail] = true;
+		nulls[Anum_mfrag_compact_fail_per_sec] = true;
+		nulls[Anum_mfrag_allocstall] = true;
+		nulls[Anum_mfrag_allocstall_per_sec] = true;
+	}
+
+	/* The order of the default huge page size */
+	if (ReadMeminfo(&meminfo) && meminfo.present[MEMINFO_HUGEPAGESIZE] &&
+		meminfo.values[MEMINFO_HUGEPAGESIZE] > 0)
+		hugepage_size = meminfo.values[MEMINFO_HUGEPAGESIZE];
+	while ((page_size << hugepage_order) < hugepage_size)
+		hugepage_order++;
+
+	for (index = 0; index < num_zones; index++)
+	{
+		buddy_zone *zone = &zones[index];
+		uint64     node_hugepages = 0;
+		int        other;
+		int        order;
+
+		/* Huge pages the whole node could allocate from its free blocks */
+		for (other = 0; other < num_zones; other++)
+		{
+			if (zones[other].node != zone->node)
+				continue;
+
+			for (order = hugepage_order; order < zones[other].num_orders; order++)
+				node_hugepages += zones[other].free_blocks[order] << (order - hugepage_order);
+		}
+
+		values[Anum_mfrag_node] = Int32GetDatum(zone->node);
+		values[Anum_mfrag_zone] = CStringGetTextDatum(zone->zone);
+		values[Anum_mfrag_hugepages_allocatable] = UInt64GetDatum(node_hugepages);
+
+		for (order = 0; order < zone->num_orders; order++)
+		{
+			values[Anum_mfrag_block_order] = Int32GetDatum(order);
+			values[Anum_mfrag_block_bytes] = UInt64GetDatum(page_size << order);
+			values[Anum_mfrag_free_blocks] = UInt64GetDatum(zone->free_blocks[order]);
+			values[Anum_mfrag_free_bytes] = UInt64GetDatum(zone->free_blocks[order] * (page_size << order));
+
+			if (zone->has_frag_index)
+			{
+				values[Anum_mfrag_fragmentation_index] = Float8GetDatum(zone->frag_index[order]);
+				nulls[Anum_mfrag_fragmentation_index] = false;
+			}
+			else
+				nulls[Anum_mfrag_fragmentation_index] = true;
+
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+
+	pfree(zones);
+}
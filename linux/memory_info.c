@@ -9,143 +9,198 @@
 #include "postgres.h"
 #include "system_stats.h"
 
+#include <fcntl.h>
+
+/*
+ * Keys of /proc/meminfo are found through a perfect hash: the FNV-1a hash of
+ * the key, started from MEMINFO_HASH_SEED, gives a different top byte for
+ * every known key.  meminfo_hash_slots maps that byte to the key, or -1.
+ * The hash is computed while scanning for the colon, so every line is
+ * looked at once.  When a key is added, a new seed without collisions has
+ * to be searched for and the table regenerated.
+ */
+#define MEMINFO_HASH_SEED        3233
+#define MEMINFO_HASH_PRIME       16777619
+
+static const char *const meminfo_key_names[NUM_MEMINFO_KEYS] = {
+	"MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached", "SwapCached",
+	"Active", "Inactive", "Active(anon)", "Inactive(anon)", "Active(file)",
+	"Inactive(file)", "Unevictable", "Mlocked", "HighTotal", "HighFree",
+	"LowTotal", "LowFree", "SwapTotal", "SwapFree", "Zswap", "Zswapped",
+	"Dirty", "Writeback", "AnonPages", "Mapped", "Shmem", "KReclaimable",
+	"Slab", "SReclaimable", "SUnreclaim", "KernelStack", "ShadowCallStack",
+	"PageTables", "SecPageTables", "NFS_Unstable", "Bounce", "WritebackTmp",
+	"CommitLimit", "Committed_AS", "VmallocTotal", "VmallocUsed",
+	"VmallocChunk", "Percpu", "HardwareCorrupted", "AnonHugePages",
+	"ShmemHugePages", "ShmemPmdMapped", "FileHugePages", "FilePmdMapped",
+	"CmaTotal", "CmaFree", "Unaccepted", "Balloon", "HugePages_Total",
+	"HugePages_Free", "HugePages_Rsvd", "HugePages_Surp", "Hugepagesize",
+	"Hugetlb", "DirectMap4k", "DirectMap2M", "DirectMap4M", "DirectMap1G"
+};
+
+static const int8 meminfo_hash_slots[256] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 55, 49, 59, -1,  4, -1,
+	-1, -1, -1, -1, -1, -1, -1, 38, -1, -1, 39, 52, -1, 23, -1, 25,
+	-1, -1, -1, -1, 48, -1, -1, -1, -1, 40, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, 53, -1, -1, -1, -1, 47, 27, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1,  5, -1, -1, -1, -1, 16, -1, -1, -1,
+	-1, 14, -1, -1, -1, -1, 22, -1, -1, -1, -1, -1, 58, -1, -1, -1,
+	26, 36, 42, -1, -1, -1, 10,  8, -1, 45, 35, 18, -1, -1, -1, -1,
+	-1, -1, 12, -1, -1, 62, -1, -1, -1, -1, -1, 37, -1, -1, -1, 50,
+	-1, -1, -1, -1, -1, -1, 21, -1, 28, -1, 57, -1, -1, -1, -1,  9,
+	-1, -1, -1, -1,  6, -1, -1, 60, -1, -1, 51, -1, 31, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, 15, -1, 56, 63, -1, -1, -1, -1,
+	-1, 61, -1, -1, -1, -1, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, 17, -1, -1, 46, -1, 19, -1, 13, -1, 44, -1, 32, 20, -1, -1,
+	-1, -1, -1,  3, -1, -1, -1, -1, -1, -1, -1, 43, -1, -1, -1, -1,
+	30, -1, -1, 54, 33, 41, -1, -1, -1, -1, 34,  2, -1,  7,  1,  0,
+	-1, -1, -1, -1, -1, 29, -1, -1, 24, -1, -1, -1, -1, -1, -1, -1
+};
+
 void ReadMemoryInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadMemoryInformationExt(Tuplestorestate *tupstore, TupleDesc tupdesc);
 
-void ReadMemoryInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+const char *MeminfoKeyName(MeminfoKey key)
 {
-	FILE       *memory_file;
-	Datum      values[Natts_memory_info];
-	bool       nulls[Natts_memory_info];
-	char       *line_buf = NULL;
-	size_t     line_buf_size = 0;
-	int        line_count = 0;
-	ssize_t    line_size;
-	uint64     total_memory_bytes = 0;
-	uint64     free_memory_bytes = 0;
-	uint64     used_memory_bytes = 0;
-	uint64     cached_bytes = 0;
-	uint64     swap_total_bytes = 0;
-	uint64     swap_free_bytes = 0;
-	uint64     swap_used_bytes = 0;
+	return meminfo_key_names[key];
+}
 
-	memset(nulls, 0, sizeof(nulls));
+/*
+ * Read every known key of /proc/meminfo in a single pass.  Values in kB are
+ * converted to bytes.  Returns false if the file can not be read.
+ */
+bool ReadMeminfo(MeminfoSample *sample)
+{
+	char    buf[MEMINFO_READ_BUFFER];
+	char    *line;
+	ssize_t len;
+	size_t  total = 0;
+	int     fd;
 
-	/* Open the file required to read all the memory information */
-	memory_file = fopen(MEMORY_FILE_NAME, "r");
+	memset(sample, 0, sizeof(MeminfoSample));
 
-	if (!memory_file)
+	fd = open(MEMORY_FILE_NAME, O_RDONLY);
+	if (fd < 0)
 	{
-		char memory_file_name[MAXPGPATH];
-		snprintf(memory_file_name, MAXPGPATH, "%s", MEMORY_FILE_NAME);
-
 		ereport(DEBUG1,
 				(errcode_for_file_access(),
 					errmsg("can not open file %s for reading memory information",
-						memory_file_name)));
-		return;
+						MEMORY_FILE_NAME)));
+		return false;
 	}
 
-	/* Get the first line of the file. */
-	line_size = getline(&line_buf, &line_buf_size, memory_file);
+	while (total < sizeof(buf) - 1 &&
+		   (len = read(fd, buf + total, sizeof(buf) - 1 - total)) > 0)
+		total += len;
+	buf[total] = '\0';
 
-	/* Loop through until we are done with the file. */
-	while (line_size >= 0)
-	{
-		/* Read the total memory of the system */
-		char *mem_total = strstr(line_buf, "MemTotal:");
-		char *mem_free = NULL;
-		char *cached_mem = NULL;
-		char *c_swap_total = NULL;
-		char *c_swap_free = NULL;
-		if (mem_total != NULL && mem_total == line_buf)
-		{
-			line_count++;
-			total_memory_bytes = ConvertToBytes(line_buf);
-		}
+	close(fd);
 
-		/* Read the free memory of the system */
-		mem_free = strstr(line_buf, "MemFree:");
-		if (mem_free != NULL && mem_free == line_buf)
-		{
-			line_count++;
-			free_memory_bytes = ConvertToBytes(line_buf);
-		}
+	for (line = buf; *line != '\0';)
+	{
+		char   *key = line;
+		char   *pos = line;
+		uint32 hash = MEMINFO_HASH_SEED;
+		uint64 value;
+		int    slot;
 
-		/* Read the cached memory of the system */
-		cached_mem = strstr(line_buf, "Cached:");
-		if (cached_mem != NULL && cached_mem == line_buf)
-		{
-			line_count++;
-			cached_bytes = ConvertToBytes(line_buf);
-		}
+		while (*pos != ':' && *pos != '\n' && *pos != '\0')
+			hash = (hash ^ (unsigned char) *pos++) * MEMINFO_HASH_PRIME;
 
-		/* Read the total swap memory of the system */
-		c_swap_total = strstr(line_buf, "SwapTotal:");
-		if (c_swap_total != NULL && c_swap_total == line_buf)
+		if (*pos == ':')
 		{
-			line_count++;
-			swap_total_bytes = ConvertToBytes(line_buf);
-		}
+			size_t key_len = pos - key;
 
-		/* Read the free swap memory of the system */
-		c_swap_free = strstr(line_buf, "SwapFree:");
-		if (c_swap_free != NULL && c_swap_free == line_buf)
-		{
-			line_count++;
-			swap_free_bytes = ConvertToBytes(line_buf);
-		}
-
-		used_memory_bytes = total_memory_bytes - free_memory_bytes;
-		swap_used_bytes = swap_total_bytes - swap_free_bytes;
+			value = strtoull(pos + 1, &pos, 10);
+			while (*pos == ' ')
+				pos++;
 
-		// Check if we get all lines, add as row
-		if (line_count == MEMORY_READ_COUNT)
-		{
-			values[Anum_total_memory] = UInt64GetDatum(total_memory_bytes);
-			values[Anum_free_memory] = UInt64GetDatum(free_memory_bytes);
-			values[Anum_used_memory] = UInt64GetDatum(used_memory_bytes);
-			values[Anum_total_cache_memory] = UInt64GetDatum(cached_bytes);
-			values[Anum_swap_total_memory] = UInt64GetDatum(swap_total_bytes);
-			values[Anum_swap_free_memory] = UInt64GetDatum(swap_free_bytes);
-			values[Anum_swap_used_memory] = UInt64GetDatum(swap_used_bytes);
-
-			/* set the NULL value as it is not for this platform */
-			nulls[Anum_kernel_total_memory] = true;
-			nulls[Anum_kernel_paged_memory] = true;
-			nulls[Anum_kernel_nonpaged_memory] = true;
-			nulls[Anum_total_page_file] = true;
-			nulls[Anum_avail_page_file] = true;
-
-			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
-
-			/* Free the allocated line buffer */
-			if (line_buf != NULL)
+			slot = meminfo_hash_slots[hash >> 24];
+			if (slot >= 0 && strncmp(key, meminfo_key_names[slot], key_len) == 0 &&
+				meminfo_key_names[slot][key_len] == '\0')
 			{
-				free(line_buf);
-				line_buf = NULL;
+				sample->in_bytes[slot] = (pos[0] == 'k' && pos[1] == 'B');
+				sample->values[slot] = sample->in_bytes[slot] ? value * 1024 : value;
+				sample->present[slot] = true;
 			}
+		}
 
+		/* Move to the next line */
+		pos = strchr(pos, '\n');
+		if (pos == NULL)
 			break;
-		}
+		line = pos + 1;
+	}
 
-		/* Free the allocated line buffer */
-		if (line_buf != NULL)
-		{
-			free(line_buf);
-			line_buf = NULL;
-		}
+	return true;
+}
 
-		/* Get the next line */
-		line_size = getline(&line_buf, &line_buf_size, memory_file);
-	}
+void ReadMemoryInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum         values[Natts_memory_info];
+	bool          nulls[Natts_memory_info];
+	MeminfoSample meminfo;
+	uint64        total_memory_bytes;
+	uint64        used_memory_bytes;
+
+	memset(nulls, 0, sizeof(nulls));
+
+	if (!ReadMeminfo(&meminfo))
+		return;
 
-	/* Free the allocated line buffer */
-	if (line_buf != NULL)
+	total_memory_bytes = meminfo.values[MEMINFO_MEM_TOTAL];
+
+	/*
+	 * Free memory does not count the page cache and reclaimable slab, which
+	 * the kernel hands out on demand.  MemAvailable estimates the memory
+	 * available without swapping, so used memory is derived from it on the
+	 * kernels that have it.
+	 */
+	if (meminfo.present[MEMINFO_MEM_AVAILABLE])
+		used_memory_bytes = total_memory_bytes - meminfo.values[MEMINFO_MEM_AVAILABLE];
+	else
+		used_memory_bytes = total_memory_bytes - meminfo.values[MEMINFO_MEM_FREE];
+
+	values[Anum_total_memory] = UInt64GetDatum(total_memory_bytes);
+	values[Anum_free_memory] = UInt64GetDatum(meminfo.values[MEMINFO_MEM_FREE]);
+	values[Anum_used_memory] = UInt64GetDatum(used_memory_bytes);
+	values[Anum_total_cache_memory] = UInt64GetDatum(meminfo.values[MEMINFO_CACHED]);
+	values[Anum_swap_total_memory] = UInt64GetDatum(meminfo.values[MEMINFO_SWAP_TOTAL]);
+	values[Anum_swap_free_memory] = UInt64GetDatum(meminfo.values[MEMINFO_SWAP_FREE]);
+	values[Anum_swap_used_memory] = UInt64GetDatum(meminfo.values[MEMINFO_SWAP_TOTAL] -
+												   meminfo.values[MEMINFO_SWAP_FREE]);
+
+	/* set the NULL value as it is not for this platform */
+	nulls[Anum_kernel_total_memory] = true;
+	nulls[Anum_kernel_paged_memory] = true;
+	nulls[Anum_kernel_nonpaged_memory] = true;
+	nulls[Anum_total_page_file] = true;
+	nulls[Anum_avail_page_file] = true;
+
+	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+}
+
+void ReadMemoryInformationExt(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum         values[Natts_memory_info_ext];
+	bool          nulls[Natts_memory_info_ext];
+	MeminfoSample meminfo;
+	int           key;
+
+	memset(nulls, 0, sizeof(nulls));
+
+	if (!ReadMeminfo(&meminfo))
+		return;
+
+	for (key = 0; key < NUM_MEMINFO_KEYS; key++)
 	{
-		free(line_buf);
-		line_buf = NULL;
-	}
+		if (!meminfo.present[key])
+			continue;
 
-	/* Close the file now that we are done with it */
-	fclose(memory_file);
+		values[Anum_meminfo_key] = CStringGetTextDatum(meminfo_key_names[key]);
+		values[Anum_meminfo_value] = UInt64GetDatum(meminfo.values[key]);
+		values[Anum_meminfo_unit] = CStringGetTextDatum(meminfo.in_bytes[key] ? "bytes" : "pages");
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
 }
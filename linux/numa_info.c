@@ -0,0 +1,351 @@
+/*------------------------------------------------------------------------
+ * numa_info.c
+ *              NUMA node memory and memory placement of PostgreSQL
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#include <dirent.h>
+
+#include "miscadmin.h"
+#include "storage/fd.h"
+
+#define NUMA_NODE_SYSFS_DIR         "/sys/devices/system/node"
+#define NUMA_MAX_NODES              256
+#define NUMA_CPULIST_LEN            1024
+#define NUMA_PROCESS_NAME_LEN       128
+
+static const char *const numastat_keys[] = {
+	"numa_hit", "numa_miss", "numa_foreign", "interleave_hit", "local_node",
+	"other_node"
+};
+#define NUM_NUMASTAT_KEYS           lengthof(numastat_keys)
+
+/* memory of a process per node, in bytes */
+typedef struct numa_usage
+{
+	uint64 shared_bytes[NUMA_MAX_NODES];
+	uint64 private_bytes[NUMA_MAX_NODES];
+	uint64 shared_total;
+} numa_usage;
+
+void ReadNumaInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadNumaPlacement(Tuplestorestate *tupstore, TupleDesc tupdesc);
+static void ReadNodeMeminfo(int node, uint64 *total_bytes, uint64 *free_bytes,
+		uint64 *used_bytes, uint64 *file_pages);
+static bool ReadNumaMaps(int pid, numa_usage *usage);
+static bool IsPostgresProcess(int pid);
+static void ReadProcessName(int pid, char *name);
+static void PutPlacementRows(Tuplestorestate *tupstore, TupleDesc tupdesc, int pid,
+		const char *name, const char *memory_type, uint64 *bytes);
+
+/* Read the memory of a node from its meminfo, "Node <n> <key>: <value> kB" lines */
+static void ReadNodeMeminfo(int node, uint64 *total_bytes, uint64 *free_bytes,
+		uint64 *used_bytes, uint64 *file_pages)
+{
+	FILE    *fp;
+	char    file_name[MAXPGPATH];
+	char    *line_buf = NULL;
+	size_t  line_buf_size = 0;
+	char    key[64];
+	unsigned long long value;
+
+	snprintf(file_name, MAXPGPATH, "%s/node%d/meminfo", NUMA_NODE_SYSFS_DIR, node);
+	fp = fopen(file_name, "r");
+	if (!fp)
+		return;
+
+	while (getline(&line_buf, &line_buf_size, fp) >= 0)
+	{
+		if (sscanf(line_buf, "Node %*d %63[^:]: %llu", key, &value) != 2)
+			continue;
+
+		if (strcmp(key, "MemTotal") == 0)
+			*total_bytes = value * 1024;
+		else if (strcmp(key, "MemFree") == 0)
+			*free_bytes = value * 1024;
+		else if (strcmp(key, "MemUsed") == 0)
+			*used_bytes = value * 1024;
+		else if (strcmp(key, "FilePages") == 0)
+			*file_pages = value * 1024;
+	}
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(fp);
+}
+
+void ReadNumaInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum         values[Natts_numa_info];
+	bool          nulls[Natts_numa_info];
+	DIR           *dirp;
+	struct dirent *ent;
+
+	dirp = opendir(NUMA_NODE_SYSFS_DIR);
+	if (!dirp)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("could not open directory \"%s\": %m", NUMA_NODE_SYSFS_DIR)));
+		return;
+	}
+
+	while ((ent = readdir(dirp)) != NULL)
+	{
+		char   file_name[MAXPGPATH];
+		char   cpus[NUMA_CPULIST_LEN];
+		uint64 total_bytes = 0;
+		uint64 free_bytes = 0;
+		uint64 used_bytes = 0;
+		uint64 file_pages = 0;
+		uint64 counters[NUM_NUMASTAT_KEYS];
+		bool   found[NUM_NUMASTAT_KEYS];
+		int    node;
+		int    index;
+
+		if (strncmp(ent->d_name, "node", 4) != 0 || !stringIsNumber(ent->d_name + 4))
+			continue;
+
+		node = atoi(ent->d_name + 4);
+		memset(nulls, 0, sizeof(nulls));
+
+		values[Anum_numa_node] = Int32GetDatum(node);
+
+		snprintf(file_name, MAXPGPATH, "%s/node%d/cpulist", NUMA_NODE_SYSFS_DIR, node);
+		if (ReadFileLine(file_name, cpus, NUMA_CPULIST_LEN))
+			values[Anum_numa_cpus] = CStringGetTextDatum(cpus);
+		else
+			nulls[Anum_numa_cpus] = true;
+
+		ReadNodeMeminfo(node, &total_bytes, &free_bytes, &used_bytes, &file_pages);
+		values[Anum_numa_total_memory] = UInt64GetDatum(total_bytes);
+		values[Anum_numa_free_memory] = UInt64GetDatum(free_bytes);
+		values[Anum_numa_used_memory] = UInt64GetDatum(used_bytes);
+		values[Anum_numa_file_pages] = UInt64GetDatum(file_pages);
+
+		snprintf(file_name, MAXPGPATH, "%s/node%d/numastat", NUMA_NODE_SYSFS_DIR, node);
+		if (!ReadKeyValueFile(file_name, numastat_keys, NUM_NUMASTAT_KEYS, counters, found))
+			memset(found, 0, sizeof(found));
+
+		for (index = 0; index < NUM_NUMASTAT_KEYS; index++)
+		{
+			if (found[index])
+				values[Anum_numa_hit + index] = UInt64GetDatum(counters[index]);
+			else
+				nulls[Anum_numa_hit + index] = true;
+		}
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	closedir(dirp);
+}
+
+/*
+ * Sum the pages of a process per node from /proc/<pid>/numa_maps.  Shared
+ * memory is the anonymous shared memory of the main segment (/dev/zero,
+ * /anon_hugepage or /SYSV<key>), private memory every mapping without a
+ * file, like the heap and the stack.  numa_maps only shows the pages the
+ * process has touched.
+ */
+static bool ReadNumaMaps(int pid, numa_usage *usage)
+{
+	FILE    *fp;
+	char    file_name[MAXPGPATH];
+	char    *line_buf = NULL;
+	size_t  line_buf_size = 0;
+
+	memset(usage, 0, sizeof(numa_usage));
+
+	snprintf(file_name, MAXPGPATH, "/proc/%d/numa_maps", pid);
+	fp = fopen(file_name, "r");
+	if (!fp)
+		return false;
+
+	while (getline(&line_buf, &line_buf_size, fp) >= 0)
+	{
+		uint64 pages[NUMA_MAX_NODES];
+		uint64 page_size = 4096;
+		bool   has_file = false;
+		bool   is_shared = false;
+		int    max_node = -1;
+		char   *saveptr = NULL;
+		char   *token;
+		int    node;
+
+		/* Skip the address and the memory policy */
+		token = strtok_r(line_buf, " \n", &saveptr);
+		if (token != NULL)
+			token = strtok_r(NULL, " \n", &saveptr);
+
+		while ((token = strtok_r(NULL, " \n", &saveptr)) != NULL)
+		{
+			unsigned long long value;
+
+			if (strncmp(token, "file=", 5) == 0)
+			{
+				has_file = true;
+				is_shared = strncmp(token + 5, "/dev/zero", 9) == 0 ||
+					strncmp(token + 5, "/anon_hugepage", 14) == 0 ||
+					strncmp(token + 5, "/SYSV", 5) == 0;
+			}
+			else if (sscanf(token, "kernelpagesize_kB=%llu", &value) == 1)
+				page_size = value * 1024;
+			else if (sscanf(token, "N%d=%llu", &node, &value) == 2 &&
+					 node >= 0 && node < NUMA_MAX_NODES)
+			{
+				while (max_node < node)
+					pages[++max_node] = 0;
+				pages[node] = value;
+			}
+		}
+
+		if (has_file && !is_shared)
+			continue;
+
+		for (node = 0; node <= max_node; node++)
+		{
+			if (is_shared)
+			{
+				usage->shared_bytes[node] += pages[node] * page_size;
+				usage->shared_total += pages[node] * page_size;
+			}
+			else
+				usage->private_bytes[node] += pages[node] * page_size;
+		}
+	}
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(fp);
+
+	return true;
+}
+
+/* Whether the process is the postmaster or one of its children */
+static bool IsPostgresProcess(int pid)
+{
+	char  file_name[MAXPGPATH];
+	char  line[MAXPGPATH];
+	char  *close_paren;
+	int   ppid;
+
+	if (pid == PostmasterPid)
+		return true;
+
+	snprintf(file_name, MAXPGPATH, "/proc/%d/stat", pid);
+	if (!ReadFileLine(file_name, line, MAXPGPATH))
+		return false;
+
+	/* The command may contain spaces and parentheses, fields follow the last ')' */
+	close_paren = strrchr(line, ')');
+	if (close_paren == NULL || sscanf(close_paren + 1, " %*c %d", &ppid) != 1)
+		return false;
+
+	return ppid == PostmasterPid;
+}
+
+/* PostgreSQL sets the command line of its processes to what they are doing */
+static void ReadProcessName(int pid, char *name)
+{
+	char file_name[MAXPGPATH];
+
+	snprintf(file_name, MAXPGPATH, "/proc/%d/cmdline", pid);
+	if (!ReadFileLine(file_name, name, NUMA_PROCESS_NAME_LEN))
+		name[0] = '\0';
+}
+
+static void PutPlacementRows(Tuplestorestate *tupstore, TupleDesc tupdesc, int pid,
+		const char *name, const char *memory_type, uint64 *bytes)
+{
+	Datum values[Natts_numa_placement];
+	bool  nulls[Natts_numa_placement];
+	int   node;
+
+	memset(nulls, 0, sizeof(nulls));
+
+	for (node = 0; node < NUMA_MAX_NODES; node++)
+	{
+		if (bytes[node] == 0)
+			continue;
+
+		values[Anum_numa_pl_pid] = Int32GetDatum(pid);
+		values[Anum_numa_pl_process] = CStringGetTextDatum(name);
+		values[Anum_numa_pl_memory_type] = CStringGetTextDatum(memory_type);
+		values[Anum_numa_pl_node] = Int32GetDatum(node);
+		values[Anum_numa_pl_bytes] = UInt64GetDatum(bytes[node]);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+}
+
+/*
+ * Report the private memory of every PostgreSQL process per node, and the
+ * placement of the shared memory segment.  Each process only maps the
+ * shared pages it touched, so the segment is reported as seen by the
+ * process which maps most of it.
+ */
+void ReadNumaPlacement(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	DIR           *dirp;
+	struct dirent *ent;
+	numa_usage    *usage;
+	numa_usage    *shared_usage;
+	char          name[NUMA_PROCESS_NAME_LEN];
+	char          shared_name[NUMA_PROCESS_NAME_LEN];
+	int           shared_pid = 0;
+
+	/* Allocated so that it is closed when a cancel interrupts the walk */
+	dirp = AllocateDir(PROC_FILE_SYSTEM_PATH);
+	if (!dirp)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("could not open directory \"%s\": %m", PROC_FILE_SYSTEM_PATH)));
+		return;
+	}
+
+	usage = palloc(sizeof(numa_usage));
+	shared_usage = palloc0(sizeof(numa_usage));
+
+	while ((ent = ReadDirExtended(dirp, PROC_FILE_SYSTEM_PATH, DEBUG1)) != NULL)
+	{
+		int pid;
+
+		if (!stringIsNumber(ent->d_name))
+			continue;
+
+		CHECK_FOR_INTERRUPTS();
+
+		pid = atoi(ent->d_name);
+		if (!IsPostgresProcess(pid) || !ReadNumaMaps(pid, usage))
+			continue;
+
+		ReadProcessName(pid, name);
+		PutPlacementRows(tupstore, tupdesc, pid, name, "private", usage->private_bytes);
+
+		if (usage->shared_total > shared_usage->shared_total)
+		{
+			memcpy(shared_usage, usage, sizeof(numa_usage));
+			strlcpy(shared_name, name, NUMA_PROCESS_NAME_LEN);
+			shared_pid = pid;
+		}
+	}
+
+	FreeDir(dirp);
+
+	if (shared_pid != 0)
+		PutPlacementRows(tupstore, tupdesc, shared_pid, shared_name, "shared_memory",
+						 shared_usage->shared_bytes);
+
+	pfree(usage);
+	pfree(shared_usage);
+}
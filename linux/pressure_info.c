@@ -0,0 +1,84 @@
+/*------------------------------------------------------------------------
+ * pressure_info.c
+ *              Pressure stall information of /proc/pressure
+ *
+ * Unlike the load average, which mixes runnable tasks with tasks blocked
+ * on IO, the pressure stall information tells per resource the share of
+ * wall time in which some or all non-idle tasks were stalled waiting for
+ * it.  Besides the kernel's running averages, the stall rate since the
+ * previous call is computed from the cumulative stall time.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+static const char *const pressure_resources[] = {
+	"cpu", "memory", "io", "irq"
+};
+#define NUM_PRESSURE_RESOURCES      lengthof(pressure_resources)
+
+static CounterBaseline pressure_baseline;
+
+void ReadPressureInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+static void PutPressureRow(Tuplestorestate *tupstore, TupleDesc tupdesc,
+		const char *resource, const char *kind, PressureStall *stall);
+
+static void PutPressureRow(Tuplestorestate *tupstore, TupleDesc tupdesc,
+		const char *resource, const char *kind, PressureStall *stall)
+{
+	Datum  values[Natts_pressure_info];
+	bool   nulls[Natts_pressure_info];
+	char   key[COUNTER_BASELINE_KEY_LEN];
+	float8 rate;
+
+	memset(nulls, 0, sizeof(nulls));
+
+	values[Anum_pressure_resource] = CStringGetTextDatum(resource);
+	values[Anum_pressure_kind] = CStringGetTextDatum(kind);
+	values[Anum_pressure_avg10] = Float8GetDatum(stall->avg10);
+	values[Anum_pressure_avg60] = Float8GetDatum(stall->avg60);
+	values[Anum_pressure_avg300] = Float8GetDatum(stall->avg300);
+	values[Anum_pressure_total_stall_us] = UInt64GetDatum(stall->total_us);
+
+	/* Microseconds stalled per second, as a percentage of wall time */
+	snprintf(key, COUNTER_BASELINE_KEY_LEN, "%s/%s", resource, kind);
+	if (counter_baseline_rate(&pressure_baseline, key, stall->total_us, &rate))
+		values[Anum_pressure_stall_percent] = Float8GetDatum(Min(rate / 10000, 100.0));
+	else
+		nulls[Anum_pressure_stall_percent] = true;
+
+	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+}
+
+void ReadPressureInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	PressureStall some;
+	PressureStall full;
+	bool          found = false;
+	int           index;
+
+	counter_baseline_begin(&pressure_baseline);
+
+	for (index = 0; index < NUM_PRESSURE_RESOURCES; index++)
+	{
+		if (!ReadPressureStall(pressure_resources[index], &some, &full))
+			continue;
+
+		found = true;
+
+		if (some.present)
+			PutPressureRow(tupstore, tupdesc, pressure_resources[index], "some", &some);
+		if (full.present)
+			PutPressureRow(tupstore, tupdesc, pressure_resources[index], "full", &full);
+	}
+
+	counter_baseline_end(&pressure_baseline);
+
+	if (!found)
+		ereport(DEBUG1,
+				(errmsg("pressure stall information is not available, it needs Linux 4.20 or later built with CONFIG_PSI")));
+}
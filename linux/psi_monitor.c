@@ -0,0 +1,550 @@
+/*------------------------------------------------------------------------
+ * psi_monitor.c
+ *              Pressure stall trigger events
+ *
+ * Linux lets a process register a trigger on /proc/pressure/<resource>,
+ * like "some 300000 2000000" for 300ms of stall within any 2s window, and
+ * then wakes it up with POLLPRI whenever the trigger fires.  When
+ * system_stats.psi_monitor is on, a background worker registers the
+ * triggers configured for memory, IO and CPU and blocks in poll() on them,
+ * which is why it does not share the loop of the sampler.  Each event is
+ * logged and kept, together with the processes most likely to cause it, in
+ * a ring buffer in shared memory.
+ *
+ * Unprivileged processes can only register triggers whose window is a
+ * multiple of 2 seconds, and need Linux 6.5 or later to register any.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "lib/stringinfo.h"
+#include "miscadmin.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/interrupt.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/pmsignal.h"
+#include "storage/shmem.h"
+#include "utils/guc.h"
+#include "utils/timestamp.h"
+
+#define PSI_MAX_EVENTS              64
+#define PSI_EVENT_PROCESSES         5
+#define PSI_TRIGGER_LEN             64
+#define PSI_PROCESS_NAME_LEN        32
+#define PSI_POLL_TIMEOUT_MS         1000
+#define PSI_MIN_WINDOW_US           500000
+#define PSI_MAX_WINDOW_US           10000000
+
+typedef enum PsiResource
+{
+	PSI_MEMORY,
+	PSI_IO,
+	PSI_CPU,
+	NUM_PSI_RESOURCES
+} PsiResource;
+
+static const char *const psi_resource_names[NUM_PSI_RESOURCES] = {
+	"memory", "io", "cpu"
+};
+
+typedef struct PsiEventProcess
+{
+	int    pid;
+	char   state;
+	char   name[PSI_PROCESS_NAME_LEN];
+	uint64 rss_bytes;
+} PsiEventProcess;
+
+typedef struct PsiEvent
+{
+	TimestampTz     event_time;
+	PsiResource     resource;
+	char            trigger[PSI_TRIGGER_LEN];
+	float8          avg10;
+	uint64          total_stall_us;
+	int             num_processes;
+	PsiEventProcess processes[PSI_EVENT_PROCESSES];
+} PsiEvent;
+
+typedef struct PsiEventsState
+{
+	LWLock   *lock;
+	uint64   num_events;     /* events recorded since startup */
+	PsiEvent events[PSI_MAX_EVENTS];
+} PsiEventsState;
+
+PGDLLEXPORT void system_stats_psi_monitor_main(Datum main_arg) pg_attribute_noreturn();
+
+static bool psi_monitor_enabled = false;
+static char *psi_triggers[NUM_PSI_RESOURCES];
+
+static PsiEventsState *psi_events_state = NULL;
+
+/* triggers registered by the worker, and the setting they were made from */
+static int  psi_fds[NUM_PSI_RESOURCES] = {-1, -1, -1};
+static char psi_registered[NUM_PSI_RESOURCES][PSI_TRIGGER_LEN];
+
+static bool check_psi_trigger(char **newval, void **extra, GucSource source);
+static void RegisterPsiTrigger(PsiResource resource);
+static void ReadTopProcesses(PsiResource resource, PsiEvent *event);
+static void RecordPsiEvent(PsiResource resource);
+
+/* A trigger is "some" or "full", a stall threshold and a window in microseconds */
+static bool check_psi_trigger(char **newval, void **extra, GucSource source)
+{
+	char          kind[8];
+	unsigned long stall_us;
+	unsigned long window_us;
+	char          extra_char;
+
+	if (*newval == NULL || (*newval)[0] == '\0')
+		return true;
+
+	if (strlen(*newval) >= PSI_TRIGGER_LEN ||
+		sscanf(*newval, "%7s %lu %lu %c", kind, &stall_us, &window_us, &extra_char) != 3 ||
+		(strcmp(kind, "some") != 0 && strcmp(kind, "full") != 0))
+	{
+		GUC_check_errdetail("A pressure trigger must look like \"some 300000 2000000\".");
+		return false;
+	}
+
+	if (window_us < PSI_MIN_WINDOW_US || window_us > PSI_MAX_WINDOW_US ||
+		stall_us == 0 || stall_us > window_us)
+	{
+		GUC_check_errdetail("The window must be between %d and %d microseconds, and the stall at most the window.",
+							PSI_MIN_WINDOW_US, PSI_MAX_WINDOW_US);
+		return false;
+	}
+
+	return true;
+}
+
+void DefinePsiMonitorVariables(void)
+{
+	DefineCustomBoolVariable("system_stats.psi_monitor",
+							 "Starts a background worker recording pressure stall trigger events.",
+							 NULL,
+							 &psi_monitor_enabled,
+							 false,
+							 PGC_POSTMASTER,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomStringVariable("system_stats.psi_memory_trigger",
+							   "Sets the memory pressure stall trigger, empty to disable it.",
+							   NULL,
+							   &psi_triggers[PSI_MEMORY],
+							   "some 300000 2000000",
+							   PGC_SIGHUP,
+							   0,
+							   check_psi_trigger,
+							   NULL,
+							   NULL);
+
+	DefineCustomStringVariable("system_stats.psi_io_trigger",
+							   "Sets the IO pressure stall trigger, empty to disable it.",
+							   NULL,
+							   &psi_triggers[PSI_IO],
+							   "some 300000 2000000",
+							   PGC_SIGHUP,
+							   0,
+							   check_psi_trigger,
+							   NULL,
+							   NULL);
+
+	DefineCustomStringVariable("system_stats.psi_cpu_trigger",
+							   "Sets the CPU pressure stall trigger, empty to disable it.",
+							   NULL,
+							   &psi_triggers[PSI_CPU],
+							   "",
+							   PGC_SIGHUP,
+							   0,
+							   check_psi_trigger,
+							   NULL,
+							   NULL);
+}
+
+/* Register the worker, called while loading shared_preload_libraries */
+void RegisterPsiMonitor(void)
+{
+	BackgroundWorker worker;
+
+	if (!psi_monitor_enabled)
+		return;
+
+	memset(&worker, 0, sizeof(worker));
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+	worker.bgw_start_time = BgWorkerStart_PostmasterStart;
+	worker.bgw_restart_time = 10;
+	snprintf(worker.bgw_library_name, BGW_MAXLEN, "system_stats");
+	snprintf(worker.bgw_function_name, BGW_MAXLEN, "system_stats_psi_monitor_main");
+	snprintf(worker.bgw_name, BGW_MAXLEN, "system_stats psi monitor");
+	snprintf(worker.bgw_type, BGW_MAXLEN, "system_stats psi monitor");
+	RegisterBackgroundWorker(&worker);
+}
+
+Size PsiEventsShmemSize(void)
+{
+	return MAXALIGN(sizeof(PsiEventsState));
+}
+
+void PsiEventsShmemInit(void)
+{
+	bool found;
+
+	psi_events_state = ShmemInitStruct("system_stats psi events",
+									   PsiEventsShmemSize(), &found);
+	if (!found)
+	{
+		memset(psi_events_state, 0, PsiEventsShmemSize());
+		psi_events_state->lock =
+			&(GetNamedLWLockTranche(SYSTEM_STATS_LWLOCK_TRANCHE))[SAMPLER_LOCK_PSI_EVENTS].lock;
+	}
+}
+
+/*
+ * (Re)register the trigger of a resource if its setting changed.  The
+ * trigger lives as long as the file descriptor it was written to.
+ */
+static void RegisterPsiTrigger(PsiResource resource)
+{
+	const char *trigger = psi_triggers[resource] ? psi_triggers[resource] : "";
+	char       file_name[MAXPGPATH];
+	int        fd;
+
+	if (psi_fds[resource] >= 0 && strcmp(psi_registered[resource], trigger) == 0)
+		return;
+
+	if (psi_fds[resource] >= 0)
+	{
+		close(psi_fds[resource]);
+		psi_fds[resource] = -1;
+	}
+	strlcpy(psi_registered[resource], trigger, PSI_TRIGGER_LEN);
+
+	if (trigger[0] == '\0')
+		return;
+
+	snprintf(file_name, MAXPGPATH, "%s/%s", PRESSURE_DIR, psi_resource_names[resource]);
+	fd = open(file_name, O_RDWR | O_NONBLOCK);
+	if (fd < 0)
+	{
+		ereport(WARNING,
+				(errcode_for_file_access(),
+					errmsg("could not open file \"%s\": %m", file_name)));
+		return;
+	}
+
+	/* The kernel expects the terminating zero byte to be written too */
+	if (write(fd, trigger, strlen(trigger) + 1) < 0)
+	{
+		ereport(WARNING,
+				(errcode_for_file_access(),
+					errmsg("could not register %s pressure trigger \"%s\": %m",
+						psi_resource_names[resource], trigger),
+					errhint("Unprivileged processes can only use windows which are a multiple of 2 seconds.")));
+		close(fd);
+		return;
+	}
+
+	psi_fds[resource] = fd;
+	ereport(DEBUG1,
+			(errmsg("registered %s pressure trigger \"%s\"",
+				psi_resource_names[resource], trigger)));
+}
+
+/*
+ * Keep the processes most likely to cause the pressure, ordered by their
+ * resident memory.  Runnable processes come first for CPU pressure and
+ * processes waiting for IO for IO pressure.  Kernel threads are skipped.
+ */
+static void ReadTopProcesses(PsiResource resource, PsiEvent *event)
+{
+	DIR           *dirp;
+	struct dirent *ent;
+	char          preferred_state = resource == PSI_CPU ? 'R' : (resource == PSI_IO ? 'D' : '\0');
+	uint64        page_size = (uint64) sysconf(_SC_PAGESIZE);
+
+	event->num_processes = 0;
+
+	dirp = opendir(PROC_FILE_SYSTEM_PATH);
+	if (!dirp)
+		return;
+
+	while ((ent = readdir(dirp)) != NULL)
+	{
+		PsiEventProcess proc;
+		char            file_name[MAXPGPATH];
+		char            line[MAXPGPATH];
+		char            *open_paren;
+		char            *close_paren;
+		long            rss_pages;
+		int             pos;
+
+		if (!stringIsNumber(ent->d_name))
+			continue;
+
+		snprintf(file_name, MAXPGPATH, "/proc/%s/stat", ent->d_name);
+		if (!ReadFileLine(file_name, line, MAXPGPATH))
+			continue;
+
+		/* The command may contain spaces and parentheses, fields follow the last ')' */
+		open_paren = strchr(line, '(');
+		close_paren = strrchr(line, ')');
+		if (open_paren == NULL || close_paren == NULL || close_paren < open_paren)
+			continue;
+
+		if (sscanf(close_paren + 1,
+				   " %c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %*u %*u %ld",
+				   &proc.state, &rss_pages) != 2 || rss_pages <= 0)
+			continue;
+
+		proc.pid = atoi(ent->d_name);
+		proc.rss_bytes = (uint64) rss_pages * page_size;
+		*close_paren = '\0';
+		strlcpy(proc.name, open_paren + 1, PSI_PROCESS_NAME_LEN);
+
+		/* Insertion into the short sorted list */
+		for (pos = event->num_processes; pos > 0; pos--)
+		{
+			PsiEventProcess *other = &event->processes[pos - 1];
+			bool            preferred = proc.state == preferred_state;
+			bool            other_preferred = other->state == preferred_state;
+
+			if (other_preferred > preferred ||
+				(other_preferred == preferred && other->rss_bytes >= proc.rss_bytes))
+				break;
+
+			if (pos < PSI_EVENT_PROCESSES)
+				event->processes[pos] = *other;
+		}
+
+		if (pos < PSI_EVENT_PROCESSES)
+		{
+			event->processes[pos] = proc;
+			if (event->num_processes < PSI_EVENT_PROCESSES)
+				event->num_processes++;
+		}
+	}
+
+	closedir(dirp);
+}
+
+/* Record and log a trigger event */
+static void RecordPsiEvent(PsiResource resource)
+{
+	PsiEvent       event;
+	PressureStall  some;
+	PressureStall  full;
+	PressureStall  *stall;
+	StringInfoData processes;
+	int            index;
+
+	memset(&event, 0, sizeof(event));
+	event.event_time = GetCurrentTimestamp();
+	event.resource = resource;
+	strlcpy(event.trigger, psi_registered[resource], PSI_TRIGGER_LEN);
+
+	/* The stall of the kind the trigger watches */
+	if (ReadPressureStall(psi_resource_names[resource], &some, &full))
+	{
+		stall = strncmp(event.trigger, "full", 4) == 0 ? &full : &some;
+		event.avg10 = stall->avg10;
+		event.total_stall_us = stall->total_us;
+	}
+
+	ReadTopProcesses(resource, &event);
+
+	if (psi_events_state != NULL)
+	{
+		LWLockAcquire(psi_events_state->lock, LW_EXCLUSIVE);
+		psi_events_state->events[psi_events_state->num_events % PSI_MAX_EVENTS] = event;
+		psi_events_state->num_events++;
+		LWLockRelease(psi_events_state->lock);
+	}
+
+	initStringInfo(&processes);
+	for (index = 0; index < event.num_processes; index++)
+		appendStringInfo(&processes, "%s%d (%s, %c, " UINT64_FORMAT " kB)",
+						 index > 0 ? ", " : "",
+						 event.processes[index].pid, event.processes[index].name,
+						 event.processes[index].state,
+						 event.processes[index].rss_bytes / 1024);
+
+	ereport(LOG,
+			(errmsg("%s pressure trigger \"%s\" fired, avg10 is %.2f%%",
+				psi_resource_names[resource], event.trigger, event.avg10),
+				errdetail("Top processes: %s.", processes.data)));
+
+	pfree(processes.data);
+}
+
+/* Main loop of the pressure stall trigger monitor */
+void system_stats_psi_monitor_main(Datum main_arg)
+{
+	int resource;
+
+	pqsignal(SIGHUP, SignalHandlerForConfigReload);
+	pqsignal(SIGTERM, SignalHandlerForShutdownRequest);
+	BackgroundWorkerUnblockSignals();
+
+	ereport(DEBUG1, (errmsg("system_stats psi monitor started")));
+
+	for (resource = 0; resource < NUM_PSI_RESOURCES; resource++)
+		RegisterPsiTrigger(resource);
+
+	while (!ShutdownRequestPending)
+	{
+		struct pollfd fds[NUM_PSI_RESOURCES];
+		PsiResource   fd_resources[NUM_PSI_RESOURCES];
+		int           nfds = 0;
+		int           rc;
+		int           index;
+
+		for (resource = 0; resource < NUM_PSI_RESOURCES; resource++)
+		{
+			if (psi_fds[resource] < 0)
+				continue;
+
+			fds[nfds].fd = psi_fds[resource];
+			fds[nfds].events = POLLPRI;
+			fds[nfds].revents = 0;
+			fd_resources[nfds++] = resource;
+		}
+
+		/*
+		 * A latch can not wait for POLLPRI, so poll() the triggers directly.
+		 * Signals interrupt it, and the timeout bounds how long a shutdown
+		 * or the death of the postmaster goes unnoticed.
+		 */
+		rc = poll(fds, nfds, PSI_POLL_TIMEOUT_MS);
+		if (rc < 0 && errno != EINTR)
+			ereport(ERROR,
+					(errmsg("could not poll pressure triggers: %m")));
+
+		if (!PostmasterIsAlive())
+			proc_exit(1);
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (ConfigReloadPending)
+		{
+			ConfigReloadPending = false;
+			ProcessConfigFile(PGC_SIGHUP);
+			for (resource = 0; resource < NUM_PSI_RESOURCES; resource++)
+				RegisterPsiTrigger(resource);
+			continue;
+		}
+
+		for (index = 0; rc > 0 && index < nfds; index++)
+		{
+			resource = fd_resources[index];
+
+			if (fds[index].revents & POLLERR)
+			{
+				/* The trigger is gone for good, like when its cgroup is removed */
+				ereport(WARNING,
+						(errmsg("%s pressure trigger \"%s\" is no longer available",
+							psi_resource_names[resource], psi_registered[resource])));
+				close(psi_fds[resource]);
+				psi_fds[resource] = -1;
+			}
+			else if (fds[index].revents & POLLPRI)
+				RecordPsiEvent(resource);
+		}
+	}
+
+	for (resource = 0; resource < NUM_PSI_RESOURCES; resource++)
+	{
+		if (psi_fds[resource] >= 0)
+			close(psi_fds[resource]);
+	}
+
+	proc_exit(0);
+}
+
+/*
+ * Report the recorded events, oldest first, with a row per process of the
+ * snapshot taken when the trigger fired.
+ */
+void ReadPressureEvents(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum    values[Natts_pressure_events];
+	bool     nulls[Natts_pressure_events];
+	PsiEvent *events;
+	uint64   num_events;
+	uint64   first;
+	uint64   count;
+	uint64   index;
+	int      rank;
+
+	if (psi_events_state == NULL)
+	{
+		ereport(DEBUG1,
+				(errmsg("pressure stall trigger events require system_stats in shared_preload_libraries")));
+		return;
+	}
+
+	/* Copy the events so that the monitor is not blocked while building tuples */
+	events = palloc(sizeof(PsiEvent) * PSI_MAX_EVENTS);
+	LWLockAcquire(psi_events_state->lock, LW_SHARED);
+	num_events = psi_events_state->num_events;
+	memcpy(events, psi_events_state->events, sizeof(PsiEvent) * PSI_MAX_EVENTS);
+	LWLockRelease(psi_events_state->lock);
+
+	count = Min(num_events, PSI_MAX_EVENTS);
+	first = num_events - count;
+
+	for (index = first; index < num_events; index++)
+	{
+		PsiEvent *event = &events[index % PSI_MAX_EVENTS];
+
+		memset(nulls, 0, sizeof(nulls));
+
+		values[Anum_psi_event_time] = TimestampTzGetDatum(event->event_time);
+		values[Anum_psi_resource] = CStringGetTextDatum(psi_resource_names[event->resource]);
+		values[Anum_psi_trigger] = CStringGetTextDatum(event->trigger);
+		values[Anum_psi_avg10] = Float8GetDatum(event->avg10);
+		values[Anum_psi_total_stall_us] = UInt64GetDatum(event->total_stall_us);
+
+		if (event->num_processes == 0)
+		{
+			nulls[Anum_psi_process_rank] = true;
+			nulls[Anum_psi_pid] = true;
+			nulls[Anum_psi_process_name] = true;
+			nulls[Anum_psi_process_state] = true;
+			nulls[Anum_psi_rss_bytes] = true;
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+			continue;
+		}
+
+		for (rank = 0; rank < event->num_processes; rank++)
+		{
+			PsiEventProcess *proc = &event->processes[rank];
+			char            state[2] = {proc->state, '\0'};
+
+			values[Anum_psi_process_rank] = Int32GetDatum(rank + 1);
+			values[Anum_psi_pid] = Int32GetDatum(proc->pid);
+			values[Anum_psi_process_name] = CStringGetTextDatum(proc->name);
+			values[Anum_psi_process_state] = CStringGetTextDatum(state);
+			values[Anum_psi_rss_bytes] = UInt64GetDatum(proc->rss_bytes);
+
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+
+	pfree(events);
+}
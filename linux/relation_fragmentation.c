@@ -0,0 +1,242 @@
+/*------------------------------------------------------------------------
+ * relation_fragmentation.c
+ *              Fragmentation of the files of a relation
+ *
+ * The extents of every segment file of every fork of a relation are read
+ * with the FS_IOC_FIEMAP ioctl.  Extents which the filesystem reports
+ * separately but which are physically contiguous are counted as one, as
+ * they are read sequentially all the same.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+
+#include "catalog/pg_class.h"
+#include "common/relpath.h"
+#include "miscadmin.h"
+#include "storage/lmgr.h"
+#include "utils/lsyscache.h"
+
+/* number of extents fetched by one FS_IOC_FIEMAP call */
+#define FIEMAP_BATCH_EXTENTS        256
+
+/* extents below this size are considered small */
+#define SMALL_EXTENT_SIZE           (1024 * 1024)
+
+/* extents of the segment files of one fork */
+typedef struct fork_extents
+{
+	int    segments;
+	uint64 size_bytes;
+	uint64 extents;
+	uint64 extent_bytes;
+	uint64 small_extent_bytes;
+	bool   mapped;              /* false if the filesystem does not support FIEMAP */
+} fork_extents;
+
+void ReadRelationFragmentation(Tuplestorestate *tupstore, TupleDesc tupdesc, Oid relid);
+static bool MapFileExtents(int fd, fork_extents *fork);
+static bool ReadForkExtents(const char *fork_path, fork_extents *fork);
+
+/*
+ * Add the extents of an open file to the fork totals.  Returns false if the
+ * filesystem does not support FIEMAP.
+ */
+static bool MapFileExtents(int fd, fork_extents *fork)
+{
+	struct fiemap *fiemap;
+	uint64        start = 0;
+	uint64        run_physical = 0;
+	uint64        run_length = 0;
+	bool          last = false;
+
+	fiemap = palloc(sizeof(struct fiemap) +
+					FIEMAP_BATCH_EXTENTS * sizeof(struct fiemap_extent));
+
+	while (!last)
+	{
+		int index;
+
+		memset(fiemap, 0, sizeof(struct fiemap));
+		fiemap->fm_start = start;
+		fiemap->fm_length = FIEMAP_MAX_OFFSET - start;
+		fiemap->fm_extent_count = FIEMAP_BATCH_EXTENTS;
+
+		if (ioctl(fd, FS_IOC_FIEMAP, fiemap) < 0)
+		{
+			pfree(fiemap);
+			return false;
+		}
+
+		/* No (more) extents, e.g. an empty or sparse file */
+		if (fiemap->fm_mapped_extents == 0)
+			break;
+
+		for (index = 0; index < fiemap->fm_mapped_extents; index++)
+		{
+			struct fiemap_extent *extent = &fiemap->fm_extents[index];
+
+			if (run_length > 0 && extent->fe_physical == run_physical + run_length)
+				run_length += extent->fe_length;
+			else
+			{
+				if (run_length > 0)
+				{
+					fork->extents++;
+					fork->extent_bytes += run_length;
+					if (run_length < SMALL_EXTENT_SIZE)
+						fork->small_extent_bytes += run_length;
+				}
+				run_physical = extent->fe_physical;
+				run_length = extent->fe_length;
+			}
+
+			start = extent->fe_logical + extent->fe_length;
+			if (extent->fe_flags & FIEMAP_EXTENT_LAST)
+				last = true;
+		}
+	}
+
+	if (run_length > 0)
+	{
+		fork->extents++;
+		fork->extent_bytes += run_length;
+		if (run_length < SMALL_EXTENT_SIZE)
+			fork->small_extent_bytes += run_length;
+	}
+
+	pfree(fiemap);
+
+	return true;
+}
+
+/*
+ * Walk the segment files of one fork.  Returns false if the fork does not
+ * exist.
+ */
+static bool ReadForkExtents(const char *fork_path, fork_extents *fork)
+{
+	char        segment_path[MAXPGPATH];
+	struct stat st;
+	int         segment;
+	int         fd;
+
+	memset(fork, 0, sizeof(fork_extents));
+	fork->mapped = true;
+
+	for (segment = 0;; segment++)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		if (segment == 0)
+			snprintf(segment_path, MAXPGPATH, "%s", fork_path);
+		else
+			snprintf(segment_path, MAXPGPATH, "%s.%d", fork_path, segment);
+
+		fd = open(segment_path, O_RDONLY);
+		if (fd < 0)
+		{
+			if (errno != ENOENT)
+				ereport(DEBUG1,
+						(errcode_for_file_access(),
+							errmsg("could not open file \"%s\": %m", segment_path)));
+			break;
+		}
+
+		if (fstat(fd, &st) == 0)
+			fork->size_bytes += st.st_size;
+		fork->segments++;
+
+		if (fork->mapped && !MapFileExtents(fd, fork))
+		{
+			ereport(DEBUG1,
+					(errmsg("could not map extents of file \"%s\": %m", segment_path)));
+			fork->mapped = false;
+		}
+
+		close(fd);
+	}
+
+	return fork->segments > 0;
+}
+
+void ReadRelationFragmentation(Tuplestorestate *tupstore, TupleDesc tupdesc, Oid relid)
+{
+	Datum        values[Natts_relation_fragmentation];
+	bool         nulls[Natts_relation_fragmentation];
+	char         relkind;
+	char         *rel_path;
+	char         fork_path[MAXPGPATH];
+	fork_extents fork;
+	ForkNumber   forknum;
+
+	/* Keep the relation from being dropped or rewritten while it is walked */
+	LockRelationOid(relid, AccessShareLock);
+
+	relkind = get_rel_relkind(relid);
+	if (relkind != RELKIND_RELATION && relkind != RELKIND_INDEX &&
+		relkind != RELKIND_SEQUENCE && relkind != RELKIND_TOASTVALUE &&
+		relkind != RELKIND_MATVIEW)
+	{
+		ereport(DEBUG1,
+				(errmsg("relation with OID %u has no storage", relid)));
+		return;
+	}
+
+	/* Path of the main fork relative to the data directory */
+	rel_path = text_to_cstring(DatumGetTextPP(DirectFunctionCall1(pg_relation_filepath,
+													ObjectIdGetDatum(relid))));
+
+	for (forknum = MAIN_FORKNUM; forknum <= MAX_FORKNUM; forknum++)
+	{
+		memset(nulls, 0, sizeof(nulls));
+
+		if (forknum == MAIN_FORKNUM)
+			snprintf(fork_path, MAXPGPATH, "%s", rel_path);
+		else
+			snprintf(fork_path, MAXPGPATH, "%s_%s", rel_path, forkNames[forknum]);
+
+		if (!ReadForkExtents(fork_path, &fork))
+			continue;
+
+		values[Anum_frag_fork_name] = CStringGetTextDatum(forkNames[forknum]);
+		values[Anum_frag_segments] = Int32GetDatum(fork.segments);
+		values[Anum_frag_size_bytes] = UInt64GetDatum(fork.size_bytes);
+
+		if (fork.mapped)
+		{
+			values[Anum_frag_extents] = UInt64GetDatum(fork.extents);
+			if (fork.extents > 0)
+			{
+				values[Anum_frag_avg_extent_bytes] = Float8GetDatum((float8) fork.extent_bytes / fork.extents);
+				values[Anum_frag_small_extent_percent] =
+					Float8GetDatum((float8) fork.small_extent_bytes * 100 / fork.extent_bytes);
+			}
+			else
+			{
+				nulls[Anum_frag_avg_extent_bytes] = true;
+				nulls[Anum_frag_small_extent_percent] = true;
+			}
+		}
+		else
+		{
+			nulls[Anum_frag_extents] = true;
+			nulls[Anum_frag_avg_extent_bytes] = true;
+			nulls[Anum_frag_small_extent_percent] = true;
+		}
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	pfree(rel_path);
+}
@@ -0,0 +1,258 @@
+/*------------------------------------------------------------------------
+ * runqueue.c
+ *              Run queue length sampled at sub-second intervals
+ *
+ * The load averages of /proc/loadavg are exponentially damped over one
+ * minute at best, so a CPU saturation shows up in them only after tens of
+ * seconds.  The background sampler reads the number of runnable and of
+ * blocked (uninterruptible) tasks from /proc/stat every 100ms and keeps the
+ * last minute of samples in shared memory, from which the averages and
+ * maximums over the last 1, 10 and 60 seconds are computed.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/memutils.h"
+#include "utils/timestamp.h"
+
+#define RUNQUEUE_SAMPLE_MS          100
+#define RUNQUEUE_MAX_SAMPLES        640         /* a minute, and some slack */
+#define RUNQUEUE_READ_BUFFER        65536
+
+typedef struct RunqueueSample
+{
+	TimestampTz sample_time;
+	uint32      running;
+	uint32      blocked;
+} RunqueueSample;
+
+typedef struct RunqueueState
+{
+	LWLock         *lock;
+	int            next;                       /* slot of the next sample */
+	int            num_samples;
+	RunqueueSample samples[RUNQUEUE_MAX_SAMPLES];
+} RunqueueState;
+
+static RunqueueState *runqueue_state = NULL;
+
+/* /proc/stat is kept open by the sampler and re-read from the start */
+static int         proc_stat_fd = -1;
+static char        *proc_stat_buf = NULL;
+static size_t      proc_stat_buf_size = 0;
+static TimestampTz last_runqueue_sample = 0;
+
+static const int runqueue_windows[] = {1, 10, 60};
+
+void ReadRunqueueInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+static bool ReadProcStatCounter(const char *name, uint32 *value);
+
+Size RunqueueShmemSize(void)
+{
+	return MAXALIGN(sizeof(RunqueueState));
+}
+
+void RunqueueShmemInit(void)
+{
+	bool found;
+
+	runqueue_state = ShmemInitStruct("system_stats run queue",
+									 RunqueueShmemSize(), &found);
+	if (!found)
+	{
+		memset(runqueue_state, 0, RunqueueShmemSize());
+		runqueue_state->lock =
+			&(GetNamedLWLockTranche(SYSTEM_STATS_LWLOCK_TRANCHE))[SAMPLER_LOCK_RUNQUEUE].lock;
+	}
+}
+
+/* Value of a "name value" line of the buffer read from /proc/stat */
+static bool ReadProcStatCounter(const char *name, uint32 *value)
+{
+	char   *pos = proc_stat_buf;
+	size_t len = strlen(name);
+
+	while ((pos = strstr(pos, name)) != NULL)
+	{
+		if ((pos == proc_stat_buf || pos[-1] == '\n') && pos[len] == ' ')
+		{
+			*value = (uint32) strtoul(pos + len + 1, NULL, 10);
+			return true;
+		}
+		pos += len;
+	}
+
+	return false;
+}
+
+/*
+ * Take one sample of the run queue.  Called by the background sampler on
+ * every iteration, it samples at most every RUNQUEUE_SAMPLE_MS.  The
+ * procs_ lines come after the interrupt counters, so the whole file is
+ * read; the buffer grows to its size once and is reused.
+ */
+void SampleRunqueue(void)
+{
+	RunqueueSample sample;
+	TimestampTz    now;
+	size_t         total = 0;
+	ssize_t        len;
+
+	if (runqueue_state == NULL)
+		return;
+
+	now = GetCurrentTimestamp();
+	if (!TimestampDifferenceExceeds(last_runqueue_sample, now, RUNQUEUE_SAMPLE_MS))
+		return;
+	last_runqueue_sample = now;
+
+	if (proc_stat_fd < 0)
+	{
+		proc_stat_fd = open(CPU_USAGE_STATS_FILENAME, O_RDONLY);
+		if (proc_stat_fd < 0)
+			return;
+		proc_stat_buf_size = RUNQUEUE_READ_BUFFER;
+		proc_stat_buf = MemoryContextAlloc(TopMemoryContext, proc_stat_buf_size);
+	}
+
+	if (lseek(proc_stat_fd, 0, SEEK_SET) < 0)
+		return;
+
+	while ((len = read(proc_stat_fd, proc_stat_buf + total,
+					   proc_stat_buf_size - 1 - total)) > 0)
+	{
+		total += len;
+		if (total == proc_stat_buf_size - 1)
+		{
+			proc_stat_buf_size *= 2;
+			proc_stat_buf = repalloc(proc_stat_buf, proc_stat_buf_size);
+		}
+	}
+	proc_stat_buf[total] = '\0';
+
+	if (!ReadProcStatCounter("procs_running", &sample.running) ||
+		!ReadProcStatCounter("procs_blocked", &sample.blocked))
+		return;
+
+	/* The sampler itself is running while it reads the file */
+	if (sample.running > 0)
+		sample.running--;
+	sample.sample_time = now;
+
+	LWLockAcquire(runqueue_state->lock, LW_EXCLUSIVE);
+	runqueue_state->samples[runqueue_state->next] = sample;
+	runqueue_state->next = (runqueue_state->next + 1) % RUNQUEUE_MAX_SAMPLES;
+	if (runqueue_state->num_samples < RUNQUEUE_MAX_SAMPLES)
+		runqueue_state->num_samples++;
+	LWLockRelease(runqueue_state->lock);
+}
+
+void ReadRunqueueInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum          values[Natts_runqueue_info];
+	bool           nulls[Natts_runqueue_info];
+	RunqueueSample *samples;
+	int            num_samples;
+	int            next;
+	long           num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	TimestampTz    now = GetCurrentTimestamp();
+	int            window;
+
+	if (runqueue_state == NULL)
+	{
+		ereport(DEBUG1,
+				(errmsg("run queue sampling requires system_stats in shared_preload_libraries")));
+		return;
+	}
+
+	/* Copy the samples so that the sampler is not blocked while building tuples */
+	samples = palloc(sizeof(runqueue_state->samples));
+	LWLockAcquire(runqueue_state->lock, LW_SHARED);
+	num_samples = runqueue_state->num_samples;
+	next = runqueue_state->next;
+	memcpy(samples, runqueue_state->samples, sizeof(runqueue_state->samples));
+	LWLockRelease(runqueue_state->lock);
+
+	for (window = 0; window < lengthof(runqueue_windows); window++)
+	{
+		TimestampTz since = now - (TimestampTz) runqueue_windows[window] * USECS_PER_SEC;
+		uint64      running_sum = 0;
+		uint64      blocked_sum = 0;
+		uint32      running_max = 0;
+		uint32      blocked_max = 0;
+		uint32      load_max = 0;
+		int         count = 0;
+		int         index;
+
+		/* Walk back from the newest sample */
+		for (index = 0; index < num_samples; index++)
+		{
+			RunqueueSample *sample =
+				&samples[(next - 1 - index + RUNQUEUE_MAX_SAMPLES) % RUNQUEUE_MAX_SAMPLES];
+
+			if (sample->sample_time < since)
+				break;
+
+			running_sum += sample->running;
+			blocked_sum += sample->blocked;
+			running_max = Max(running_max, sample->running);
+			blocked_max = Max(blocked_max, sample->blocked);
+			load_max = Max(load_max, sample->running + sample->blocked);
+			count++;
+		}
+
+		memset(nulls, 0, sizeof(nulls));
+
+		values[Anum_rq_window_seconds] = Int32GetDatum(runqueue_windows[window]);
+		values[Anum_rq_samples] = Int32GetDatum(count);
+
+		if (count > 0)
+		{
+			float8 running_avg = (float8) running_sum / count;
+			float8 load_avg = (float8) (running_sum + blocked_sum) / count;
+
+			values[Anum_rq_runnable_avg] = Float8GetDatum(running_avg);
+			values[Anum_rq_runnable_max] = Int32GetDatum((int32) running_max);
+			values[Anum_rq_blocked_avg] = Float8GetDatum((float8) blocked_sum / count);
+			values[Anum_rq_blocked_max] = Int32GetDatum((int32) blocked_max);
+			values[Anum_rq_load_avg] = Float8GetDatum(load_avg);
+			values[Anum_rq_load_max] = Int32GetDatum((int32) load_max);
+
+			if (num_cpus > 0)
+			{
+				values[Anum_rq_runnable_per_cpu] = Float8GetDatum(running_avg / num_cpus);
+				values[Anum_rq_load_per_cpu] = Float8GetDatum(load_avg / num_cpus);
+			}
+			else
+			{
+				nulls[Anum_rq_runnable_per_cpu] = true;
+				nulls[Anum_rq_load_per_cpu] = true;
+			}
+		}
+		else
+		{
+			nulls[Anum_rq_runnable_avg] = true;
+			nulls[Anum_rq_runnable_max] = true;
+			nulls[Anum_rq_blocked_avg] = true;
+			nulls[Anum_rq_blocked_max] = true;
+			nulls[Anum_rq_load_avg] = true;
+			nulls[Anum_rq_load_max] = true;
+			nulls[Anum_rq_runnable_per_cpu] = true;
+			nulls[Anum_rq_load_per_cpu] = true;
+		}
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	pfree(samples);
+}
@@ -0,0 +1,159 @@
+/*------------------------------------------------------------------------
+ * sampler.c
+ *              Background worker sampling fast changing system statistics
+ *
+ * Some statistics, like the number of IOs in flight, are only meaningful
+ * when sampled far more often than anyone would call a SQL function.  When
+ * the extension is loaded through shared_preload_libraries, a background
+ * worker samples them at system_stats.sampler_interval and keeps the
+ * aggregated results in shared memory for the SQL functions to read.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#include "miscadmin.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/interrupt.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/guc.h"
+
+PGDLLEXPORT void system_stats_sampler_main(Datum main_arg) pg_attribute_noreturn();
+
+/* interval between two samples taken by the background worker */
+int sampler_interval_ms = 20;
+
+#if PG_VERSION_NUM >= 150000
+static shmem_request_hook_type prev_shmem_request_hook = NULL;
+#endif
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+
+static void sampler_shmem_request(void);
+static void sampler_shmem_startup(void);
+
+/* Request the shared memory and locks used by the sampled statistics */
+static void sampler_shmem_request(void)
+{
+#if PG_VERSION_NUM >= 150000
+	if (prev_shmem_request_hook)
+		prev_shmem_request_hook();
+#endif
+
+	RequestAddinShmemSpace(IOQueueDepthShmemSize());
+	RequestAddinShmemSpace(PsiEventsShmemSize());
+	RequestAddinShmemSpace(CPUTopologyShmemSize());
+	RequestAddinShmemSpace(HostIdentityShmemSize());
+	RequestAddinShmemSpace(RunqueueShmemSize());
+	RequestNamedLWLockTranche(SYSTEM_STATS_LWLOCK_TRANCHE, NUM_SAMPLER_LOCKS);
+}
+
+/* Create or attach to the shared memory of the sampled statistics */
+static void sampler_shmem_startup(void)
+{
+	if (prev_shmem_startup_hook)
+		prev_shmem_startup_hook();
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+	IOQueueDepthShmemInit();
+	PsiEventsShmemInit();
+	CPUTopologyShmemInit();
+	HostIdentityShmemInit();
+	RunqueueShmemInit();
+	LWLockRelease(AddinShmemInitLock);
+}
+
+/*
+ * Define the GUCs of the sampler and, when loaded through
+ * shared_preload_libraries, set up its shared memory and background workers.
+ */
+void InitSampler(void)
+{
+	BackgroundWorker worker;
+
+	DefineCustomIntVariable("system_stats.sampler_interval",
+							"Sets the interval between two samples of the background sampler.",
+							NULL,
+							&sampler_interval_ms,
+							20,
+							1,
+							60000,
+							PGC_SIGHUP,
+							GUC_UNIT_MS,
+							NULL,
+							NULL,
+							NULL);
+
+	DefinePsiMonitorVariables();
+	DefineHostIdentityVariables();
+
+#if PG_VERSION_NUM >= 150000
+	MarkGUCPrefixReserved("system_stats");
+#else
+	EmitWarningsOnPlaceholders("system_stats");
+#endif
+
+	if (!process_shared_preload_libraries_in_progress)
+		return;
+
+#if PG_VERSION_NUM >= 150000
+	prev_shmem_request_hook = shmem_request_hook;
+	shmem_request_hook = sampler_shmem_request;
+#else
+	sampler_shmem_request();
+#endif
+	prev_shmem_startup_hook = shmem_startup_hook;
+	shmem_startup_hook = sampler_shmem_startup;
+
+	memset(&worker, 0, sizeof(worker));
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+	worker.bgw_start_time = BgWorkerStart_PostmasterStart;
+	worker.bgw_restart_time = 10;
+	snprintf(worker.bgw_library_name, BGW_MAXLEN, "system_stats");
+	snprintf(worker.bgw_function_name, BGW_MAXLEN, "system_stats_sampler_main");
+	snprintf(worker.bgw_name, BGW_MAXLEN, "system_stats sampler");
+	snprintf(worker.bgw_type, BGW_MAXLEN, "system_stats sampler");
+	RegisterBackgroundWorker(&worker);
+
+	RegisterPsiMonitor();
+}
+
+/* Main loop of the background sampler */
+void system_stats_sampler_main(Datum main_arg)
+{
+	pqsignal(SIGHUP, SignalHandlerForConfigReload);
+	pqsignal(SIGTERM, SignalHandlerForShutdownRequest);
+	BackgroundWorkerUnblockSignals();
+
+	ereport(DEBUG1, (errmsg("system_stats sampler started")));
+
+	while (!ShutdownRequestPending)
+	{
+		(void) WaitLatch(MyLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 sampler_interval_ms,
+						 PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (ConfigReloadPending)
+		{
+			ConfigReloadPending = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		SampleIOQueueDepth();
+		SampleCPUTopology();
+		SampleHostIdentity();
+		SampleRunqueue();
+	}
+
+	proc_exit(0);
+}
@@ -17,6 +17,9 @@
 #include <sys/types.h>
 #include <dirent.h>
 
+#include "utils/memutils.h"
+#include "utils/timestamp.h"
+
 char* leftTrimStr(char* s);
 char* rightTrimStr(char* s);
 
@@ -246,3 +249,314 @@ void ReadFileContent(const char *file_name, uint64 *data)
 
 	fclose(fp);
 }
+
+/*
+ * Read the first line of a file, like a setting in /sys, without the
+ * trailing newline.  Returns false if the file can not be read.
+ */
+bool ReadFileLine(const char *file_name, char *buf, size_t len)
+{
+	FILE *fp = fopen(file_name, "r");
+	bool result = false;
+
+	if (!fp)
+		return false;
+
+	if (fgets(buf, len, fp) != NULL)
+	{
+		buf[strcspn(buf, "\n")] = '\0';
+		result = true;
+	}
+
+	fclose(fp);
+
+	return result;
+}
+
+/*
+ * Read the given keys from a file of "key value" or "key: value" lines,
+ * like /proc/vmstat.  found[i] tells whether keys[i] was in the file.
+ * Returns false if the file can not be opened.
+ */
+bool ReadKeyValueFile(const char *file_name, const char *const *keys, int num_keys,
+		uint64 *values, bool *found)
+{
+	FILE       *fp;
+	char       *line_buf = NULL;
+	size_t     line_buf_size = 0;
+	char       key[128];
+	unsigned long long value;
+	int        num_found = 0;
+	int        index;
+
+	memset(found, 0, num_keys * sizeof(bool));
+
+	fp = fopen(file_name, "r");
+	if (!fp)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("can not open file %s for reading", file_name)));
+		return false;
+	}
+
+	while (num_found < num_keys && getline(&line_buf, &line_buf_size, fp) >= 0)
+	{
+		size_t key_len;
+
+		if (sscanf(line_buf, "%127s %llu", key, &value) != 2)
+			continue;
+
+		key_len = strlen(key);
+		if (key_len > 0 && key[key_len - 1] == ':')
+			key[key_len - 1] = '\0';
+
+		for (index = 0; index < num_keys; index++)
+		{
+			if (!found[index] && strcmp(key, keys[index]) == 0)
+			{
+				values[index] = value;
+				found[index] = true;
+				num_found++;
+				break;
+			}
+		}
+	}
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(fp);
+
+	return true;
+}
+
+/*
+ * Read the "some" and "full" lines of /proc/pressure/<resource>.  The
+ * averages are percentages of wall time, the total is in microseconds.
+ * "full" is missing for the CPU before Linux 5.13, and irq only has
+ * "full".  Returns false if the kernel has no pressure stall information
+ * for the resource.
+ */
+bool ReadPressureStall(const char *resource, PressureStall *some, PressureStall *full)
+{
+	FILE    *fp;
+	char    file_name[MAXPGPATH];
+	char    *line_buf = NULL;
+	size_t  line_buf_size = 0;
+
+	memset(some, 0, sizeof(PressureStall));
+	memset(full, 0, sizeof(PressureStall));
+
+	snprintf(file_name, MAXPGPATH, "%s/%s", PRESSURE_DIR, resource);
+	fp = fopen(file_name, "r");
+	if (!fp)
+		return false;
+
+	while (getline(&line_buf, &line_buf_size, fp) >= 0)
+	{
+		PressureStall stall;
+		char          kind[8];
+		unsigned long long total;
+
+		if (sscanf(line_buf, "%7s avg10=%lf avg60=%lf avg300=%lf total=%llu", kind,
+				   &stall.avg10, &stall.avg60, &stall.avg300, &total) != 5)
+			continue;
+
+		stall.total_us = total;
+		stall.present = true;
+
+		if (strcmp(kind, "some") == 0)
+			*some = stall;
+		else if (strcmp(kind, "full") == 0)
+			*full = stall;
+	}
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(fp);
+
+	return some->present || full->present;
+}
+
+static int CompareCPUs(const void *a, const void *b)
+{
+	int cpu_a = *(const int *) a;
+	int cpu_b = *(const int *) b;
+
+	return (cpu_a > cpu_b) - (cpu_a < cpu_b);
+}
+
+/*
+ * List the CPUs with a cpuN directory in sysfs, online or not, in
+ * ascending order.  The array is palloc'd, NULL if there are none.
+ */
+int *ListSysfsCPUs(int *num_cpus)
+{
+	DIR           *dirp;
+	struct dirent *ent;
+	int           *cpus = NULL;
+	int           size = 0;
+
+	*num_cpus = 0;
+
+	dirp = opendir(CPU_SYSFS_DIR);
+	if (!dirp)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("could not open directory \"%s\": %m", CPU_SYSFS_DIR)));
+		return NULL;
+	}
+
+	while ((ent = readdir(dirp)) != NULL)
+	{
+		if (strncmp(ent->d_name, "cpu", 3) != 0 || ent->d_name[3] == '\0' ||
+			!stringIsNumber(ent->d_name + 3))
+			continue;
+
+		if (*num_cpus == size)
+		{
+			size = Max(size * 2, 64);
+			cpus = cpus ? repalloc(cpus, size * sizeof(int)) : palloc(size * sizeof(int));
+		}
+		cpus[(*num_cpus)++] = atoi(ent->d_name + 3);
+	}
+
+	closedir(dirp);
+
+	if (*num_cpus > 1)
+		qsort(cpus, *num_cpus, sizeof(int), CompareCPUs);
+
+	return cpus;
+}
+
+/*
+ * Counter baselines
+ *
+ * Many kernel statistics are cumulative counters.  Rather than sleeping
+ * between two samples, the functions exposing them remember the previous
+ * sample in backend-local memory and compute rates against it, so the
+ * first call in a session returns NULL rates and every later call returns
+ * the rate since the previous one.
+ *
+ * Counters are matched by key.  Since /proc and /sys files list their
+ * entries in a stable order, the lookup first tries the position the key
+ * had in the previous sample, then the one following the previous match,
+ * which stays in step when entries come and go, as processes do, and only
+ * falls back to a linear search for keys which moved or are new.
+ */
+static void counter_baseline_grow(CounterBaseline *baseline, int needed);
+
+void counter_baseline_begin(CounterBaseline *baseline)
+{
+	TimestampTz now = GetCurrentTimestamp();
+
+	baseline->elapsed_secs = 0;
+	if (baseline->sample_time != 0 && now > baseline->sample_time)
+		baseline->elapsed_secs = (float8) (now - baseline->sample_time) / USECS_PER_SEC;
+
+	baseline->next_time = now;
+	baseline->next_count = 0;
+	baseline->last_match = -1;
+}
+
+/*
+ * Remember the current value of the counter and, when the previous sample
+ * had the same counter, compute its per second rate.  Returns false if no
+ * rate can be computed: first sample, unknown key or counter reset.
+ */
+bool counter_baseline_rate(CounterBaseline *baseline, const char *key, uint64 value, float8 *rate)
+{
+	int    pos = baseline->next_count;
+	int    index = -1;
+	bool   found = false;
+	uint64 prev_value = 0;
+
+	counter_baseline_grow(baseline, pos + 1);
+	strlcpy(baseline->next_keys[pos], key, COUNTER_BASELINE_KEY_LEN);
+	baseline->next_values[pos] = value;
+	baseline->next_count++;
+
+	/*
+	 * Same position as before, or right after the previous match when
+	 * entries were added or removed in front of this one.
+	 */
+	if (pos < baseline->count &&
+		strcmp(baseline->keys[pos], baseline->next_keys[pos]) == 0)
+		index = pos;
+	else if (baseline->last_match + 1 < baseline->count &&
+			 strcmp(baseline->keys[baseline->last_match + 1], baseline->next_keys[pos]) == 0)
+		index = baseline->last_match + 1;
+	else
+	{
+		for (index = baseline->count - 1; index >= 0; index--)
+		{
+			if (strcmp(baseline->keys[index], baseline->next_keys[pos]) == 0)
+				break;
+		}
+	}
+
+	if (index >= 0)
+	{
+		prev_value = baseline->values[index];
+		baseline->last_match = index;
+		found = true;
+	}
+
+	if (!found || baseline->elapsed_secs <= 0 || value < prev_value)
+		return false;
+
+	*rate = (float8) (value - prev_value) / baseline->elapsed_secs;
+	return true;
+}
+
+/* Make the sample collected since counter_baseline_begin() the new baseline */
+void counter_baseline_end(CounterBaseline *baseline)
+{
+	char   (*keys)[COUNTER_BASELINE_KEY_LEN] = baseline->keys;
+	uint64 *values = baseline->values;
+	int    size = baseline->size;
+
+	baseline->keys = baseline->next_keys;
+	baseline->values = baseline->next_values;
+	baseline->size = baseline->next_size;
+	baseline->count = baseline->next_count;
+	baseline->sample_time = baseline->next_time;
+
+	baseline->next_keys = keys;
+	baseline->next_values = values;
+	baseline->next_size = size;
+	baseline->next_count = 0;
+}
+
+/* Make room for at least needed counters in the sample being collected */
+static void counter_baseline_grow(CounterBaseline *baseline, int needed)
+{
+	int new_size;
+
+	if (needed <= baseline->next_size)
+		return;
+
+	new_size = Max(baseline->next_size * 2, 64);
+	while (new_size < needed)
+		new_size *= 2;
+
+	if (baseline->next_keys == NULL)
+	{
+		baseline->next_keys = MemoryContextAlloc(TopMemoryContext,
+							new_size * COUNTER_BASELINE_KEY_LEN);
+		baseline->next_values = MemoryContextAlloc(TopMemoryContext,
+							new_size * sizeof(uint64));
+	}
+	else
+	{
+		baseline->next_keys = repalloc(baseline->next_keys,
+							new_size * COUNTER_BASELINE_KEY_LEN);
+		baseline->next_values = repalloc(baseline->next_values,
+							new_size * sizeof(uint64));
+	}
+
+	baseline->next_size = new_size;
+}
@@ -0,0 +1,323 @@
+/*------------------------------------------------------------------------
+ * tablespace_io.c
+ *              Tablespace and WAL aware IO information
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+#include "commands/tablespace.h"
+#include "utils/memutils.h"
+
+#define DISK_SECTOR_SIZE        512
+#define DEVICE_NAME_LEN         64
+
+/* block device resolved for a st_dev, cached for the life of the backend */
+typedef struct device_map
+{
+	dev_t  dev;
+	bool   resolved;
+	char   device_name[DEVICE_NAME_LEN];
+	char   backing_devices[MAXPGPATH];
+} device_map;
+
+/* IO rates of a block device since the previous call */
+typedef struct device_rates
+{
+	char   device_name[DEVICE_NAME_LEN];
+	bool   has_rates;
+	float8 reads_per_sec;
+	float8 writes_per_sec;
+	float8 read_bytes_per_sec;
+	float8 write_bytes_per_sec;
+	float8 busy_percent;
+} device_rates;
+
+static device_map *device_maps = NULL;
+static int num_device_maps = 0;
+static int max_device_maps = 0;
+static CounterBaseline diskstats_baseline;
+
+void ReadTablespaceIOInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+static device_map *LookupDeviceMap(const char *path);
+static int ReadDeviceRates(device_rates **rates);
+static void PutTablespaceRow(Tuplestorestate *tupstore, TupleDesc tupdesc,
+		const char *tablespace_name, const char *path,
+		device_rates *rates, int num_rates);
+
+/*
+ * Find the block device of the given path.  The st_dev to device mapping
+ * does not change while the filesystem is mounted, so it is resolved once
+ * and then served from the cache.
+ */
+static device_map *LookupDeviceMap(const char *path)
+{
+	struct stat st;
+	device_map  *map;
+	int         index;
+
+	if (stat(path, &st) != 0)
+		return NULL;
+
+	for (index = 0; index < num_device_maps; index++)
+	{
+		if (device_maps[index].dev == st.st_dev)
+			return &device_maps[index];
+	}
+
+	if (num_device_maps == max_device_maps)
+	{
+		max_device_maps = Max(max_device_maps * 2, 8);
+		if (device_maps == NULL)
+			device_maps = MemoryContextAlloc(TopMemoryContext,
+								max_device_maps * sizeof(device_map));
+		else
+			device_maps = repalloc(device_maps, max_device_maps * sizeof(device_map));
+	}
+
+	map = &device_maps[num_device_maps++];
+	memset(map, 0, sizeof(device_map));
+	map->dev = st.st_dev;
+	map->resolved = ResolveBlockDevice(path, map->device_name, DEVICE_NAME_LEN,
+									   map->backing_devices, MAXPGPATH);
+
+	return map;
+}
+
+/*
+ * Read /proc/diskstats once and compute the IO rates of every device
+ * against the sample remembered from the previous call.
+ */
+static int ReadDeviceRates(device_rates **rates)
+{
+	FILE       *diskstats_file;
+	char       *line_buf = NULL;
+	size_t     line_buf_size = 0;
+	ssize_t    line_size;
+	char       device_name[DEVICE_NAME_LEN];
+	char       key[COUNTER_BASELINE_KEY_LEN];
+	uint64     reads_completed = 0;
+	uint64     sectors_read = 0;
+	uint64     writes_completed = 0;
+	uint64     sectors_written = 0;
+	uint64     io_ticks = 0;
+	int        num_rates = 0;
+	int        max_rates = 32;
+	const char *scan_fmt = "%*u %*u %63s %llu %*u %llu %*u %llu %*u %llu %*u %*u %llu";
+
+	*rates = palloc0(max_rates * sizeof(device_rates));
+
+	diskstats_file = fopen(DISK_IO_STATS_FILE_NAME, "r");
+
+	if (!diskstats_file)
+	{
+		char disk_file_name[MAXPGPATH];
+		snprintf(disk_file_name, MAXPGPATH, "%s", DISK_IO_STATS_FILE_NAME);
+
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("can not open file %s for reading disk stats information",
+						disk_file_name)));
+		return 0;
+	}
+
+	counter_baseline_begin(&diskstats_baseline);
+
+	/* Get the first line of the file. */
+	line_size = getline(&line_buf, &line_buf_size, diskstats_file);
+
+	/* Loop through until we are done with the file. */
+	while (line_size >= 0)
+	{
+		if (sscanf(line_buf, scan_fmt, device_name, &reads_completed, &sectors_read,
+				   &writes_completed, &sectors_written, &io_ticks) == 6)
+		{
+			device_rates *rate;
+			bool         has_rates = true;
+
+			if (num_rates == max_rates)
+			{
+				max_rates *= 2;
+				*rates = repalloc(*rates, max_rates * sizeof(device_rates));
+			}
+
+			rate = &(*rates)[num_rates++];
+			memset(rate, 0, sizeof(device_rates));
+			snprintf(rate->device_name, DEVICE_NAME_LEN, "%s", device_name);
+
+			/* Sectors in /proc/diskstats are always 512 bytes */
+			snprintf(key, COUNTER_BASELINE_KEY_LEN, "%s/reads", device_name);
+			has_rates &= counter_baseline_rate(&diskstats_baseline, key,
+								reads_completed, &rate->reads_per_sec);
+			snprintf(key, COUNTER_BASELINE_KEY_LEN, "%s/writes", device_name);
+			has_rates &= counter_baseline_rate(&diskstats_baseline, key,
+								writes_completed, &rate->writes_per_sec);
+			snprintf(key, COUNTER_BASELINE_KEY_LEN, "%s/read_bytes", device_name);
+			has_rates &= counter_baseline_rate(&diskstats_baseline, key,
+								sectors_read * DISK_SECTOR_SIZE, &rate->read_bytes_per_sec);
+			snprintf(key, COUNTER_BASELINE_KEY_LEN, "%s/write_bytes", device_name);
+			has_rates &= counter_baseline_rate(&diskstats_baseline, key,
+								sectors_written * DISK_SECTOR_SIZE, &rate->write_bytes_per_sec);
+			snprintf(key, COUNTER_BASELINE_KEY_LEN, "%s/io_ticks", device_name);
+			has_rates &= counter_baseline_rate(&diskstats_baseline, key,
+								io_ticks, &rate->busy_percent);
+
+			/* io_ticks is in milliseconds, so ms per second / 10 is percent busy */
+			rate->busy_percent = Min(rate->busy_percent / 10.0, 100.0);
+			rate->has_rates = has_rates;
+		}
+
+		/* Get the next line */
+		line_size = getline(&line_buf, &line_buf_size, diskstats_file);
+	}
+
+	counter_baseline_end(&diskstats_baseline);
+
+	if (line_buf != NULL)
+	{
+		free(line_buf);
+		line_buf = NULL;
+	}
+
+	fclose(diskstats_file);
+
+	return num_rates;
+}
+
+/* Put the row for one tablespace location in the tuple store */
+static void PutTablespaceRow(Tuplestorestate *tupstore, TupleDesc tupdesc,
+		const char *tablespace_name, const char *path,
+		device_rates *rates, int num_rates)
+{
+	Datum        values[Natts_tablespace_io];
+	bool         nulls[Natts_tablespace_io];
+	char         location[MAXPGPATH];
+	device_map   *map;
+	device_rates *rate = NULL;
+	struct statvfs buf;
+	ssize_t      len;
+	int          index;
+
+	memset(nulls, 0, sizeof(nulls));
+	memset(location, 0, MAXPGPATH);
+
+	/* Report where a symbolic link, e.g. pg_wal or pg_tblspc/<oid>, points to */
+	len = readlink(path, location, MAXPGPATH - 1);
+	if (len <= 0)
+		snprintf(location, MAXPGPATH, "%s", path);
+
+	if (tablespace_name != NULL)
+		values[Anum_tblspc_name] = CStringGetTextDatum(tablespace_name);
+	else
+		nulls[Anum_tblspc_name] = true;
+	values[Anum_tblspc_location] = CStringGetTextDatum(location);
+
+	map = LookupDeviceMap(path);
+	if (map != NULL && map->resolved)
+	{
+		values[Anum_tblspc_device_name] = CStringGetTextDatum(map->device_name);
+		values[Anum_tblspc_backing_devices] = CStringGetTextDatum(map->backing_devices);
+
+		for (index = 0; index < num_rates; index++)
+		{
+			if (strcmp(rates[index].device_name, map->device_name) == 0)
+			{
+				rate = &rates[index];
+				break;
+			}
+		}
+	}
+	else
+	{
+		nulls[Anum_tblspc_device_name] = true;
+		nulls[Anum_tblspc_backing_devices] = true;
+	}
+
+	if (statvfs(path, &buf) == 0)
+	{
+		values[Anum_tblspc_total_space] = UInt64GetDatum((uint64) buf.f_blocks * buf.f_frsize);
+		values[Anum_tblspc_free_space] = UInt64GetDatum((uint64) buf.f_bavail * buf.f_frsize);
+	}
+	else
+	{
+		nulls[Anum_tblspc_total_space] = true;
+		nulls[Anum_tblspc_free_space] = true;
+	}
+
+	if (rate != NULL && rate->has_rates)
+	{
+		values[Anum_tblspc_reads_per_sec] = Float8GetDatum(rate->reads_per_sec);
+		values[Anum_tblspc_writes_per_sec] = Float8GetDatum(rate->writes_per_sec);
+		values[Anum_tblspc_read_bytes_per_sec] = Float8GetDatum(rate->read_bytes_per_sec);
+		values[Anum_tblspc_write_bytes_per_sec] = Float8GetDatum(rate->write_bytes_per_sec);
+		values[Anum_tblspc_busy_percent] = Float8GetDatum(rate->busy_percent);
+	}
+	else
+	{
+		nulls[Anum_tblspc_reads_per_sec] = true;
+		nulls[Anum_tblspc_writes_per_sec] = true;
+		nulls[Anum_tblspc_read_bytes_per_sec] = true;
+		nulls[Anum_tblspc_write_bytes_per_sec] = true;
+		nulls[Anum_tblspc_busy_percent] = true;
+	}
+
+	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+}
+
+void ReadTablespaceIOInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	device_rates  *rates = NULL;
+	int           num_rates;
+	char          path[MAXPGPATH];
+	DIR           *dirp;
+	struct dirent *ent;
+
+	num_rates = ReadDeviceRates(&rates);
+
+	snprintf(path, MAXPGPATH, "%s/base", DataDir);
+	PutTablespaceRow(tupstore, tupdesc, "pg_default", path, rates, num_rates);
+
+	snprintf(path, MAXPGPATH, "%s/global", DataDir);
+	PutTablespaceRow(tupstore, tupdesc, "pg_global", path, rates, num_rates);
+
+	/* WAL is not a tablespace, so it is reported without a name */
+	snprintf(path, MAXPGPATH, "%s/pg_wal", DataDir);
+	PutTablespaceRow(tupstore, tupdesc, NULL, path, rates, num_rates);
+
+	/* Every user tablespace has an entry named by its OID in pg_tblspc */
+	snprintf(path, MAXPGPATH, "%s/pg_tblspc", DataDir);
+	dirp = opendir(path);
+	if (!dirp)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("could not open directory \"%s\": %m", path)));
+		return;
+	}
+
+	while ((ent = readdir(dirp)) != NULL)
+	{
+		char *tablespace_name;
+
+		if (!stringIsNumber(ent->d_name))
+			continue;
+
+		/* Skip leftovers of tablespaces that are being dropped */
+		tablespace_name = get_tablespace_name((Oid) strtoul(ent->d_name, NULL, 10));
+		if (tablespace_name == NULL)
+			continue;
+
+		snprintf(path, MAXPGPATH, "%s/pg_tblspc/%s", DataDir, ent->d_name);
+		PutTablespaceRow(tupstore, tupdesc, tablespace_name, path, rates, num_rates);
+	}
+
+	closedir(dirp);
+}
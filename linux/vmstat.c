@@ -0,0 +1,94 @@
+/*------------------------------------------------------------------------
+ * vmstat.c
+ *              Virtual memory statistics of /proc/vmstat
+ *
+ * Every counter of /proc/vmstat is reported with its cumulative value and,
+ * from the second call in a session on, its per second rate since the
+ * previous call.  Entries named nr_* are gauges, like the number of free
+ * or dirty pages, and have no rate; except for the few of them which count
+ * events, like the pages dirtied and written, listed in vmstat_nr_counters.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+static CounterBaseline vmstat_baseline;
+
+/* nr_* entries which are cumulative counters rather than gauges */
+static const char *const vmstat_nr_counters[] = {
+	"nr_dirtied", "nr_written", "nr_throttled_written", "nr_vmscan_write",
+	"nr_vmscan_immediate_reclaim", "nr_foll_pin_acquired", "nr_foll_pin_released"
+};
+
+void ReadVMStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc);
+static bool IsVMStatCounter(const char *name);
+
+static bool IsVMStatCounter(const char *name)
+{
+	int index;
+
+	if (strncmp(name, "nr_", 3) != 0)
+		return true;
+
+	for (index = 0; index < lengthof(vmstat_nr_counters); index++)
+	{
+		if (strcmp(name, vmstat_nr_counters[index]) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+void ReadVMStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum   values[Natts_vmstat];
+	bool    nulls[Natts_vmstat];
+	FILE    *vmstat_file;
+	char    *line_buf = NULL;
+	size_t  line_buf_size = 0;
+	char    name[COUNTER_BASELINE_KEY_LEN];
+	unsigned long long value;
+	float8  rate;
+
+	vmstat_file = fopen(VMSTAT_FILE_NAME, "r");
+	if (!vmstat_file)
+	{
+		ereport(DEBUG1,
+				(errcode_for_file_access(),
+					errmsg("can not open file %s for reading virtual memory statistics",
+						VMSTAT_FILE_NAME)));
+		return;
+	}
+
+	counter_baseline_begin(&vmstat_baseline);
+
+	while (getline(&line_buf, &line_buf_size, vmstat_file) >= 0)
+	{
+		if (sscanf(line_buf, "%63s %llu", name, &value) != 2)
+			continue;
+
+		memset(nulls, 0, sizeof(nulls));
+
+		values[Anum_vmstat_name] = CStringGetTextDatum(name);
+		values[Anum_vmstat_value] = UInt64GetDatum(value);
+
+		if (IsVMStatCounter(name) &&
+			counter_baseline_rate(&vmstat_baseline, name, value, &rate))
+			values[Anum_vmstat_per_sec] = Float8GetDatum(rate);
+		else
+			nulls[Anum_vmstat_per_sec] = true;
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	counter_baseline_end(&vmstat_baseline);
+
+	if (line_buf != NULL)
+		free(line_buf);
+
+	fclose(vmstat_file);
+}
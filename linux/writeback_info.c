@@ -0,0 +1,166 @@
+/*------------------------------------------------------------------------
+ * writeback_info.c
+ *              Dirty page writeback and throttling information
+ *
+ * The kernel starts background writeback once the dirty and writeback
+ * pages exceed the background threshold, and throttles the processes which
+ * dirty pages once they exceed the midpoint between the background and the
+ * dirty threshold, up to blocking them at the dirty threshold.  Both
+ * thresholds, as computed by the kernel from vm.dirty_*, are exported in
+ * /proc/vmstat.  The time until throttling is estimated from the rate at
+ * which pages are dirtied and written back since the previous call.
+ *
+ * Copyright (c) 2020, EnterpriseDB Corporation. All Rights Reserved.
+ *
+ *------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+#include "system_stats.h"
+
+#include <unistd.h>
+
+#define VM_SYSCTL_DIR               "/proc/sys/vm"
+#define VM_SYSCTL_VALUE_LEN         64
+
+/* writeback counters of /proc/vmstat, in pages */
+static const char *const writeback_vmstat_keys[] = {
+	"nr_dirty", "nr_writeback", "nr_dirty_threshold",
+	"nr_dirty_background_threshold", "nr_dirtied", "nr_written"
+};
+#define NUM_WRITEBACK_VMSTAT_KEYS   lengthof(writeback_vmstat_keys)
+
+enum
+{
+	WB_NR_DIRTY,
+	WB_NR_WRITEBACK,
+	WB_NR_DIRTY_THRESHOLD,
+	WB_NR_DIRTY_BACKGROUND_THRESHOLD,
+	WB_NR_DIRTIED,
+	WB_NR_WRITTEN
+};
+
+/* vm.dirty_* settings, in the order of the Anum_wb_vm_* columns */
+static const char *const vm_dirty_settings[] = {
+	"dirty_ratio", "dirty_background_ratio", "dirty_bytes",
+	"dirty_background_bytes", "dirty_expire_centisecs",
+	"dirty_writeback_centisecs"
+};
+#define NUM_VM_DIRTY_SETTINGS       lengthof(vm_dirty_settings)
+
+static CounterBaseline writeback_baseline;
+
+void ReadWritebackInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+
+void ReadWritebackInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	Datum         values[Natts_writeback_info];
+	bool          nulls[Natts_writeback_info];
+	MeminfoSample meminfo;
+	uint64        counters[NUM_WRITEBACK_VMSTAT_KEYS];
+	bool          found[NUM_WRITEBACK_VMSTAT_KEYS];
+	uint64        page_size = (uint64) sysconf(_SC_PAGESIZE);
+	uint64        dirty_bytes;
+	uint64        writeback_bytes;
+	uint64        background_threshold;
+	uint64        dirty_threshold;
+	uint64        throttle_threshold;
+	float8        dirtied_rate;
+	float8        written_rate;
+	bool          has_rates;
+	int           index;
+
+	memset(nulls, 0, sizeof(nulls));
+	memset(counters, 0, sizeof(counters));
+
+	if (!ReadKeyValueFile(VMSTAT_FILE_NAME, writeback_vmstat_keys, NUM_WRITEBACK_VMSTAT_KEYS,
+						  counters, found))
+		return;
+
+	/* Prefer /proc/meminfo, which reports the pages in bytes already */
+	if (ReadMeminfo(&meminfo) && meminfo.present[MEMINFO_DIRTY] &&
+		meminfo.present[MEMINFO_WRITEBACK])
+	{
+		dirty_bytes = meminfo.values[MEMINFO_DIRTY];
+		writeback_bytes = meminfo.values[MEMINFO_WRITEBACK];
+	}
+	else
+	{
+		dirty_bytes = counters[WB_NR_DIRTY] * page_size;
+		writeback_bytes = counters[WB_NR_WRITEBACK] * page_size;
+	}
+
+	values[Anum_wb_dirty_bytes] = UInt64GetDatum(dirty_bytes);
+	values[Anum_wb_writeback_bytes] = UInt64GetDatum(writeback_bytes);
+
+	/* Rates of pages entering and leaving the dirty state */
+	counter_baseline_begin(&writeback_baseline);
+	has_rates = found[WB_NR_DIRTIED] && found[WB_NR_WRITTEN];
+	has_rates &= counter_baseline_rate(&writeback_baseline, "nr_dirtied",
+									   counters[WB_NR_DIRTIED], &dirtied_rate);
+	has_rates &= counter_baseline_rate(&writeback_baseline, "nr_written",
+									   counters[WB_NR_WRITTEN], &written_rate);
+	counter_baseline_end(&writeback_baseline);
+
+	if (has_rates)
+	{
+		values[Anum_wb_dirtied_bytes_per_sec] = Float8GetDatum(dirtied_rate * page_size);
+		values[Anum_wb_written_bytes_per_sec] = Float8GetDatum(written_rate * page_size);
+	}
+	else
+	{
+		nulls[Anum_wb_dirtied_bytes_per_sec] = true;
+		nulls[Anum_wb_written_bytes_per_sec] = true;
+	}
+
+	if (found[WB_NR_DIRTY_THRESHOLD] && found[WB_NR_DIRTY_BACKGROUND_THRESHOLD] &&
+		counters[WB_NR_DIRTY_THRESHOLD] > 0 && counters[WB_NR_DIRTY_BACKGROUND_THRESHOLD] > 0)
+	{
+		background_threshold = counters[WB_NR_DIRTY_BACKGROUND_THRESHOLD] * page_size;
+		dirty_threshold = counters[WB_NR_DIRTY_THRESHOLD] * page_size;
+		throttle_threshold = (background_threshold + dirty_threshold) / 2;
+
+		values[Anum_wb_background_threshold_bytes] = UInt64GetDatum(background_threshold);
+		values[Anum_wb_dirty_threshold_bytes] = UInt64GetDatum(dirty_threshold);
+		values[Anum_wb_background_limit_percent] =
+			Float8GetDatum((float8) (dirty_bytes + writeback_bytes) * 100 / background_threshold);
+		values[Anum_wb_dirty_limit_percent] =
+			Float8GetDatum((float8) (dirty_bytes + writeback_bytes) * 100 / dirty_threshold);
+
+		/*
+		 * Writers are throttled from the midpoint of the thresholds on.  The
+		 * estimate only exists while dirty pages grow faster than they are
+		 * written back.
+		 */
+		if (dirty_bytes + writeback_bytes >= throttle_threshold)
+			values[Anum_wb_seconds_to_throttle] = Float8GetDatum(0);
+		else if (has_rates && dirtied_rate > written_rate)
+			values[Anum_wb_seconds_to_throttle] =
+				Float8GetDatum((float8) (throttle_threshold - dirty_bytes - writeback_bytes) /
+							   ((dirtied_rate - written_rate) * page_size));
+		else
+			nulls[Anum_wb_seconds_to_throttle] = true;
+	}
+	else
+	{
+		nulls[Anum_wb_background_threshold_bytes] = true;
+		nulls[Anum_wb_dirty_threshold_bytes] = true;
+		nulls[Anum_wb_background_limit_percent] = true;
+		nulls[Anum_wb_dirty_limit_percent] = true;
+		nulls[Anum_wb_seconds_to_throttle] = true;
+	}
+
+	for (index = 0; index < NUM_VM_DIRTY_SETTINGS; index++)
+	{
+		char file_name[MAXPGPATH];
+		char setting[VM_SYSCTL_VALUE_LEN];
+
+		snprintf(file_name, MAXPGPATH, "%s/%s", VM_SYSCTL_DIR, vm_dirty_settings[index]);
+		if (ReadFileLine(file_name, setting, VM_SYSCTL_VALUE_LEN))
+			values[Anum_wb_vm_dirty_ratio + index] = Int64GetDatum(strtoll(setting, NULL, 10));
+		else
+			nulls[Anum_wb_vm_dirty_ratio + index] = true;
+	}
+
+	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+}
@@ -216,10 +216,31 @@ SELECT
     count(*) FILTER (WHERE io_write_bytes < 0) = 0 AS no_negative_io_write
 FROM pg_sys_cpu_memory_by_process();
 
--- Verify function returns exactly 10 output columns
-SELECT array_length(proargnames, 1) = 10 AS correct_column_count
+-- Verify function has the include_smaps argument and 25 output columns
+SELECT array_length(proargnames, 1) = 26 AS correct_column_count
 FROM pg_proc WHERE proname = 'pg_sys_cpu_memory_by_process';
 
+-- Verify smaps_rollup memory is only read on request
+SELECT count(*) FILTER (WHERE pss_bytes IS NOT NULL) = 0 AS smaps_off_by_default
+FROM pg_sys_cpu_memory_by_process();
+
+SELECT
+    count(*) FILTER (WHERE uss_bytes > pss_bytes) = 0 AS uss_within_pss,
+    count(*) FILTER (WHERE pss_bytes < 0 OR shared_bytes < 0 OR anon_bytes < 0) = 0 AS valid_smaps
+FROM pg_sys_cpu_memory_by_process(include_smaps => true);
+
+-- IO wait is NULL when the kernel does not account block IO delays
+SELECT count(*) FILTER (WHERE io_wait_seconds < 0 OR io_wait_percent < 0 OR io_wait_percent > 100) = 0
+    AS valid_io_wait
+FROM pg_sys_cpu_memory_by_process();
+
+-- Rates and the IO character counters are never negative, NULL where not available
+SELECT
+    count(*) FILTER (WHERE minor_faults_per_sec < 0 OR major_faults_per_sec < 0) = 0 AS valid_fault_rates,
+    count(*) FILTER (WHERE io_read_bytes_per_sec < 0 OR io_write_bytes_per_sec < 0) = 0 AS valid_io_rates,
+    count(*) FILTER (WHERE rchar < 0 OR wchar < 0 OR syscr < 0 OR syscw < 0) = 0 AS valid_io_chars
+FROM pg_sys_cpu_memory_by_process();
+
 -- ============================================================================
 -- Test 12: Multiple calls (test caching and performance)
 -- ============================================================================
@@ -268,4 +289,369 @@ SELECT count(*) FROM pg_sys_os_info() WHERE 1=1;
 SELECT count(*) FROM pg_sys_cpu_info() WHERE 1=1;
 SELECT count(*) FROM pg_sys_memory_info() WHERE 1=1;
 
+-- ============================================================================
+-- Test 15: pg_sys_tablespace_io
+-- ============================================================================
+\echo '### Testing pg_sys_tablespace_io ###'
+
+-- Check that function returns rows (empty on platforms other than Linux)
+SELECT count(*) >= 0 AS has_rows FROM pg_sys_tablespace_io();
+
+-- Verify default tablespaces and WAL are reported at most once and values are reasonable
+SELECT
+    count(*) FILTER (WHERE tablespace_name = 'pg_default') <= 1 AS pg_default_valid,
+    count(*) FILTER (WHERE tablespace_name IS NULL) <= 1 AS wal_valid,
+    count(*) FILTER (WHERE free_space > total_space) = 0 AS free_less_than_total,
+    count(*) FILTER (WHERE reads_per_sec < 0 OR writes_per_sec < 0) = 0 AS no_negative_rates,
+    count(*) FILTER (WHERE busy_percent < 0 OR busy_percent > 100) = 0 AS busy_percent_valid
+FROM pg_sys_tablespace_io();
+
+-- ============================================================================
+-- Test 16: pg_sys_io_queue_depth
+-- ============================================================================
+\echo '### Testing pg_sys_io_queue_depth ###'
+
+-- Check that function exists (no rows unless the sampler is running)
+SELECT count(*) >= 0 AS has_devices FROM pg_sys_io_queue_depth();
+
+-- Verify histogram buckets add up to the number of samples
+SELECT
+    count(*) FILTER (WHERE depth_0 + depth_1 + depth_2_3 + depth_4_7 + depth_8_15 +
+        depth_16_31 + depth_32_63 + depth_64_plus <> samples) = 0 AS histogram_consistent,
+    count(*) FILTER (WHERE avg_depth > max_depth) = 0 AS avg_less_than_max
+FROM pg_sys_io_queue_depth();
+
+-- ============================================================================
+-- Test 17: pg_sys_disk_benchmark
+-- ============================================================================
+\echo '### Testing pg_sys_disk_benchmark ###'
+
+-- Run a minimal benchmark of the WAL directory
+SELECT
+    count(*) FILTER (WHERE operations < 1) = 0 AS has_operations,
+    count(*) FILTER (WHERE min_latency_us > p50_latency_us OR p50_latency_us > p90_latency_us
+        OR p90_latency_us > p99_latency_us OR p99_latency_us > max_latency_us) = 0 AS percentiles_ordered
+FROM pg_sys_disk_benchmark(NULL, 1, 5);
+
+-- Verify the benchmark file is removed
+SELECT count(*) = 0 AS files_removed
+FROM pg_ls_waldir() WHERE name LIKE 'system_stats_benchmark.%';
+
+-- ============================================================================
+-- Test 18: pg_sys_relation_fragmentation
+-- ============================================================================
+\echo '### Testing pg_sys_relation_fragmentation ###'
+
+-- Check the forks of a catalog table
+SELECT
+    count(*) FILTER (WHERE fork_name NOT IN ('main', 'fsm', 'vm', 'init')) = 0 AS valid_forks,
+    count(*) FILTER (WHERE segments < 1 OR size_bytes < 0) = 0 AS valid_sizes,
+    count(*) FILTER (WHERE small_extent_percent < 0 OR small_extent_percent > 100) = 0 AS valid_percent
+FROM pg_sys_relation_fragmentation('pg_class');
+
+-- Relations without storage return no rows
+SELECT count(*) = 0 AS no_storage FROM pg_sys_relation_fragmentation('pg_stat_activity');
+
+-- ============================================================================
+-- Test 19: pg_sys_dir_usage
+-- ============================================================================
+\echo '### Testing pg_sys_dir_usage ###'
+
+-- Walk the database directories one level deep
+SELECT
+    count(*) FILTER (WHERE depth > 1) = 0 AS depth_limited,
+    count(*) FILTER (WHERE size_bytes < 0 OR files < 0 OR directories < 0) = 0 AS valid_counts
+FROM pg_sys_dir_usage('base', 1);
+
+-- The usage of a directory includes its subdirectories
+SELECT count(*) = 0 AS totals_consistent
+FROM pg_sys_dir_usage('base', 1) r
+WHERE r.depth = 0
+  AND r.files < (SELECT coalesce(sum(files), 0) FROM pg_sys_dir_usage('base', 1) WHERE depth = 1);
+
+-- ============================================================================
+-- Test 20: pg_sys_memory_info_ext
+-- ============================================================================
+\echo '### Testing pg_sys_memory_info_ext ###'
+
+-- Check keys are unique and values are valid
+SELECT
+    count(*) = count(DISTINCT key) AS unique_keys,
+    count(*) FILTER (WHERE value < 0 OR unit NOT IN ('bytes', 'pages')) = 0 AS valid_values
+FROM pg_sys_memory_info_ext();
+
+-- Verify total memory matches pg_sys_memory_info()
+SELECT count(*) = 0 AS total_memory_consistent
+FROM pg_sys_memory_info() m, pg_sys_memory_info_ext() e
+WHERE e.key = 'MemTotal' AND m.total_memory <> e.value;
+
+-- ============================================================================
+-- Test 21: pg_sys_hugepage_info
+-- ============================================================================
+\echo '### Testing pg_sys_hugepage_info ###'
+
+-- Check huge page pools are consistent
+SELECT
+    count(*) FILTER (WHERE free_pages > total_pages + surplus_pages) = 0 AS valid_pools,
+    count(*) FILTER (WHERE shmem_huge_bytes > shmem_size_bytes) = 0 AS valid_shmem
+FROM pg_sys_hugepage_info();
+
+-- ============================================================================
+-- Test 22: pg_sys_numa_info and pg_sys_numa_placement
+-- ============================================================================
+\echo '### Testing pg_sys_numa_info and pg_sys_numa_placement ###'
+
+-- Check node memory is consistent
+SELECT
+    count(*) = count(DISTINCT node) AS unique_nodes,
+    count(*) FILTER (WHERE free_memory > total_memory) = 0 AS valid_memory
+FROM pg_sys_numa_info();
+
+-- Check placement rows are valid
+SELECT
+    count(*) FILTER (WHERE memory_type NOT IN ('shared_memory', 'private')) = 0 AS valid_types,
+    count(*) FILTER (WHERE bytes <= 0 OR node < 0) = 0 AS valid_bytes
+FROM pg_sys_numa_placement();
+
+-- ============================================================================
+-- Test 23: pg_sys_vmstat and pg_sys_kernel_activity
+-- ============================================================================
+\echo '### Testing pg_sys_vmstat and pg_sys_kernel_activity ###'
+
+-- Check counters are unique, and nothing has a rate on the first call
+SELECT
+    count(*) = count(DISTINCT name) AS unique_names,
+    count(*) FILTER (WHERE value < 0 OR per_sec < 0) = 0 AS valid_values,
+    count(*) FILTER (WHERE name LIKE 'nr\_%' AND per_sec IS NOT NULL) = 0 AS gauges_without_rate
+FROM pg_sys_vmstat();
+
+-- On the second call the nr_* event counters have a rate, the page counts still do not
+SELECT
+    count(*) FILTER (WHERE name IN ('nr_dirtied', 'nr_written') AND per_sec IS NULL) = 0 AS counters_with_rate,
+    count(*) FILTER (WHERE name IN ('nr_free_pages', 'nr_dirty', 'nr_writeback') AND per_sec IS NOT NULL) = 0 AS gauges_without_rate
+FROM pg_sys_vmstat();
+
+-- Check activity counters are valid, rates only exist after a first call
+SELECT
+    count(*) <= 1 AS single_row,
+    count(*) FILTER (WHERE context_switches < 0 OR forks < 0 OR interrupts < 0 OR
+                           procs_running < 0 OR procs_blocked < 0) = 0 AS valid_counters
+FROM pg_sys_kernel_activity();
+
+SELECT count(*) FILTER (WHERE context_switches_per_sec < 0 OR forks_per_sec < 0 OR
+                              interrupts_per_sec < 0 OR softirqs_per_sec < 0) = 0 AS valid_rates
+FROM pg_sys_kernel_activity();
+
+-- ============================================================================
+-- Test 24: pg_sys_writeback_info
+-- ============================================================================
+\echo '### Testing pg_sys_writeback_info ###'
+
+-- Check thresholds and estimates are consistent
+SELECT
+    count(*) <= 1 AS single_row,
+    count(*) FILTER (WHERE dirty_bytes < 0 OR writeback_bytes < 0) = 0 AS valid_memory,
+    count(*) FILTER (WHERE background_threshold_bytes > dirty_threshold_bytes) = 0 AS valid_thresholds,
+    count(*) FILTER (WHERE seconds_to_throttle < 0) = 0 AS valid_estimate
+FROM pg_sys_writeback_info();
+
+-- ============================================================================
+-- Test 25: pg_sys_memory_fragmentation
+-- ============================================================================
+\echo '### Testing pg_sys_memory_fragmentation ###'
+
+-- Check free blocks add up and the index is in range
+SELECT
+    count(*) FILTER (WHERE free_bytes <> free_blocks * block_bytes) = 0 AS valid_blocks,
+    count(*) FILTER (WHERE fragmentation_index < -1 OR fragmentation_index > 1) = 0 AS valid_index,
+    count(*) FILTER (WHERE hugepages_allocatable < 0 OR compact_fail > compact_stall) = 0 AS valid_counters
+FROM pg_sys_memory_fragmentation();
+
+-- ============================================================================
+-- Test 26: pg_sys_relation_cache_residency and pg_sys_database_cache_residency
+-- ============================================================================
+\echo '### Testing pg_sys_relation_cache_residency and pg_sys_database_cache_residency ###'
+
+-- Check the page cache residency of a catalog table
+SELECT
+    count(*) FILTER (WHERE fork_name NOT IN ('main', 'fsm', 'vm', 'init')) = 0 AS valid_forks,
+    count(*) FILTER (WHERE cached_percent < 0 OR cached_percent > 100) = 0 AS valid_percent,
+    count(*) FILTER (WHERE method NOT IN ('cachestat', 'mincore')) = 0 AS valid_method
+FROM pg_sys_relation_cache_residency('pg_class');
+
+-- Relations without storage return no rows
+SELECT count(*) = 0 AS no_storage FROM pg_sys_relation_cache_residency('pg_stat_activity');
+
+-- Check the ranking is limited and ordered by cached bytes
+SELECT
+    count(*) <= 5 AS limited,
+    bool_and(cached_bytes <= size_bytes + 8192) IS NOT FALSE AS valid_bytes
+FROM pg_sys_database_cache_residency(5);
+
+-- ============================================================================
+-- Test 27: pg_sys_pressure_events
+-- ============================================================================
+\echo '### Testing pg_sys_pressure_events ###'
+
+-- Events are only recorded by the psi monitor, check the rows are consistent
+SELECT
+    count(*) FILTER (WHERE resource NOT IN ('memory', 'io', 'cpu')) = 0 AS valid_resource,
+    count(*) FILTER (WHERE avg10 < 0 OR avg10 > 100) = 0 AS valid_avg10,
+    count(*) FILTER (WHERE process_rank < 1 OR process_rank > 5) = 0 AS valid_rank,
+    count(*) FILTER (WHERE rss_bytes <= 0) = 0 AS valid_rss
+FROM pg_sys_pressure_events();
+
+-- ============================================================================
+-- Test 28: pg_sys_pressure_info
+-- ============================================================================
+\echo '### Testing pg_sys_pressure_info ###'
+
+-- Check the averages are percentages and every resource is reported once per kind
+SELECT
+    count(*) FILTER (WHERE resource NOT IN ('cpu', 'memory', 'io', 'irq')) = 0 AS valid_resource,
+    count(*) FILTER (WHERE kind NOT IN ('some', 'full')) = 0 AS valid_kind,
+    count(*) FILTER (WHERE avg10 < 0 OR avg10 > 100 OR avg60 < 0 OR avg60 > 100
+                     OR avg300 < 0 OR avg300 > 100) = 0 AS valid_averages,
+    count(DISTINCT (resource, kind)) = count(*) AS unique_rows
+FROM pg_sys_pressure_info();
+
+-- The second call returns the stall rate since the first one
+SELECT count(*) >= 0 AS first_call FROM pg_sys_pressure_info();
+SELECT count(*) FILTER (WHERE stall_percent < 0 OR stall_percent > 100) = 0 AS valid_stall_percent
+FROM pg_sys_pressure_info();
+
+-- ============================================================================
+-- Test 29: pg_sys_cpu_usage_per_core and steal time
+-- ============================================================================
+\echo '### Testing pg_sys_cpu_usage_per_core ###'
+
+-- Check the steal time of the aggregate is a percentage or NULL
+SELECT count(*) FILTER (WHERE steal_time_percent < 0 OR steal_time_percent > 100) = 0 AS valid_steal
+FROM pg_sys_cpu_usage_info();
+
+-- The first call only remembers the baseline
+SELECT count(*) FILTER (WHERE user_percent IS NOT NULL) = 0 AS first_call_null
+FROM pg_sys_cpu_usage_per_core();
+
+-- Every CPU is reported once and the modes add up to about 100 percent
+SELECT pg_sleep(0.1) IS NOT NULL AS slept;
+SELECT
+    count(DISTINCT cpu) = count(*) AS unique_cpus,
+    count(*) FILTER (WHERE idle_percent < 0 OR idle_percent > 100
+                     OR steal_percent < 0 OR steal_percent > 100) = 0 AS valid_percent,
+    count(*) FILTER (WHERE abs(user_percent + nice_percent + system_percent + idle_percent +
+                               iowait_percent + irq_percent + softirq_percent +
+                               steal_percent - 100) > 1) = 0 AS sums_to_100
+FROM pg_sys_cpu_usage_per_core();
+
+-- ============================================================================
+-- Test 30: pg_sys_cpu_frequency
+-- ============================================================================
+\echo '### Testing pg_sys_cpu_frequency ###'
+
+-- Check every CPU is reported once with consistent limits (NULL in most VMs)
+SELECT
+    count(DISTINCT cpu) = count(*) AS unique_cpus,
+    count(*) FILTER (WHERE min_freq_hz > max_freq_hz) = 0 AS valid_limits,
+    count(*) FILTER (WHERE core_throttle_per_sec < 0 OR package_throttle_per_sec < 0) = 0 AS valid_rates
+FROM pg_sys_cpu_frequency();
+
+-- ============================================================================
+-- Test 31: pg_sys_cpu_idle_states
+-- ============================================================================
+\echo '### Testing pg_sys_cpu_idle_states ###'
+
+-- Check every state is reported once per CPU and the residency is a percentage
+SELECT
+    count(DISTINCT (cpu, state)) = count(*) AS unique_states,
+    count(*) FILTER (WHERE exit_latency_us < 0) = 0 AS valid_latency,
+    count(*) FILTER (WHERE time_percent < 0 OR time_percent > 100) = 0 AS valid_percent
+FROM pg_sys_cpu_idle_states();
+
+-- ============================================================================
+-- Test 32: pg_sys_cpu_topology and pg_sys_cpu_info
+-- ============================================================================
+\echo '### Testing pg_sys_cpu_topology ###'
+
+-- Check every online CPU has a socket and core, and each cache is listed once per CPU
+SELECT
+    count(*) FILTER (WHERE online AND (socket IS NULL OR core IS NULL)) = 0 AS online_have_core,
+    count(DISTINCT (cpu, cache_level, cache_type)) = count(*) AS unique_caches,
+    count(*) FILTER (WHERE cache_size_kb < 0) = 0 AS valid_cache_size
+FROM pg_sys_cpu_topology();
+
+-- pg_sys_cpu_info counts the online CPUs, sockets and cores of the topology
+SELECT
+    i.logical_processor = (SELECT count(DISTINCT cpu) FROM pg_sys_cpu_topology() WHERE online) AS logical_matches,
+    i.physical_processor <= i.no_of_cores AND i.no_of_cores <= i.logical_processor AS counts_ordered
+FROM pg_sys_cpu_info() i
+WHERE EXISTS (SELECT 1 FROM pg_sys_cpu_topology())
+UNION ALL
+SELECT true, true
+WHERE NOT EXISTS (SELECT 1 FROM pg_sys_cpu_topology());
+
+-- ============================================================================
+-- Test 33: pg_sys_os_info host identity cache
+-- ============================================================================
+\echo '### Testing pg_sys_os_info host identity cache ###'
+
+-- The cached identity is the same from one call to the next
+SELECT
+    count(DISTINCT (name, version, host_name, architecture, last_bootup_time)) = 1 AS identity_stable
+FROM (SELECT * FROM pg_sys_os_info() UNION ALL SELECT * FROM pg_sys_os_info()) s;
+
+-- ============================================================================
+-- Test 34: pg_sys_interrupts, pg_sys_softirqs and pg_sys_softnet_stat
+-- ============================================================================
+\echo '### Testing pg_sys_interrupts ###'
+
+-- Check each source is reported once per CPU, shares are percentages and imbalance between 0 and 1
+SELECT
+    count(DISTINCT (irq, cpu)) = count(*) AS unique_interrupts,
+    count(*) FILTER (WHERE share_percent < 0 OR share_percent > 100) = 0 AS valid_share,
+    count(*) FILTER (WHERE imbalance < 0 OR imbalance > 1) = 0 AS valid_imbalance
+FROM pg_sys_interrupts();
+
+SELECT
+    count(DISTINCT (softirq, cpu)) = count(*) AS unique_softirqs,
+    count(*) FILTER (WHERE per_sec < 0) = 0 AS valid_rate,
+    count(*) FILTER (WHERE imbalance < 0 OR imbalance > 1) = 0 AS valid_imbalance
+FROM pg_sys_softirqs();
+
+SELECT
+    count(DISTINCT cpu) = count(*) AS unique_cpus,
+    count(*) FILTER (WHERE dropped_per_sec < 0 OR time_squeeze_per_sec < 0) = 0 AS valid_rates
+FROM pg_sys_softnet_stat();
+
+-- ============================================================================
+-- Test 35: pg_sys_runqueue_info
+-- ============================================================================
+\echo '### Testing pg_sys_runqueue_info ###'
+
+-- No rows without shared_preload_libraries, otherwise one per window with consistent maximums
+SELECT
+    count(*) IN (0, 3) AS valid_windows,
+    count(*) FILTER (WHERE runnable_max < runnable_avg OR blocked_max < blocked_avg OR load_max < load_avg) = 0 AS valid_max,
+    count(*) FILTER (WHERE runnable_per_cpu < 0 OR load_per_cpu < 0) = 0 AS valid_per_cpu
+FROM pg_sys_runqueue_info();
+
+-- ============================================================================
+-- Test 36: pg_sys_cpu_sched_by_process
+-- ============================================================================
+\echo '### Testing pg_sys_cpu_sched_by_process ###'
+
+-- The backend is listed at most once (no rows on other platforms), and rates are NULL on the first call
+SELECT
+    count(*) FILTER (WHERE pid = pg_backend_pid()) <= 1 AS has_backend,
+    count(*) FILTER (WHERE run_time_ns < 0 OR wait_time_ns < 0 OR timeslices < 0) = 0 AS valid_times,
+    count(*) FILTER (WHERE run_time_percent IS NOT NULL OR voluntary_ctxt_switches_per_sec IS NOT NULL) = 0 AS first_call_rates
+FROM pg_sys_cpu_sched_by_process();
+
+-- The second call has rates for the processes still running
+SELECT
+    count(*) FILTER (WHERE run_time_percent < 0 OR run_time_percent > 100 OR
+                             wait_time_percent < 0 OR wait_time_percent > 100) = 0 AS valid_percent,
+    count(*) FILTER (WHERE pid = pg_backend_pid() AND voluntary_ctxt_switches_per_sec IS NULL) = 0 AS valid_rates
+FROM pg_sys_cpu_sched_by_process();
+
 \echo '### All tests completed ###'
@@ -1,7 +1,7 @@
 -- ============================================================================
--- Upgrade path test: system_stats 3.0 -> 4.0
+-- Upgrade path test: system_stats 3.0 -> 4.0 -> 5.0
 -- ============================================================================
-\echo '### Testing upgrade path 3.0 -> 4.0 ###'
+\echo '### Testing upgrade path 3.0 -> 4.0 -> 5.0 ###'
 
 -- Clean slate
 DROP EXTENSION IF EXISTS system_stats CASCADE;
@@ -42,5 +42,25 @@ SELECT proargnames[1:6] = ARRAY['pid','name','running_since_seconds',
     'cpu_usage','memory_usage','memory_bytes'] AS first_6_columns_match
 FROM pg_proc WHERE proname = 'pg_sys_cpu_memory_by_process';
 
+-- Upgrade to 5.0
+ALTER EXTENSION system_stats UPDATE TO '5.0';
+
+-- Verify new version
+SELECT extversion = '5.0' AS is_version_5
+FROM pg_extension WHERE extname = 'system_stats';
+
+-- Verify functions added in 5.0 exist
+SELECT count(*) = 1 AS has_tablespace_io
+FROM pg_proc WHERE proname = 'pg_sys_tablespace_io';
+
+-- Verify pg_sys_cpu_memory_by_process was recreated with include_smaps
+SELECT proargnames[1] = 'include_smaps' AND array_length(proargnames, 1) = 26
+    AS v5_has_smaps_columns
+FROM pg_proc WHERE proname = 'pg_sys_cpu_memory_by_process';
+
+-- Verify pg_sys_cpu_usage_info was recreated with steal_time_percent
+SELECT proargnames[12] = 'steal_time_percent' AS v5_has_steal_column
+FROM pg_proc WHERE proname = 'pg_sys_cpu_usage_info';
+
 -- Clean up
 DROP EXTENSION system_stats;
@@ -0,0 +1,607 @@
+-- Upgrade from 4.0 to 5.0
+-- Adds pg_sys_tablespace_io, pg_sys_io_queue_depth, pg_sys_disk_benchmark
+-- pg_sys_relation_fragmentation, pg_sys_dir_usage, pg_sys_memory_info_ext
+-- pg_sys_hugepage_info, pg_sys_numa_info, pg_sys_numa_placement
+-- pg_sys_vmstat, pg_sys_kernel_activity, pg_sys_writeback_info
+-- pg_sys_memory_fragmentation, pg_sys_relation_cache_residency
+-- pg_sys_database_cache_residency, pg_sys_pressure_events
+-- pg_sys_pressure_info, pg_sys_cpu_usage_per_core, pg_sys_cpu_frequency
+-- pg_sys_cpu_idle_states, pg_sys_cpu_topology, pg_sys_interrupts
+-- pg_sys_softirqs, pg_sys_softnet_stat, pg_sys_runqueue_info
+-- pg_sys_cpu_sched_by_process
+--
+-- Adds the include_smaps argument and pss_bytes, uss_bytes, shared_bytes,
+-- anon_bytes, page_table_bytes, io_wait_seconds, io_wait_percent,
+-- minor_faults_per_sec, major_faults_per_sec, io_read_bytes_per_sec,
+-- io_write_bytes_per_sec, rchar, wchar, syscr and syscw to
+-- pg_sys_cpu_memory_by_process, and steal_time_percent to
+-- pg_sys_cpu_usage_info
+--
+-- NOTE: This takes an AccessExclusiveLock on pg_sys_cpu_memory_by_process
+-- and pg_sys_cpu_usage_info. Any views or materialized views that depend on
+-- the old function signatures must be dropped before running this upgrade.
+
+DROP FUNCTION IF EXISTS pg_sys_cpu_memory_by_process();
+
+-- CPU and memory information by process function
+CREATE FUNCTION pg_sys_cpu_memory_by_process(
+    IN include_smaps boolean DEFAULT false,
+    OUT pid int,
+    OUT name text,
+    OUT running_since_seconds int8,
+    OUT cpu_usage float4,
+    OUT memory_usage float4,
+    OUT memory_bytes int8,
+    OUT virtual_memory_bytes int8,
+    OUT swap_usage_bytes int8,
+    OUT io_read_bytes int8,
+    OUT io_write_bytes int8,
+    OUT pss_bytes int8,
+    OUT uss_bytes int8,
+    OUT shared_bytes int8,
+    OUT anon_bytes int8,
+    OUT page_table_bytes int8,
+    OUT io_wait_seconds float8,
+    OUT io_wait_percent float4,
+    OUT minor_faults_per_sec float8,
+    OUT major_faults_per_sec float8,
+    OUT io_read_bytes_per_sec float8,
+    OUT io_write_bytes_per_sec float8,
+    OUT rchar int8,
+    OUT wchar int8,
+    OUT syscr int8,
+    OUT syscw int8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_cpu_memory_by_process(boolean) FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_cpu_memory_by_process(boolean) TO monitor_system_stats;
+
+DROP FUNCTION IF EXISTS pg_sys_cpu_usage_info();
+
+-- This function will fetch the time spent in percentage by CPU in each mode
+-- as described by arguments
+CREATE FUNCTION pg_sys_cpu_usage_info(
+    OUT usermode_normal_process_percent float4,
+    OUT usermode_niced_process_percent float4,
+    OUT kernelmode_process_percent float4,
+    OUT idle_mode_percent float4,
+    OUT IO_completion_percent float4,
+    OUT servicing_irq_percent float4,
+    OUT servicing_softirq_percent float4,
+    OUT user_time_percent float4,
+    OUT processor_time_percent float4,
+    OUT privileged_time_percent float4,
+    OUT interrupt_time_percent float4,
+    OUT steal_time_percent float4
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_cpu_usage_info() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_cpu_usage_info() TO monitor_system_stats;
+
+-- Tablespace and WAL IO information function
+CREATE FUNCTION pg_sys_tablespace_io(
+    OUT tablespace_name text,
+    OUT location text,
+    OUT device_name text,
+    OUT backing_devices text,
+    OUT total_space int8,
+    OUT free_space int8,
+    OUT reads_per_sec float8,
+    OUT writes_per_sec float8,
+    OUT read_bytes_per_sec float8,
+    OUT write_bytes_per_sec float8,
+    OUT busy_percent float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_tablespace_io() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_tablespace_io() TO monitor_system_stats;
+
+-- IO queue depth information function
+-- Requires system_stats in shared_preload_libraries, returns no rows otherwise
+CREATE FUNCTION pg_sys_io_queue_depth(
+    OUT device_name text,
+    OUT samples int8,
+    OUT current_depth int,
+    OUT avg_depth float8,
+    OUT max_depth int,
+    OUT depth_0 int8,
+    OUT depth_1 int8,
+    OUT depth_2_3 int8,
+    OUT depth_4_7 int8,
+    OUT depth_8_15 int8,
+    OUT depth_16_31 int8,
+    OUT depth_32_63 int8,
+    OUT depth_64_plus int8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_io_queue_depth() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_io_queue_depth() TO monitor_system_stats;
+
+-- Disk benchmark function, restricted to superusers as it writes to the given directory
+-- Defaults to the WAL directory, latencies are in microseconds
+CREATE FUNCTION pg_sys_disk_benchmark(
+    IN path text DEFAULT NULL,
+    IN file_size_mb int DEFAULT 64,
+    IN iterations int DEFAULT 100,
+    OUT test text,
+    OUT directory text,
+    OUT device_name text,
+    OUT operations int8,
+    OUT min_latency_us float8,
+    OUT avg_latency_us float8,
+    OUT p50_latency_us float8,
+    OUT p90_latency_us float8,
+    OUT p99_latency_us float8,
+    OUT max_latency_us float8,
+    OUT bytes_per_sec float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_disk_benchmark(text, int, int) FROM PUBLIC;
+
+-- Relation file fragmentation function
+CREATE FUNCTION pg_sys_relation_fragmentation(
+    IN relation regclass,
+    OUT fork_name text,
+    OUT segments int,
+    OUT size_bytes int8,
+    OUT extents int8,
+    OUT avg_extent_bytes float8,
+    OUT small_extent_percent float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT;
+
+REVOKE ALL ON FUNCTION pg_sys_relation_fragmentation(regclass) FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_relation_fragmentation(regclass) TO monitor_system_stats;
+
+-- Directory usage function, restricted to the data directory and tablespaces
+CREATE FUNCTION pg_sys_dir_usage(
+    IN path text,
+    IN max_depth int DEFAULT 1,
+    OUT directory text,
+    OUT depth int,
+    OUT size_bytes int8,
+    OUT allocated_bytes int8,
+    OUT files int8,
+    OUT directories int8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT;
+
+REVOKE ALL ON FUNCTION pg_sys_dir_usage(text, int) FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_dir_usage(text, int) TO monitor_system_stats;
+
+-- Extended memory information function
+CREATE FUNCTION pg_sys_memory_info_ext(
+    OUT key text,
+    OUT value int8,
+    OUT unit text
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_memory_info_ext() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_memory_info_ext() TO monitor_system_stats;
+
+-- Huge page information function
+CREATE FUNCTION pg_sys_hugepage_info(
+    OUT page_size int8,
+    OUT total_pages int8,
+    OUT free_pages int8,
+    OUT reserved_pages int8,
+    OUT surplus_pages int8,
+    OUT thp_enabled text,
+    OUT thp_defrag text,
+    OUT thp_shmem_enabled text,
+    OUT thp_fault_alloc int8,
+    OUT thp_fault_fallback int8,
+    OUT thp_collapse_alloc int8,
+    OUT thp_collapse_alloc_failed int8,
+    OUT shmem_size_bytes int8,
+    OUT shmem_page_size int8,
+    OUT shmem_huge_bytes int8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_hugepage_info() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_hugepage_info() TO monitor_system_stats;
+
+-- NUMA node information function
+CREATE FUNCTION pg_sys_numa_info(
+    OUT node int,
+    OUT cpus text,
+    OUT total_memory int8,
+    OUT free_memory int8,
+    OUT used_memory int8,
+    OUT file_pages int8,
+    OUT numa_hit int8,
+    OUT numa_miss int8,
+    OUT numa_foreign int8,
+    OUT interleave_hit int8,
+    OUT local_node int8,
+    OUT other_node int8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_numa_info() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_numa_info() TO monitor_system_stats;
+
+-- NUMA placement of PostgreSQL memory function
+CREATE FUNCTION pg_sys_numa_placement(
+    OUT pid int,
+    OUT process text,
+    OUT memory_type text,
+    OUT node int,
+    OUT bytes int8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_numa_placement() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_numa_placement() TO monitor_system_stats;
+
+-- Virtual memory statistics function
+CREATE FUNCTION pg_sys_vmstat(
+    OUT name text,
+    OUT value int8,
+    OUT per_sec float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_vmstat() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_vmstat() TO monitor_system_stats;
+
+-- Kernel activity information function
+CREATE FUNCTION pg_sys_kernel_activity(
+    OUT context_switches int8,
+    OUT context_switches_per_sec float8,
+    OUT forks int8,
+    OUT forks_per_sec float8,
+    OUT interrupts int8,
+    OUT interrupts_per_sec float8,
+    OUT softirqs int8,
+    OUT softirqs_per_sec float8,
+    OUT procs_running int,
+    OUT procs_blocked int
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_kernel_activity() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_kernel_activity() TO monitor_system_stats;
+
+-- Dirty page writeback information function
+CREATE FUNCTION pg_sys_writeback_info(
+    OUT dirty_bytes int8,
+    OUT writeback_bytes int8,
+    OUT background_threshold_bytes int8,
+    OUT dirty_threshold_bytes int8,
+    OUT background_limit_percent float8,
+    OUT dirty_limit_percent float8,
+    OUT dirtied_bytes_per_sec float8,
+    OUT written_bytes_per_sec float8,
+    OUT seconds_to_throttle float8,
+    OUT vm_dirty_ratio int8,
+    OUT vm_dirty_background_ratio int8,
+    OUT vm_dirty_bytes int8,
+    OUT vm_dirty_background_bytes int8,
+    OUT vm_dirty_expire_centisecs int8,
+    OUT vm_dirty_writeback_centisecs int8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_writeback_info() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_writeback_info() TO monitor_system_stats;
+
+-- Memory fragmentation information function
+CREATE FUNCTION pg_sys_memory_fragmentation(
+    OUT node int,
+    OUT zone text,
+    OUT block_order int,
+    OUT block_bytes int8,
+    OUT free_blocks int8,
+    OUT free_bytes int8,
+    OUT fragmentation_index float8,
+    OUT hugepages_allocatable int8,
+    OUT compact_stall int8,
+    OUT compact_stall_per_sec float8,
+    OUT compact_fail int8,
+    OUT compact_fail_per_sec float8,
+    OUT allocstall int8,
+    OUT allocstall_per_sec float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_memory_fragmentation() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_memory_fragmentation() TO monitor_system_stats;
+
+-- Page cache residency of a relation function
+CREATE FUNCTION pg_sys_relation_cache_residency(
+    IN relation regclass,
+    OUT fork_name text,
+    OUT segments int,
+    OUT size_bytes int8,
+    OUT cached_bytes int8,
+    OUT dirty_bytes int8,
+    OUT writeback_bytes int8,
+    OUT cached_percent float8,
+    OUT recently_evicted_bytes int8,
+    OUT method text
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT;
+
+REVOKE ALL ON FUNCTION pg_sys_relation_cache_residency(regclass) FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_relation_cache_residency(regclass) TO monitor_system_stats;
+
+-- Relations of the current database ranked by page cache usage function
+CREATE FUNCTION pg_sys_database_cache_residency(
+    IN max_relations int DEFAULT 50,
+    OUT relation regclass,
+    OUT relfilenode oid,
+    OUT size_bytes int8,
+    OUT cached_bytes int8,
+    OUT dirty_bytes int8,
+    OUT writeback_bytes int8,
+    OUT cached_percent float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT;
+
+REVOKE ALL ON FUNCTION pg_sys_database_cache_residency(int) FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_database_cache_residency(int) TO monitor_system_stats;
+
+-- Pressure stall trigger events function
+CREATE FUNCTION pg_sys_pressure_events(
+    OUT event_time timestamptz,
+    OUT resource text,
+    OUT trigger text,
+    OUT avg10 float8,
+    OUT total_stall_us int8,
+    OUT process_rank int,
+    OUT pid int,
+    OUT process_name text,
+    OUT process_state text,
+    OUT rss_bytes int8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_pressure_events() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_pressure_events() TO monitor_system_stats;
+
+-- Pressure stall information function
+CREATE FUNCTION pg_sys_pressure_info(
+    OUT resource text,
+    OUT kind text,
+    OUT avg10 float8,
+    OUT avg60 float8,
+    OUT avg300 float8,
+    OUT total_stall_us int8,
+    OUT stall_percent float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_pressure_info() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_pressure_info() TO monitor_system_stats;
+
+-- Per core CPU usage information function
+CREATE FUNCTION pg_sys_cpu_usage_per_core(
+    OUT cpu int,
+    OUT user_percent float8,
+    OUT nice_percent float8,
+    OUT system_percent float8,
+    OUT idle_percent float8,
+    OUT iowait_percent float8,
+    OUT irq_percent float8,
+    OUT softirq_percent float8,
+    OUT steal_percent float8,
+    OUT guest_percent float8,
+    OUT guest_nice_percent float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_cpu_usage_per_core() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_cpu_usage_per_core() TO monitor_system_stats;
+
+-- CPU frequency and thermal throttling information function
+CREATE FUNCTION pg_sys_cpu_frequency(
+    OUT cpu int,
+    OUT scaling_driver text,
+    OUT governor text,
+    OUT energy_performance_preference text,
+    OUT current_freq_hz int8,
+    OUT min_freq_hz int8,
+    OUT max_freq_hz int8,
+    OUT hardware_max_freq_hz int8,
+    OUT core_throttle_count int8,
+    OUT core_throttle_per_sec float8,
+    OUT package_throttle_count int8,
+    OUT package_throttle_per_sec float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_cpu_frequency() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_cpu_frequency() TO monitor_system_stats;
+
+-- CPU idle state information function
+CREATE FUNCTION pg_sys_cpu_idle_states(
+    OUT cpu int,
+    OUT state int,
+    OUT name text,
+    OUT exit_latency_us int8,
+    OUT target_residency_us int8,
+    OUT disabled boolean,
+    OUT usage int8,
+    OUT usage_per_sec float8,
+    OUT time_us int8,
+    OUT time_percent float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_cpu_idle_states() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_cpu_idle_states() TO monitor_system_stats;
+
+-- CPU topology and cache hierarchy information function
+CREATE FUNCTION pg_sys_cpu_topology(
+    OUT cpu int,
+    OUT online boolean,
+    OUT socket int,
+    OUT die int,
+    OUT core int,
+    OUT numa_node int,
+    OUT thread_siblings text,
+    OUT cache_level int,
+    OUT cache_type text,
+    OUT cache_size_kb int,
+    OUT cache_line_size int,
+    OUT cache_ways int,
+    OUT cache_shared_cpus text
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_cpu_topology() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_cpu_topology() TO monitor_system_stats;
+
+-- Interrupt distribution per CPU function
+CREATE FUNCTION pg_sys_interrupts(
+    OUT irq text,
+    OUT cpu int,
+    OUT count int8,
+    OUT per_sec float8,
+    OUT share_percent float8,
+    OUT imbalance float8,
+    OUT description text
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_interrupts() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_interrupts() TO monitor_system_stats;
+
+-- Softirq distribution per CPU function
+CREATE FUNCTION pg_sys_softirqs(
+    OUT softirq text,
+    OUT cpu int,
+    OUT count int8,
+    OUT per_sec float8,
+    OUT share_percent float8,
+    OUT imbalance float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_softirqs() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_softirqs() TO monitor_system_stats;
+
+-- Network receive processing per CPU function
+CREATE FUNCTION pg_sys_softnet_stat(
+    OUT cpu int,
+    OUT processed int8,
+    OUT processed_per_sec float8,
+    OUT dropped int8,
+    OUT dropped_per_sec float8,
+    OUT time_squeeze int8,
+    OUT time_squeeze_per_sec float8,
+    OUT received_rps int8,
+    OUT flow_limit_count int8,
+    OUT backlog_length int8,
+    OUT share_percent float8,
+    OUT imbalance float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_softnet_stat() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_softnet_stat() TO monitor_system_stats;
+
+-- Run queue sampled by the background sampler function
+CREATE FUNCTION pg_sys_runqueue_info(
+    OUT window_seconds int,
+    OUT samples int,
+    OUT runnable_avg float8,
+    OUT runnable_max int,
+    OUT blocked_avg float8,
+    OUT blocked_max int,
+    OUT load_avg float8,
+    OUT load_max int,
+    OUT runnable_per_cpu float8,
+    OUT load_per_cpu float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_runqueue_info() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_runqueue_info() TO monitor_system_stats;
+
+-- Process scheduling information function
+CREATE FUNCTION pg_sys_cpu_sched_by_process(
+    OUT pid int,
+    OUT name text,
+    OUT processor int,
+    OUT run_time_ns int8,
+    OUT run_time_percent float8,
+    OUT wait_time_ns int8,
+    OUT wait_time_percent float8,
+    OUT timeslices int8,
+    OUT timeslices_per_sec float8,
+    OUT voluntary_ctxt_switches int8,
+    OUT voluntary_ctxt_switches_per_sec float8,
+    OUT involuntary_ctxt_switches int8,
+    OUT involuntary_ctxt_switches_per_sec float8,
+    OUT migrations int8,
+    OUT migrations_per_sec float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_sys_cpu_sched_by_process() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_sys_cpu_sched_by_process() TO monitor_system_stats;
@@ -26,7 +26,7 @@
 #include "utils/timestamp.h"
 
 #ifdef PG_MODULE_MAGIC_EXT
-PG_MODULE_MAGIC_EXT(.name = "system_stats", .version = "4.0");
+PG_MODULE_MAGIC_EXT(.name = "system_stats", .version = "5.0");
 #else
 PG_MODULE_MAGIC;
 #endif
@@ -49,6 +49,32 @@ PGDLLEXPORT Datum pg_sys_disk_info(PG_FUNCTION_ARGS);
 PGDLLEXPORT Datum pg_sys_process_info(PG_FUNCTION_ARGS);
 PGDLLEXPORT Datum pg_sys_network_info(PG_FUNCTION_ARGS);
 PGDLLEXPORT Datum pg_sys_cpu_memory_by_process(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_tablespace_io(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_io_queue_depth(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_disk_benchmark(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_relation_fragmentation(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_dir_usage(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_memory_info_ext(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_hugepage_info(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_numa_info(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_numa_placement(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_vmstat(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_kernel_activity(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_writeback_info(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_memory_fragmentation(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_relation_cache_residency(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_database_cache_residency(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_pressure_events(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_pressure_info(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_cpu_usage_per_core(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_cpu_frequency(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_cpu_idle_states(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_cpu_topology(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_interrupts(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_softirqs(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_softnet_stat(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_runqueue_info(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum pg_sys_cpu_sched_by_process(PG_FUNCTION_ARGS);
 
 void initialize_wmi_connection();
 void uninitialize_wmi_connection();
@@ -64,6 +90,32 @@ PG_FUNCTION_INFO_V1(pg_sys_disk_info);
 PG_FUNCTION_INFO_V1(pg_sys_process_info);
 PG_FUNCTION_INFO_V1(pg_sys_network_info);
 PG_FUNCTION_INFO_V1(pg_sys_cpu_memory_by_process);
+PG_FUNCTION_INFO_V1(pg_sys_tablespace_io);
+PG_FUNCTION_INFO_V1(pg_sys_io_queue_depth);
+PG_FUNCTION_INFO_V1(pg_sys_disk_benchmark);
+PG_FUNCTION_INFO_V1(pg_sys_relation_fragmentation);
+PG_FUNCTION_INFO_V1(pg_sys_dir_usage);
+PG_FUNCTION_INFO_V1(pg_sys_memory_info_ext);
+PG_FUNCTION_INFO_V1(pg_sys_hugepage_info);
+PG_FUNCTION_INFO_V1(pg_sys_numa_info);
+PG_FUNCTION_INFO_V1(pg_sys_numa_placement);
+PG_FUNCTION_INFO_V1(pg_sys_vmstat);
+PG_FUNCTION_INFO_V1(pg_sys_kernel_activity);
+PG_FUNCTION_INFO_V1(pg_sys_writeback_info);
+PG_FUNCTION_INFO_V1(pg_sys_memory_fragmentation);
+PG_FUNCTION_INFO_V1(pg_sys_relation_cache_residency);
+PG_FUNCTION_INFO_V1(pg_sys_database_cache_residency);
+PG_FUNCTION_INFO_V1(pg_sys_pressure_events);
+PG_FUNCTION_INFO_V1(pg_sys_pressure_info);
+PG_FUNCTION_INFO_V1(pg_sys_cpu_usage_per_core);
+PG_FUNCTION_INFO_V1(pg_sys_cpu_frequency);
+PG_FUNCTION_INFO_V1(pg_sys_cpu_idle_states);
+PG_FUNCTION_INFO_V1(pg_sys_cpu_topology);
+PG_FUNCTION_INFO_V1(pg_sys_interrupts);
+PG_FUNCTION_INFO_V1(pg_sys_softirqs);
+PG_FUNCTION_INFO_V1(pg_sys_softnet_stat);
+PG_FUNCTION_INFO_V1(pg_sys_runqueue_info);
+PG_FUNCTION_INFO_V1(pg_sys_cpu_sched_by_process);
 
 void _PG_init(void)
 {
@@ -72,6 +124,10 @@ void _PG_init(void)
 #ifdef WIN32
 	initialize_wmi_connection();
 #endif
+#ifdef __linux__
+	/* define GUCs and, when preloaded, start the background sampler */
+	InitSampler();
+#endif
 }
 
 void _PG_fini(void)
@@ -556,7 +612,8 @@ pg_sys_network_info(PG_FUNCTION_ARGS)
 /*
  * pg_sys_cpu_memory_by_process
  *
- * This function will give cpu and memory usage by process ID
+ * This function will give cpu and memory usage by process ID, and when
+ * include_smaps is true the proportional and unique memory of each process
  *
  */
 Datum
@@ -600,7 +657,1436 @@ pg_sys_cpu_memory_by_process(PG_FUNCTION_ARGS)
 	MemoryContextSwitchTo(oldcontext);
 
 	/* Fetch the system cpu and memory usage by process */
-	ReadCPUMemoryByProcess(tupstore, tupdesc);
+	ReadCPUMemoryByProcess(tupstore, tupdesc, PG_GETARG_BOOL(0));
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_tablespace_io
+ *
+ * This function will give the block device, free space and IO rates
+ * backing the data directory, WAL and every tablespace
+ *
+ */
+Datum
+pg_sys_tablespace_io(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of tablespace IO information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_tablespace_io);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the tablespace IO information and put in tuple store */
+	ReadTablespaceIOInformation(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_io_queue_depth
+ *
+ * This function will give the queue depth histograms of block devices
+ * sampled by the background sampler
+ *
+ */
+Datum
+pg_sys_io_queue_depth(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of IO queue depth information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_io_queue_depth);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the IO queue depth information and put in tuple store */
+	ReadIOQueueDepthInformation(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_disk_benchmark
+ *
+ * This function will run a bounded benchmark of the storage behind a
+ * directory and give the latency distribution of each test
+ *
+ */
+Datum
+pg_sys_disk_benchmark(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of disk benchmark
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	char            directory[MAXPGPATH];
+	int             file_size_mb;
+	int             iterations;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+					errmsg("must be superuser to run pg_sys_disk_benchmark()")));
+
+	// Benchmark the WAL directory unless told otherwise
+	if (PG_ARGISNULL(0))
+		snprintf(directory, MAXPGPATH, "%s/pg_wal", DataDir);
+	else
+		text_to_cstring_buffer(PG_GETARG_TEXT_PP(0), directory, MAXPGPATH);
+
+	file_size_mb = PG_ARGISNULL(1) ? DISK_BENCHMARK_DEFAULT_FILE_SIZE_MB : PG_GETARG_INT32(1);
+	iterations = PG_ARGISNULL(2) ? DISK_BENCHMARK_DEFAULT_ITERATIONS : PG_GETARG_INT32(2);
+
+	if (file_size_mb < 1 || file_size_mb > DISK_BENCHMARK_MAX_FILE_SIZE_MB)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					errmsg("file_size_mb must be between 1 and %d", DISK_BENCHMARK_MAX_FILE_SIZE_MB)));
+
+	if (iterations < 1 || iterations > DISK_BENCHMARK_MAX_ITERATIONS)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					errmsg("iterations must be between 1 and %d", DISK_BENCHMARK_MAX_ITERATIONS)));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_disk_benchmark);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Run the disk benchmark and put the results in tuple store */
+	RunDiskBenchmark(tupstore, tupdesc, directory, file_size_mb, iterations);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_relation_fragmentation
+ *
+ * This function will give the extent counts and fragmentation of the
+ * segment files of each fork of a relation
+ *
+ */
+Datum
+pg_sys_relation_fragmentation(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of relation fragmentation
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	Oid             relid = PG_GETARG_OID(0);
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_relation_fragmentation);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the relation fragmentation and put in tuple store */
+	ReadRelationFragmentation(tupstore, tupdesc, relid);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_dir_usage
+ *
+ * This function will give the disk usage of a directory in the data
+ * directory or a tablespace, and of its subdirectories down to max_depth
+ *
+ */
+Datum
+pg_sys_dir_usage(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of directory usage
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	char            *path = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	int             max_depth = PG_GETARG_INT32(1);
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	if (max_depth < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					errmsg("max_depth must not be negative")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_dir_usage);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the directory usage and put in tuple store */
+	ReadDirectoryUsage(tupstore, tupdesc, path, max_depth);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_memory_info_ext
+ *
+ * This function will give every memory counter the kernel reports,
+ * one row per counter
+ *
+ */
+Datum
+pg_sys_memory_info_ext(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of extended memory information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_memory_info_ext);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the extended memory information and put in tuple store */
+	ReadMemoryInformationExt(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_hugepage_info
+ *
+ * This function will give the huge page pools, the transparent huge page
+ * settings and the huge page backing of the shared memory segment
+ *
+ */
+Datum
+pg_sys_hugepage_info(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of huge page information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_hugepage_info);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the huge page information and put in tuple store */
+	ReadHugePageInformation(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_numa_info
+ *
+ * This function will give the memory and the NUMA allocation counters
+ * of each NUMA node
+ *
+ */
+Datum
+pg_sys_numa_info(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of NUMA information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_numa_info);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the NUMA information and put in tuple store */
+	ReadNumaInformation(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_numa_placement
+ *
+ * This function will give how the shared memory segment and the private
+ * memory of each PostgreSQL process are spread across NUMA nodes
+ *
+ */
+Datum
+pg_sys_numa_placement(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of NUMA placement
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_numa_placement);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the NUMA placement and put in tuple store */
+	ReadNumaPlacement(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_vmstat
+ *
+ * This function will give the counters of /proc/vmstat with their per
+ * second rates since the previous call
+ *
+ */
+Datum
+pg_sys_vmstat(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of virtual memory statistics
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_vmstat);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the virtual memory statistics and put in tuple store */
+	ReadVMStatistics(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_kernel_activity
+ *
+ * This function will give the context switches, forks, interrupts and
+ * runnable processes of the system with per second rates since the
+ * previous call
+ *
+ */
+Datum
+pg_sys_kernel_activity(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of kernel activity information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_kernel_activity);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the kernel activity information and put in tuple store */
+	ReadKernelActivity(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_writeback_info
+ *
+ * This function will give the dirty and writeback memory, how close it
+ * is to the dirty limits and the estimated time until writers get
+ * throttled
+ *
+ */
+Datum
+pg_sys_writeback_info(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of writeback information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_writeback_info);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the writeback information and put in tuple store */
+	ReadWritebackInformation(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_memory_fragmentation
+ *
+ * This function will give the free blocks of each order of each memory
+ * zone, the huge pages each node could allocate and the compaction and
+ * reclaim stalls
+ *
+ */
+Datum
+pg_sys_memory_fragmentation(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of memory fragmentation information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_memory_fragmentation);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the memory fragmentation information and put in tuple store */
+	ReadMemoryFragmentation(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_relation_cache_residency
+ *
+ * This function will give how much of the segment files of each fork of
+ * a relation is in the page cache
+ *
+ */
+Datum
+pg_sys_relation_cache_residency(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of relation cache residency
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	Oid             relid = PG_GETARG_OID(0);
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_relation_cache_residency);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the relation cache residency and put in tuple store */
+	ReadRelationCacheResidency(tupstore, tupdesc, relid);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_database_cache_residency
+ *
+ * This function will give the relations of the current database with the
+ * most bytes in the page cache
+ *
+ */
+Datum
+pg_sys_database_cache_residency(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of database cache residency
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	int             max_relations = PG_GETARG_INT32(0);
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	if (max_relations < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					errmsg("max_relations must be at least 1")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_database_cache_residency);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the database cache residency and put in tuple store */
+	ReadDatabaseCacheResidency(tupstore, tupdesc, max_relations);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_pressure_events
+ *
+ * This function will give the pressure stall trigger events recorded by
+ * the background worker
+ *
+ */
+Datum
+pg_sys_pressure_events(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of pressure stall trigger events
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_pressure_events);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the pressure stall trigger events and put in tuple store */
+	ReadPressureEvents(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_pressure_info
+ *
+ * This function will give the pressure stall information of the CPU,
+ * memory, IO and interrupts
+ *
+ */
+Datum
+pg_sys_pressure_info(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of pressure stall information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_pressure_info);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the pressure stall information and put in tuple store */
+	ReadPressureInformation(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_cpu_usage_per_core
+ *
+ * This function will give the time spent in percentage by each CPU in each
+ * mode since the previous call
+ *
+ */
+Datum
+pg_sys_cpu_usage_per_core(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of per core cpu usage information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_cpu_usage_per_core);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the per core cpu usage information and put in tuple store */
+	ReadCPUUsagePerCore(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_cpu_frequency
+ *
+ * This function will give the frequency scaling settings and thermal
+ * throttling counters of each CPU
+ *
+ */
+Datum
+pg_sys_cpu_frequency(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of cpu frequency information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_cpu_frequency);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the cpu frequency information and put in tuple store */
+	ReadCPUFrequency(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_cpu_idle_states
+ *
+ * This function will give the idle states of each CPU with their usage
+ * and residency since the previous call
+ *
+ */
+Datum
+pg_sys_cpu_idle_states(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of cpu idle state information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_cpu_idle_states);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the cpu idle state information and put in tuple store */
+	ReadCPUIdleStates(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_cpu_topology
+ *
+ * This function will give the socket, core, NUMA node and caches of each
+ * CPU
+ *
+ */
+Datum
+pg_sys_cpu_topology(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of cpu topology information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_cpu_topology);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the cpu topology information and put in tuple store */
+	ReadCPUTopology(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_interrupts
+ *
+ * This function will give the count and rate of each interrupt on each CPU
+ * and how unevenly it is spread over the CPUs
+ *
+ */
+Datum
+pg_sys_interrupts(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of interrupt information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_interrupts);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the interrupt information and put in tuple store */
+	ReadInterrupts(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_softirqs
+ *
+ * This function will give the count and rate of each softirq on each CPU
+ * and how unevenly it is spread over the CPUs
+ *
+ */
+Datum
+pg_sys_softirqs(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of softirq information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_softirqs);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the softirq information and put in tuple store */
+	ReadSoftirqs(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_softnet_stat
+ *
+ * This function will give the packets processed, dropped and time squeezes
+ * of the network receive processing of each CPU
+ *
+ */
+Datum
+pg_sys_softnet_stat(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of softnet information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_softnet_stat);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the softnet information and put in tuple store */
+	ReadSoftnetStat(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_runqueue_info
+ *
+ * This function will give the average and maximum number of runnable and
+ * blocked tasks over the last 1, 10 and 60 seconds
+ *
+ */
+Datum
+pg_sys_runqueue_info(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of run queue information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_runqueue_info);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the run queue information and put in tuple store */
+	ReadRunqueueInformation(tupstore, tupdesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_sys_cpu_sched_by_process
+ *
+ * This function will give the scheduling of each process: the CPU it last
+ * ran on, the time it ran and waited for a CPU, its context switches and
+ * migrations
+ *
+ */
+Datum
+pg_sys_cpu_sched_by_process(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	/*
+	 * Tuple descriptor describing the result of process scheduling information
+	 */
+	TupleDesc       tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext   per_query_ctx;
+	MemoryContext   oldcontext;
+
+	// check to see if caller supports us returning a tuplestore
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					errmsg("materialize mode required, but it is not allowed in this context")));
+
+	// Switch into long-lived context to construct returned data structures
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	// Build a tuple descriptor for our result type
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == Natts_cpu_sched_by_process);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Fetch the process scheduling information and put in tuple store */
+	ReadCPUSchedulingByProcess(tupstore, tupdesc);
 
 	return (Datum) 0;
 }
@@ -17,6 +17,7 @@
 
 #include "miscadmin.h"
 #include "access/tupdesc.h"
+#include "datatype/timestamp.h"
 #include "utils/tuplestore.h"
 #include "utils/builtins.h"
 
@@ -28,27 +29,273 @@ void ReadIOAnalysisInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
 
 /* prototypes for system CPU information functions */
 void ReadCPUInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadCPUFrequency(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadCPUIdleStates(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadCPUTopology(Tuplestorestate *tupstore, TupleDesc tupdesc);
 
 /* prototypes for system memory information functions */
 void ReadMemoryInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadMemoryInformationExt(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadHugePageInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadNumaInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadNumaPlacement(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadVMStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadWritebackInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadMemoryFragmentation(Tuplestorestate *tupstore, TupleDesc tupdesc);
 
 /* prototypes for system load average information functions */
 void ReadLoadAvgInformations(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadRunqueueInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
 
 /* prototypes for operating system information functions */
 void ReadOSInformations(Tuplestorestate *tupstore, TupleDesc tupdesc);
 
 /* prototypes for system CPU usage information functions */
 void ReadCPUUsageStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadKernelActivity(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadCPUUsagePerCore(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadInterrupts(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadSoftirqs(Tuplestorestate *tupstore, TupleDesc tupdesc);
 
 /* prototypes for system process information functions */
 void ReadProcessInformations(Tuplestorestate *tupstore, TupleDesc tupdesc);
 
 /* prototypes for system network information functions */
 void ReadNetworkInformations(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadSoftnetStat(Tuplestorestate *tupstore, TupleDesc tupdesc);
 
 /* prototypes for system network information functions */
-void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadCPUMemoryByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc, bool include_smaps);
+void ReadCPUSchedulingByProcess(Tuplestorestate *tupstore, TupleDesc tupdesc);
+
+/* prototypes for tablespace IO information functions */
+void ReadTablespaceIOInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+
+/* prototypes for IO queue depth information functions */
+void ReadIOQueueDepthInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+
+/* prototypes for pressure stall information functions */
+void ReadPressureInformation(Tuplestorestate *tupstore, TupleDesc tupdesc);
+void ReadPressureEvents(Tuplestorestate *tupstore, TupleDesc tupdesc);
+
+/* prototypes for disk benchmark functions */
+void RunDiskBenchmark(Tuplestorestate *tupstore, TupleDesc tupdesc,
+		const char *directory, int file_size_mb, int iterations);
+
+/* prototypes for relation fragmentation functions */
+void ReadRelationFragmentation(Tuplestorestate *tupstore, TupleDesc tupdesc, Oid relid);
+void ReadRelationCacheResidency(Tuplestorestate *tupstore, TupleDesc tupdesc, Oid relid);
+void ReadDatabaseCacheResidency(Tuplestorestate *tupstore, TupleDesc tupdesc, int max_relations);
+
+/* prototypes for directory usage functions */
+void ReadDirectoryUsage(Tuplestorestate *tupstore, TupleDesc tupdesc,
+		const char *path, int max_depth);
+
+#ifdef __linux__
+/*
+ * prototypes for the background sampler, which is only available when the
+ * extension is loaded through shared_preload_libraries
+ */
+#define SYSTEM_STATS_LWLOCK_TRANCHE              "system_stats"
+#define SAMPLER_LOCK_IO_QUEUE_DEPTH              0
+#define SAMPLER_LOCK_PSI_EVENTS                  1
+#define SAMPLER_LOCK_CPU_TOPOLOGY                2
+#define SAMPLER_LOCK_HOST_IDENTITY               3
+#define SAMPLER_LOCK_RUNQUEUE                    4
+#define NUM_SAMPLER_LOCKS                        5
+
+extern int sampler_interval_ms;
+void InitSampler(void);
+
+Size IOQueueDepthShmemSize(void);
+void IOQueueDepthShmemInit(void);
+void SampleIOQueueDepth(void);
+
+void DefinePsiMonitorVariables(void);
+void RegisterPsiMonitor(void);
+Size PsiEventsShmemSize(void);
+void PsiEventsShmemInit(void);
+
+Size CPUTopologyShmemSize(void);
+void CPUTopologyShmemInit(void);
+void SampleCPUTopology(void);
+
+void DefineHostIdentityVariables(void);
+Size HostIdentityShmemSize(void);
+void HostIdentityShmemInit(void);
+void SampleHostIdentity(void);
+
+Size RunqueueShmemSize(void);
+void RunqueueShmemInit(void);
+void SampleRunqueue(void);
+#endif
+
+#ifdef __linux__
+/*
+ * Model of the CPUs and their caches, built once from sysfs and kept in
+ * shared memory, or in backend memory when the extension is not preloaded
+ */
+#define CPU_TOPOLOGY_MAX_CPUS                    1024
+#define CPU_TOPOLOGY_MAX_CACHES                  2048
+#define CPU_TOPOLOGY_MAX_CPU_CACHES              8
+#define CPU_TOPOLOGY_LIST_LEN                    96
+#define CPU_TOPOLOGY_NAME_LEN                    128
+
+typedef struct CPUTopologyCache
+{
+	int    level;
+	char   type[16];                           /* Data, Instruction or Unified */
+	int    size_kb;
+	int    line_size;
+	int    ways;
+	char   shared_cpus[CPU_TOPOLOGY_LIST_LEN];
+} CPUTopologyCache;
+
+typedef struct CPUTopologyCPU
+{
+	int    cpu;
+	bool   online;
+	int    package_id;
+	int    die_id;
+	int    core_id;
+	int    node;                               /* -1 without NUMA */
+	char   thread_siblings[CPU_TOPOLOGY_LIST_LEN];
+	int    num_caches;
+	int    caches[CPU_TOPOLOGY_MAX_CPU_CACHES]; /* indexes into caches */
+} CPUTopologyCPU;
+
+typedef struct CPUTopology
+{
+	char             online_cpus[CPU_TOPOLOGY_LIST_LEN]; /* to detect hotplug */
+	char             vendor[CPU_TOPOLOGY_NAME_LEN];
+	char             model_name[CPU_TOPOLOGY_NAME_LEN];
+	char             family[16];
+	char             model[16];
+	char             architecture[32];
+	uint64           clock_speed_hz;
+	int              num_online;
+	int              num_packages;
+	int              num_cores;
+	int              num_cpus;
+	int              num_caches;
+	CPUTopologyCPU   cpus[CPU_TOPOLOGY_MAX_CPUS];
+	CPUTopologyCache caches[CPU_TOPOLOGY_MAX_CACHES];
+} CPUTopology;
+
+CPUTopology *GetCPUTopology(void);
+#endif
+
+#ifdef __linux__
+/*
+ * Identity of the host, which hardly ever changes.  It is refreshed every
+ * system_stats.host_identity_ttl and the DNS domain is resolved in the
+ * background, so that reading it never waits on the resolver.
+ */
+#define HOST_IDENTITY_NAME_LEN                   256
+
+typedef struct HostIdentity
+{
+	TimestampTz refreshed_at;                  /* 0 until first built */
+	char        os_name[HOST_IDENTITY_NAME_LEN];
+	char        version[HOST_IDENTITY_NAME_LEN];
+	char        architecture[HOST_IDENTITY_NAME_LEN];
+	char        host_name[HOST_IDENTITY_NAME_LEN];
+	char        domain_name[HOST_IDENTITY_NAME_LEN];
+	TimestampTz boot_time;
+	bool        has_os_name;
+	bool        has_uname;
+	bool        has_host_name;
+	bool        has_domain_name;
+	bool        domain_from_dns;               /* else from resolv.conf */
+	bool        has_boot_time;
+} HostIdentity;
+
+extern int host_identity_ttl_s;
+void GetHostIdentity(HostIdentity *identity);
+#endif
+
+#ifdef __linux__
+/* keys of /proc/meminfo, in the order the kernel prints them */
+typedef enum MeminfoKey
+{
+	MEMINFO_MEM_TOTAL,
+	MEMINFO_MEM_FREE,
+	MEMINFO_MEM_AVAILABLE,
+	MEMINFO_BUFFERS,
+	MEMINFO_CACHED,
+	MEMINFO_SWAP_CACHED,
+	MEMINFO_ACTIVE,
+	MEMINFO_INACTIVE,
+	MEMINFO_ACTIVE_ANON,
+	MEMINFO_INACTIVE_ANON,
+	MEMINFO_ACTIVE_FILE,
+	MEMINFO_INACTIVE_FILE,
+	MEMINFO_UNEVICTABLE,
+	MEMINFO_MLOCKED,
+	MEMINFO_HIGH_TOTAL,
+	MEMINFO_HIGH_FREE,
+	MEMINFO_LOW_TOTAL,
+	MEMINFO_LOW_FREE,
+	MEMINFO_SWAP_TOTAL,
+	MEMINFO_SWAP_FREE,
+	MEMINFO_ZSWAP,
+	MEMINFO_ZSWAPPED,
+	MEMINFO_DIRTY,
+	MEMINFO_WRITEBACK,
+	MEMINFO_ANON_PAGES,
+	MEMINFO_MAPPED,
+	MEMINFO_SHMEM,
+	MEMINFO_KRECLAIMABLE,
+	MEMINFO_SLAB,
+	MEMINFO_SRECLAIMABLE,
+	MEMINFO_SUNRECLAIM,
+	MEMINFO_KERNEL_STACK,
+	MEMINFO_SHADOW_CALL_STACK,
+	MEMINFO_PAGE_TABLES,
+	MEMINFO_SEC_PAGE_TABLES,
+	MEMINFO_NFS_UNSTABLE,
+	MEMINFO_BOUNCE,
+	MEMINFO_WRITEBACK_TMP,
+	MEMINFO_COMMIT_LIMIT,
+	MEMINFO_COMMITTED_AS,
+	MEMINFO_VMALLOC_TOTAL,
+	MEMINFO_VMALLOC_USED,
+	MEMINFO_VMALLOC_CHUNK,
+	MEMINFO_PERCPU,
+	MEMINFO_HARDWARE_CORRUPTED,
+	MEMINFO_ANON_HUGE_PAGES,
+	MEMINFO_SHMEM_HUGE_PAGES,
+	MEMINFO_SHMEM_PMD_MAPPED,
+	MEMINFO_FILE_HUGE_PAGES,
+	MEMINFO_FILE_PMD_MAPPED,
+	MEMINFO_CMA_TOTAL,
+	MEMINFO_CMA_FREE,
+	MEMINFO_UNACCEPTED,
+	MEMINFO_BALLOON,
+	MEMINFO_HUGEPAGES_TOTAL,
+	MEMINFO_HUGEPAGES_FREE,
+	MEMINFO_HUGEPAGES_RSVD,
+	MEMINFO_HUGEPAGES_SURP,
+	MEMINFO_HUGEPAGESIZE,
+	MEMINFO_HUGETLB,
+	MEMINFO_DIRECTMAP_4K,
+	MEMINFO_DIRECTMAP_2M,
+	MEMINFO_DIRECTMAP_4M,
+	MEMINFO_DIRECTMAP_1G,
+	NUM_MEMINFO_KEYS
+} MeminfoKey;
+
+/* one read of /proc/meminfo, values in bytes except for the huge page counts */
+typedef struct MeminfoSample
+{
+	uint64 values[NUM_MEMINFO_KEYS];
+	bool   present[NUM_MEMINFO_KEYS];
+	bool   in_bytes[NUM_MEMINFO_KEYS];
+} MeminfoSample;
+
+bool ReadMeminfo(MeminfoSample *sample);
+const char *MeminfoKeyName(MeminfoKey key);
+#endif
 
 #ifndef WIN32
 /* prototypes for common string manipulations and command execution functions */
@@ -60,6 +307,26 @@ float fl_round(float val);
 bool read_process_status(int *active_processes, int *running_processes,
 		int *sleeping_processes, int *stopped_processes, int *zombie_processes, int *total_threads);
 void ReadFileContent(const char *file_name, uint64 *data);
+bool ReadFileLine(const char *file_name, char *buf, size_t len);
+bool ReadKeyValueFile(const char *file_name, const char *const *keys, int num_keys,
+		uint64 *values, bool *found);
+
+/* pressure stall information of a resource, from /proc/pressure */
+#define PRESSURE_DIR                             "/proc/pressure"
+typedef struct PressureStall
+{
+	float8 avg10;
+	float8 avg60;
+	float8 avg300;
+	uint64 total_us;
+	bool   present;
+} PressureStall;
+
+bool ReadPressureStall(const char *resource, PressureStall *some, PressureStall *full);
+
+/* CPUs of sysfs */
+#define CPU_SYSFS_DIR                            "/sys/devices/system/cpu"
+int *ListSysfsCPUs(int *num_cpus);
 
 /* prototypes for system disk information functions */
 bool ignoreFileSystemTypes(char *fs_mnt);
@@ -67,6 +334,32 @@ bool ignoreMountPoints(char *fs_mnt);
 
 /* prototypes for system memory information functions */
 uint64_t ConvertToBytes(char *line_buf);
+
+/* prototypes for block device resolution functions */
+bool ResolveBlockDevice(const char *path, char *device_name, size_t device_len,
+		char *backing_devices, size_t backing_len);
+
+/* remembered sample of cumulative counters used to compute rates */
+#define COUNTER_BASELINE_KEY_LEN                 64
+typedef struct CounterBaseline
+{
+	TimestampTz sample_time;     /* time of the remembered sample, 0 if none */
+	float8      elapsed_secs;    /* seconds between remembered and current sample */
+	int         count;
+	int         size;
+	char        (*keys)[COUNTER_BASELINE_KEY_LEN];
+	uint64      *values;
+	TimestampTz next_time;       /* sample being collected */
+	int         next_count;
+	int         next_size;
+	int         last_match;      /* index of the previous key found */
+	char        (*next_keys)[COUNTER_BASELINE_KEY_LEN];
+	uint64      *next_values;
+} CounterBaseline;
+
+void counter_baseline_begin(CounterBaseline *baseline);
+bool counter_baseline_rate(CounterBaseline *baseline, const char *key, uint64 value, float8 *rate);
+void counter_baseline_end(CounterBaseline *baseline);
 #else
 void initialize_wmi_connection();
 void uninitialize_wmi_connection();
@@ -131,7 +424,6 @@ int is_process_running(int pid);
 #define Anum_l3cache_size                        15
 
 /* Macros for Memory information */
-#define MEMORY_READ_COUNT                        5
 #define Natts_memory_info                        12
 #define MEMORY_FILE_NAME                         "/proc/meminfo"
 #define Anum_total_memory                        0
@@ -147,6 +439,96 @@ int is_process_running(int pid);
 #define Anum_total_page_file                     10
 #define Anum_avail_page_file                     11
 
+/* Macros for extended memory information */
+#define Natts_memory_info_ext                    3
+#define MEMINFO_READ_BUFFER                      8192
+#define Anum_meminfo_key                         0
+#define Anum_meminfo_value                       1
+#define Anum_meminfo_unit                        2
+
+/* Macros for huge page information */
+#define Natts_hugepage_info                      15
+#define Anum_hp_page_size                        0
+#define Anum_hp_total_pages                      1
+#define Anum_hp_free_pages                       2
+#define Anum_hp_reserved_pages                   3
+#define Anum_hp_surplus_pages                    4
+#define Anum_hp_thp_enabled                      5
+#define Anum_hp_thp_defrag                       6
+#define Anum_hp_thp_shmem_enabled                7
+#define Anum_hp_thp_fault_alloc                  8
+#define Anum_hp_thp_fault_fallback               9
+#define Anum_hp_thp_collapse_alloc               10
+#define Anum_hp_thp_collapse_alloc_failed        11
+#define Anum_hp_shmem_size_bytes                 12
+#define Anum_hp_shmem_page_size                  13
+#define Anum_hp_shmem_huge_bytes                 14
+
+/* Macros for NUMA information */
+#define Natts_numa_info                          12
+#define Anum_numa_node                           0
+#define Anum_numa_cpus                           1
+#define Anum_numa_total_memory                   2
+#define Anum_numa_free_memory                    3
+#define Anum_numa_used_memory                    4
+#define Anum_numa_file_pages                     5
+#define Anum_numa_hit                            6
+#define Anum_numa_miss                           7
+#define Anum_numa_foreign                        8
+#define Anum_numa_interleave_hit                 9
+#define Anum_numa_local_node                     10
+#define Anum_numa_other_node                     11
+
+/* Macros for NUMA placement */
+#define Natts_numa_placement                     5
+#define Anum_numa_pl_pid                         0
+#define Anum_numa_pl_process                     1
+#define Anum_numa_pl_memory_type                 2
+#define Anum_numa_pl_node                        3
+#define Anum_numa_pl_bytes                       4
+
+/* Macros for virtual memory statistics */
+#define Natts_vmstat                             3
+#define VMSTAT_FILE_NAME                         "/proc/vmstat"
+#define Anum_vmstat_name                         0
+#define Anum_vmstat_value                        1
+#define Anum_vmstat_per_sec                      2
+
+/* Macros for writeback information */
+#define Natts_writeback_info                     15
+#define Anum_wb_dirty_bytes                      0
+#define Anum_wb_writeback_bytes                  1
+#define Anum_wb_background_threshold_bytes       2
+#define Anum_wb_dirty_threshold_bytes            3
+#define Anum_wb_background_limit_percent         4
+#define Anum_wb_dirty_limit_percent              5
+#define Anum_wb_dirtied_bytes_per_sec            6
+#define Anum_wb_written_bytes_per_sec            7
+#define Anum_wb_seconds_to_throttle              8
+#define Anum_wb_vm_dirty_ratio                   9
+#define Anum_wb_vm_dirty_background_ratio        10
+#define Anum_wb_vm_dirty_bytes                   11
+#define Anum_wb_vm_dirty_background_bytes        12
+#define Anum_wb_vm_dirty_expire_centisecs        13
+#define Anum_wb_vm_dirty_writeback_centisecs     14
+
+/* Macros for memory fragmentation information */
+#define Natts_memory_fragmentation               14
+#define Anum_mfrag_node                          0
+#define Anum_mfrag_zone                          1
+#define Anum_mfrag_block_order                   2
+#define Anum_mfrag_block_bytes                   3
+#define Anum_mfrag_free_blocks                   4
+#define Anum_mfrag_free_bytes                    5
+#define Anum_mfrag_fragmentation_index           6
+#define Anum_mfrag_hugepages_allocatable         7
+#define Anum_mfrag_compact_stall                 8
+#define Anum_mfrag_compact_stall_per_sec         9
+#define Anum_mfrag_compact_fail                  10
+#define Anum_mfrag_compact_fail_per_sec          11
+#define Anum_mfrag_allocstall                    12
+#define Anum_mfrag_allocstall_per_sec            13
+
 /* Macros for load average information */
 #define CPU_IO_LOAD_AVG_FILE                     "/proc/loadavg"
 #define Natts_load_avg_info                      4
@@ -155,6 +537,19 @@ int is_process_running(int pid);
 #define Anum_load_avg_ten_minutes                2
 #define Anum_load_avg_fifteen_minutes            3
 
+/* Macros for run queue information */
+#define Natts_runqueue_info                      10
+#define Anum_rq_window_seconds                   0
+#define Anum_rq_samples                          1
+#define Anum_rq_runnable_avg                     2
+#define Anum_rq_runnable_max                     3
+#define Anum_rq_blocked_avg                      4
+#define Anum_rq_blocked_max                      5
+#define Anum_rq_load_avg                         6
+#define Anum_rq_load_max                         7
+#define Anum_rq_runnable_per_cpu                 8
+#define Anum_rq_load_per_cpu                     9
+
 /* Macros for operating system information */
 #define Natts_os_info                            10
 #define OS_INFO_FILE_NAME                        "/etc/os-release"
@@ -173,7 +568,7 @@ int is_process_running(int pid);
 #define Anum_os_up_since_seconds                 9
 
 /* Macros for system CPU usage information */
-#define Natts_cpu_usage_stats                    11
+#define Natts_cpu_usage_stats                    12
 #define CPU_USAGE_STATS_FILENAME                 "/proc/stat"
 #define Anum_usermode_normal_process             0
 #define Anum_usermode_niced_process              1
@@ -186,6 +581,104 @@ int is_process_running(int pid);
 #define Anum_percent_processor_time              8
 #define Anum_percent_privileged_time             9
 #define Anum_percent_interrupt_time              10
+#define Anum_steal_time                          11
+
+/* Macros for per core CPU usage information */
+#define Natts_cpu_usage_per_core                 11
+#define Anum_core_cpu                            0
+#define Anum_core_user_percent                   1
+#define Anum_core_nice_percent                   2
+#define Anum_core_system_percent                 3
+#define Anum_core_idle_percent                   4
+#define Anum_core_iowait_percent                 5
+#define Anum_core_irq_percent                    6
+#define Anum_core_softirq_percent                7
+#define Anum_core_steal_percent                  8
+#define Anum_core_guest_percent                  9
+#define Anum_core_guest_nice_percent             10
+
+/* Macros for interrupt and softirq information, softirqs have no description */
+#define Natts_interrupts                         7
+#define Natts_softirqs                           6
+#define Anum_irq_name                            0
+#define Anum_irq_cpu                             1
+#define Anum_irq_count                           2
+#define Anum_irq_per_sec                         3
+#define Anum_irq_share_percent                   4
+#define Anum_irq_imbalance                       5
+#define Anum_irq_description                     6
+
+/* Macros for softnet information */
+#define Natts_softnet_stat                       12
+#define Anum_softnet_cpu                         0
+#define Anum_softnet_processed                   1
+#define Anum_softnet_processed_per_sec           2
+#define Anum_softnet_dropped                     3
+#define Anum_softnet_dropped_per_sec             4
+#define Anum_softnet_time_squeeze                5
+#define Anum_softnet_time_squeeze_per_sec        6
+#define Anum_softnet_received_rps                7
+#define Anum_softnet_flow_limit_count            8
+#define Anum_softnet_backlog_length              9
+#define Anum_softnet_share_percent               10
+#define Anum_softnet_imbalance                   11
+
+/* Macros for CPU topology information */
+#define Natts_cpu_topology                       13
+#define Anum_topo_cpu                            0
+#define Anum_topo_online                         1
+#define Anum_topo_socket                         2
+#define Anum_topo_die                            3
+#define Anum_topo_core                           4
+#define Anum_topo_node                           5
+#define Anum_topo_thread_siblings                6
+#define Anum_topo_cache_level                    7
+#define Anum_topo_cache_type                     8
+#define Anum_topo_cache_size_kb                  9
+#define Anum_topo_cache_line_size                10
+#define Anum_topo_cache_ways                     11
+#define Anum_topo_cache_shared_cpus              12
+
+/* Macros for CPU frequency information */
+#define Natts_cpu_frequency                      12
+#define Anum_freq_cpu                            0
+#define Anum_freq_scaling_driver                 1
+#define Anum_freq_governor                       2
+#define Anum_freq_energy_performance_preference  3
+#define Anum_freq_current_hz                     4
+#define Anum_freq_min_hz                         5
+#define Anum_freq_max_hz                         6
+#define Anum_freq_hardware_max_hz                7
+#define Anum_freq_core_throttle_count            8
+#define Anum_freq_core_throttle_per_sec          9
+#define Anum_freq_package_throttle_count         10
+#define Anum_freq_package_throttle_per_sec       11
+
+/* Macros for CPU idle state information */
+#define Natts_cpu_idle_states                    10
+#define Anum_cstate_cpu                          0
+#define Anum_cstate_state                        1
+#define Anum_cstate_name                         2
+#define Anum_cstate_exit_latency_us              3
+#define Anum_cstate_target_residency_us          4
+#define Anum_cstate_disabled                     5
+#define Anum_cstate_usage                        6
+#define Anum_cstate_usage_per_sec                7
+#define Anum_cstate_time_us                      8
+#define Anum_cstate_time_percent                 9
+
+/* Macros for kernel activity information */
+#define Natts_kernel_activity                    10
+#define Anum_ka_context_switches                 0
+#define Anum_ka_context_switches_per_sec         1
+#define Anum_ka_forks                            2
+#define Anum_ka_forks_per_sec                    3
+#define Anum_ka_interrupts                       4
+#define Anum_ka_interrupts_per_sec               5
+#define Anum_ka_softirqs                         6
+#define Anum_ka_softirqs_per_sec                 7
+#define Anum_ka_procs_running                    8
+#define Anum_ka_procs_blocked                    9
 
 /* Macros for system processes information */
 #define Natts_process_info                       5
@@ -211,7 +704,7 @@ int is_process_running(int pid);
 
 /* Macros for cpu and memory information
  * by process*/
-#define Natts_cpu_memory_info_by_process         10
+#define Natts_cpu_memory_info_by_process         25
 #define Anum_process_pid                         0
 #define Anum_process_name                        1
 #define Anum_process_running_since               2
@@ -222,5 +715,149 @@ int is_process_running(int pid);
 #define Anum_process_swap_usage_bytes             7
 #define Anum_process_io_read_bytes                8
 #define Anum_process_io_write_bytes               9
+#define Anum_process_pss_bytes                    10
+#define Anum_process_uss_bytes                    11
+#define Anum_process_shared_bytes                 12
+#define Anum_process_anon_bytes                   13
+#define Anum_process_page_table_bytes             14
+#define Anum_process_io_wait_seconds              15
+#define Anum_process_io_wait_percent              16
+#define Anum_process_minor_faults_per_sec         17
+#define Anum_process_major_faults_per_sec         18
+#define Anum_process_io_read_bytes_per_sec        19
+#define Anum_process_io_write_bytes_per_sec       20
+#define Anum_process_rchar                        21
+#define Anum_process_wchar                        22
+#define Anum_process_syscr                        23
+#define Anum_process_syscw                        24
+
+/* Macros for process scheduling information */
+#define Natts_cpu_sched_by_process               15
+#define Anum_sched_pid                           0
+#define Anum_sched_name                          1
+#define Anum_sched_processor                     2
+#define Anum_sched_run_time_ns                   3
+#define Anum_sched_run_time_percent              4
+#define Anum_sched_wait_time_ns                  5
+#define Anum_sched_wait_time_percent             6
+#define Anum_sched_timeslices                    7
+#define Anum_sched_timeslices_per_sec            8
+#define Anum_sched_voluntary_ctxt_switches       9
+#define Anum_sched_voluntary_ctxt_switches_per_sec 10
+#define Anum_sched_involuntary_ctxt_switches     11
+#define Anum_sched_involuntary_ctxt_switches_per_sec 12
+#define Anum_sched_migrations                    13
+#define Anum_sched_migrations_per_sec            14
+
+/* Macros for tablespace IO information */
+#define Natts_tablespace_io                      11
+#define Anum_tblspc_name                         0
+#define Anum_tblspc_location                     1
+#define Anum_tblspc_device_name                  2
+#define Anum_tblspc_backing_devices              3
+#define Anum_tblspc_total_space                  4
+#define Anum_tblspc_free_space                   5
+#define Anum_tblspc_reads_per_sec                6
+#define Anum_tblspc_writes_per_sec               7
+#define Anum_tblspc_read_bytes_per_sec           8
+#define Anum_tblspc_write_bytes_per_sec          9
+#define Anum_tblspc_busy_percent                 10
+
+/* Macros for IO queue depth information */
+#define Natts_io_queue_depth                     13
+#define Anum_qd_device_name                      0
+#define Anum_qd_samples                          1
+#define Anum_qd_current_depth                    2
+#define Anum_qd_avg_depth                        3
+#define Anum_qd_max_depth                        4
+#define Anum_qd_depth_0                          5
+#define Anum_qd_depth_1                          6
+#define Anum_qd_depth_2_3                        7
+#define Anum_qd_depth_4_7                        8
+#define Anum_qd_depth_8_15                       9
+#define Anum_qd_depth_16_31                      10
+#define Anum_qd_depth_32_63                      11
+#define Anum_qd_depth_64_plus                    12
+
+/* Macros for disk benchmark */
+#define Natts_disk_benchmark                     11
+#define DISK_BENCHMARK_DEFAULT_FILE_SIZE_MB      64
+#define DISK_BENCHMARK_MAX_FILE_SIZE_MB          1024
+#define DISK_BENCHMARK_DEFAULT_ITERATIONS        100
+#define DISK_BENCHMARK_MAX_ITERATIONS            10000
+#define Anum_bench_test                          0
+#define Anum_bench_directory                     1
+#define Anum_bench_device_name                   2
+#define Anum_bench_operations                    3
+#define Anum_bench_min_latency                   4
+#define Anum_bench_avg_latency                   5
+#define Anum_bench_p50_latency                   6
+#define Anum_bench_p90_latency                   7
+#define Anum_bench_p99_latency                   8
+#define Anum_bench_max_latency                   9
+#define Anum_bench_bytes_per_sec                 10
+
+/* Macros for relation fragmentation */
+#define Natts_relation_fragmentation             6
+#define Anum_frag_fork_name                      0
+#define Anum_frag_segments                       1
+#define Anum_frag_size_bytes                     2
+#define Anum_frag_extents                        3
+#define Anum_frag_avg_extent_bytes               4
+#define Anum_frag_small_extent_percent           5
+
+/* Macros for relation cache residency */
+#define Natts_relation_cache_residency           9
+#define Anum_residency_fork_name                 0
+#define Anum_residency_segments                  1
+#define Anum_residency_size_bytes                2
+#define Anum_residency_cached_bytes              3
+#define Anum_residency_dirty_bytes               4
+#define Anum_residency_writeback_bytes           5
+#define Anum_residency_cached_percent            6
+#define Anum_residency_recently_evicted_bytes    7
+#define Anum_residency_method                    8
+
+/* Macros for database cache residency */
+#define Natts_database_cache_residency           7
+#define Anum_db_residency_relation               0
+#define Anum_db_residency_relfilenode            1
+#define Anum_db_residency_size_bytes             2
+#define Anum_db_residency_cached_bytes           3
+#define Anum_db_residency_dirty_bytes            4
+#define Anum_db_residency_writeback_bytes        5
+#define Anum_db_residency_cached_percent         6
+
+/* Macros for pressure stall information */
+#define Natts_pressure_info                      7
+#define Anum_pressure_resource                   0
+#define Anum_pressure_kind                       1
+#define Anum_pressure_avg10                      2
+#define Anum_pressure_avg60                      3
+#define Anum_pressure_avg300                     4
+#define Anum_pressure_total_stall_us             5
+#define Anum_pressure_stall_percent              6
+
+/* Macros for pressure stall trigger events */
+#define Natts_pressure_events                    10
+#define Anum_psi_event_time                      0
+#define Anum_psi_resource                        1
+#define Anum_psi_trigger                         2
+#define Anum_psi_avg10                           3
+#define Anum_psi_total_stall_us                  4
+#define Anum_psi_process_rank                    5
+#define Anum_psi_pid                             6
+#define Anum_psi_process_name                    7
+#define Anum_psi_process_state                   8
+#define Anum_psi_rss_bytes                       9
+
+/* Macros for directory usage */
+#define Natts_dir_usage                          6
+#define Anum_du_path                             0
+#define Anum_du_depth                            1
+#define Anum_du_size_bytes                       2
+#define Anum_du_allocated_bytes                  3
+#define Anum_du_files                            4
+#define Anum_du_directories                      5
 
 #endif // SYSTEM_STATS_H
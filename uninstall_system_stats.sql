@@ -7,4 +7,30 @@ DROP FUNCTION pg_sys_load_avg_info();
 DROP FUNCTION pg_sys_os_info();
 DROP FUNCTION pg_sys_process_info();
 DROP FUNCTION pg_sys_network_info();
-DROP FUNCTION pg_sys_cpu_memory_by_process();
+DROP FUNCTION pg_sys_cpu_memory_by_process(boolean);
+DROP FUNCTION pg_sys_tablespace_io();
+DROP FUNCTION pg_sys_io_queue_depth();
+DROP FUNCTION pg_sys_disk_benchmark(text, int, int);
+DROP FUNCTION pg_sys_relation_fragmentation(regclass);
+DROP FUNCTION pg_sys_dir_usage(text, int);
+DROP FUNCTION pg_sys_memory_info_ext();
+DROP FUNCTION pg_sys_hugepage_info();
+DROP FUNCTION pg_sys_numa_info();
+DROP FUNCTION pg_sys_numa_placement();
+DROP FUNCTION pg_sys_vmstat();
+DROP FUNCTION pg_sys_kernel_activity();
+DROP FUNCTION pg_sys_writeback_info();
+DROP FUNCTION pg_sys_memory_fragmentation();
+DROP FUNCTION pg_sys_relation_cache_residency(regclass);
+DROP FUNCTION pg_sys_database_cache_residency(int);
+DROP FUNCTION pg_sys_pressure_events();
+DROP FUNCTION pg_sys_pressure_info();
+DROP FUNCTION pg_sys_cpu_usage_per_core();
+DROP FUNCTION pg_sys_cpu_frequency();
+DROP FUNCTION pg_sys_cpu_idle_states();
+DROP FUNCTION pg_sys_cpu_topology();
+DROP FUNCTION pg_sys_interrupts();
+DROP FUNCTION pg_sys_softirqs();
+DROP FUNCTION pg_sys_softnet_stat();
+DROP FUNCTION pg_sys_runqueue_info();
+DROP FUNCTION pg_sys_cpu_sched_by_process();
@@ -192,3 +192,18 @@ void ReadCPUInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
 
 	SysFreeString(query);
 }
+
+void ReadCPUFrequency(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("cpu frequency information is not supported on this platform")));
+}
+
+void ReadCPUIdleStates(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("cpu idle state information is not supported on this platform")));
+}
+
+void ReadCPUTopology(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("cpu topology information is not supported on this platform")));
+}
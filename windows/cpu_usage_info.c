@@ -159,6 +159,7 @@ void ReadCPUUsageStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc)
 			nulls[Anum_io_completion] = true;
 			nulls[Anum_servicing_irq] = true;
 			nulls[Anum_servicing_softirq] = true;
+			nulls[Anum_steal_time] = true;
 
 			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
 
@@ -175,3 +176,23 @@ void ReadCPUUsageStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc)
 
 	SysFreeString(query);
 }
+
+void ReadKernelActivity(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("kernel activity information is not supported on this platform")));
+}
+
+void ReadCPUUsagePerCore(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("per core cpu usage information is not supported on this platform")));
+}
+
+void ReadInterrupts(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("interrupt information is not supported on this platform")));
+}
+
+void ReadSoftirqs(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("softirq information is not supported on this platform")));
+}
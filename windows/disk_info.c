@@ -161,3 +161,30 @@ void ReadDiskInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
 
 	SysFreeString(query);
 }
+
+void RunDiskBenchmark(Tuplestorestate *tupstore, TupleDesc tupdesc,
+		const char *directory, int file_size_mb, int iterations)
+{
+	ereport(DEBUG1, (errmsg("disk benchmark is not supported on this platform")));
+}
+
+void ReadRelationFragmentation(Tuplestorestate *tupstore, TupleDesc tupdesc, Oid relid)
+{
+	ereport(DEBUG1, (errmsg("relation fragmentation is not supported on this platform")));
+}
+
+void ReadRelationCacheResidency(Tuplestorestate *tupstore, TupleDesc tupdesc, Oid relid)
+{
+	ereport(DEBUG1, (errmsg("relation cache residency is not supported on this platform")));
+}
+
+void ReadDatabaseCacheResidency(Tuplestorestate *tupstore, TupleDesc tupdesc, int max_relations)
+{
+	ereport(DEBUG1, (errmsg("database cache residency is not supported on this platform")));
+}
+
+void ReadDirectoryUsage(Tuplestorestate *tupstore, TupleDesc tupdesc,
+		const char *path, int max_depth)
+{
+	ereport(DEBUG1, (errmsg("directory usage is not supported on this platform")));
+}
@@ -88,3 +88,38 @@ void ReadMemoryInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
 
 	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
 }
+
+void ReadMemoryInformationExt(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("extended memory information is not supported on this platform")));
+}
+
+void ReadHugePageInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("huge page information is not supported on this platform")));
+}
+
+void ReadNumaInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("NUMA information is not supported on this platform")));
+}
+
+void ReadNumaPlacement(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("NUMA placement is not supported on this platform")));
+}
+
+void ReadVMStatistics(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("virtual memory statistics are not supported on this platform")));
+}
+
+void ReadWritebackInformation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("writeback information is not supported on this platform")));
+}
+
+void ReadMemoryFragmentation(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("memory fragmentation information is not supported on this platform")));
+}
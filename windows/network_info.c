@@ -210,3 +210,8 @@ void ReadNetworkInformations(Tuplestorestate *tupstore, TupleDesc tupdesc)
 		ip_rows = NULL;
 	}
 }
+
+void ReadSoftnetStat(Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	ereport(DEBUG1, (errmsg("softnet information is not supported on this platform")));
+}